@@ -0,0 +1,177 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef ALPHABET_HPP
+#define ALPHABET_HPP
+
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace susml::alphabet {
+
+// Partition of the events into classes of events that behave the same in every state (like the
+// character classes of a lexer generator). Class 0 holds all events without any transition.
+template <typename EventT, typename ClassT = std::uint16_t>
+struct EventClasses {
+  using Event   = EventT;
+  using ClassId = ClassT;
+
+  static_assert(isIndexable<Event>(), "Event classes require an integral or enum Event type.");
+
+  std::vector<ClassId> classOf;        // indexed by toIndex(event)
+  std::vector<Event>   representative; // an event of each class (except class 0)
+  std::size_t          numClasses = 1;
+
+  constexpr ClassId classify(const Event &event) const {
+    const auto e = toIndex(event);
+    return (e < classOf.size()) ? classOf[e] : ClassId{0};
+  }
+};
+
+// Computes the event classes of a guardless machine given its transitions, such that two events
+// are in the same class if, in every state, they lead to the same target with the same action
+// (actions are considered the same if they compare equal, see vectorbased::detail). Returns
+// only class 0 (i.e. nothing) if there are more classes than fit in ClassT, or if the event
+// values are too sparse for a table.
+template <typename ClassT = std::uint16_t, typename Transition>
+EventClasses<typename Transition::Event, ClassT>
+classifyEvents(const std::vector<Transition> &transitions) {
+  using Event = typename Transition::Event;
+
+  static_assert(!Transition::HasGuard(), "Event classes require guardless transitions.");
+  static_assert(isIndexable<typename Transition::State>(),
+                "Event classes require an integral or enum State type.");
+
+  EventClasses<Event, ClassT> result;
+  if (transitions.empty()) { return result; }
+
+  std::size_t maxEvent = 0;
+  for (const auto &t : transitions) {
+    maxEvent = std::max(maxEvent, toIndex(t.event));
+  }
+  if (maxEvent >= 8 * transitions.size() + 256) { return result; }
+
+  // the behavior of an event is the list of (source, target, action class) of the transitions it
+  // takes, in the order of the transitions. Shadowed transitions do not count, as they are never
+  // taken.
+  const auto actionClasses = vectorbased::detail::classifyActions(transitions);
+
+  std::set<std::pair<std::size_t, std::size_t>> isTaken; // (source, event) already taken
+  std::vector<std::vector<std::size_t>>         behavior(maxEvent + 1);
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    const auto s = toIndex(transitions[i].source);
+    const auto e = toIndex(transitions[i].event);
+    if (!isTaken.emplace(s, e).second) { continue; }
+    behavior[e].push_back(s);
+    behavior[e].push_back(toIndex(transitions[i].target));
+    behavior[e].push_back(actionClasses[i]);
+  }
+
+  std::map<std::vector<std::size_t>, std::size_t> classes{{{}, 0}};
+  result.classOf.assign(maxEvent + 1, 0);
+  result.representative.resize(1);
+  for (std::size_t e = 0; e <= maxEvent; e++) {
+    const auto [found, isNew] = classes.emplace(std::move(behavior[e]), classes.size());
+    if (isNew) {
+      if (found->second > std::numeric_limits<ClassT>::max()) { return {}; }
+      result.representative.push_back(static_cast<Event>(e));
+    }
+    result.classOf[e] = static_cast<ClassT>(found->second);
+  }
+  result.numClasses = classes.size();
+  return result;
+}
+
+// Table-driven state machine, with a row per state and a column per event class. Each cell holds
+// the (index + 1 of the) transition to take, or 0 if there is none. Falls back to searching the
+// transitions when the events cannot be classified or the states are too sparse for a table.
+template <typename TransitionT, typename ClassT = std::uint16_t>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  State                       currentState;
+  std::vector<Transition>     transitions;
+  EventClasses<Event, ClassT> eventClasses;
+  std::vector<std::uint32_t>  table;
+  std::size_t                 numStates = 0;
+
+  StateMachine(const State &initialState, const std::vector<Transition> &transitions)
+      : currentState(initialState),
+        transitions(transitions),
+        eventClasses(classifyEvents<ClassT>(this->transitions)) {
+    if (eventClasses.numClasses <= 1) { return; }
+
+    std::size_t maxState = 0;
+    for (const auto &t : this->transitions) {
+      maxState = std::max({maxState, toIndex(t.source), toIndex(t.target)});
+    }
+    if (maxState >= 8 * this->transitions.size() + 64) {
+      eventClasses = {};
+      return;
+    }
+
+    numStates = maxState + 1;
+    table.assign(numStates * eventClasses.numClasses, 0);
+    for (std::size_t i = this->transitions.size(); i-- > 0;) { // earlier transitions win
+      const auto &t = this->transitions[i];
+      const auto  c = eventClasses.classify(t.event);
+      if (eventClasses.representative[c] == t.event) {
+        table[toIndex(t.source) * eventClasses.numClasses + c] = static_cast<std::uint32_t>(i + 1);
+      }
+    }
+  }
+
+  constexpr bool isCompressed() const { return !table.empty(); }
+
+  // memory used by the lookup structures, in bytes
+  constexpr std::size_t tableSize() const {
+    return table.size() * sizeof(std::uint32_t) + eventClasses.classOf.size() * sizeof(ClassT);
+  }
+
+  constexpr void trigger(const Event &event) {
+    if (!isCompressed()) {
+      for (auto &t : transitions) {
+        if (t.source == currentState && t.event == event) {
+          take(t);
+          return;
+        }
+      }
+      return;
+    }
+
+    const auto s = toIndex(currentState);
+    if (s >= numStates) { return; }
+    const auto i = table[s * eventClasses.numClasses + eventClasses.classify(event)];
+    if (i != 0) { take(transitions[i - 1]); }
+  }
+
+  // helper functions
+  constexpr void take(Transition &t) {
+    if constexpr (Transition::HasAction()) { t.action(); }
+    currentState = t.target;
+  }
+};
+
+} // namespace susml::alphabet
+
+#endif
@@ -0,0 +1,207 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef BYTESTREAM_HPP
+#define BYTESTREAM_HPP
+
+#include "common.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace susml::bytestream {
+
+constexpr std::size_t NumBytes = 256;
+
+// A state may skip ahead over all bytes that keep it in the same state without an action, as long
+// as there are at most MaxNeedles bytes that do something else.
+constexpr std::size_t MaxNeedles = 4;
+
+struct Skip {
+  static constexpr std::uint8_t Disabled = 0xFF;
+
+  std::uint8_t                          numNeedles = Disabled;
+  std::array<unsigned char, MaxNeedles> needles{};
+
+  constexpr bool isEnabled() const { return numNeedles != Disabled; }
+};
+
+// Returns the offset of the first byte in data[0..size) that is one of the skip's needles, or size
+// if there is none. Scans 16 bytes at a time with SSE2 where available.
+inline std::size_t findNeedle(const unsigned char *data, std::size_t size, const Skip &skip) {
+  if (skip.numNeedles == 0) { return size; }
+  if (skip.numNeedles == 1) {
+    const void *found = std::memchr(data, skip.needles[0], size);
+    return (found == nullptr) ? size : static_cast<const unsigned char *>(found) - data;
+  }
+
+  std::size_t i = 0;
+#if defined(__SSE2__)
+  __m128i needles[MaxNeedles];
+  for (std::size_t n = 0; n < skip.numNeedles; n++) {
+    needles[n] = _mm_set1_epi8(static_cast<char>(skip.needles[n]));
+  }
+  for (; i + 16 <= size; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i       hits  = _mm_cmpeq_epi8(block, needles[0]);
+    for (std::size_t n = 1; n < skip.numNeedles; n++) {
+      hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, needles[n]));
+    }
+    const auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+    if (mask != 0) { return i + static_cast<std::size_t>(__builtin_ctz(mask)); }
+  }
+#endif
+  for (; i < size; i++) {
+    for (std::size_t n = 0; n < skip.numNeedles; n++) {
+      if (data[i] == skip.needles[n]) { return i; }
+    }
+  }
+  return size;
+}
+
+// Byte-alphabet state machine that consumes whole buffers at a time. Each state has a row of 256
+// cells (one per byte value) holding the next state and the (index + 1 of the) transition whose
+// action to fire, or 0 if there is none. Bytes without a transition leave the state as is.
+//
+// When all but a few bytes keep a state where it is without firing an action (e.g. the body of a
+// quoted string, or of a comment), the machine skips ahead to the next of those few bytes using
+// memchr or SSE2 rather than looking up every byte.
+//
+// Requires guardless transitions and a one-byte integral or enum Event type (char, unsigned char,
+// std::uint8_t, ...). States are interned to dense ids, so the State type needs std::hash.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  static_assert(!Transition::HasGuard(), "Byte stream machines require guardless transitions.");
+  static_assert(isIndexable<Event>() && sizeof(Event) == 1,
+                "Byte stream machines require a one-byte integral or enum Event type.");
+
+  State                      currentState;
+  std::uint32_t              currentId = 0;
+  std::size_t                position  = 0; // number of bytes consumed so far
+  std::vector<Transition>    transitions;
+  std::vector<State>         states;  // indexed by state id
+  std::vector<std::uint32_t> targets; // [id * NumBytes + byte]
+  std::vector<std::uint32_t> fired;   // [id * NumBytes + byte], transition index + 1, or 0
+  std::vector<Skip>          skips;   // indexed by state id
+
+  StateMachine(const State &initialState, const std::vector<Transition> &transitions)
+      : currentState(initialState), transitions(transitions) {
+    std::unordered_map<State, std::uint32_t> stateIds;
+    auto intern = [&](const State &s) {
+      const auto [found, isNew] = stateIds.emplace(s, static_cast<std::uint32_t>(states.size()));
+      if (isNew) {
+        states.push_back(s);
+        for (std::size_t b = 0; b < NumBytes; b++) {
+          targets.push_back(found->second); // no transition: stay
+        }
+        fired.resize(targets.size(), 0);
+      }
+      return found->second;
+    };
+    currentId = intern(initialState);
+
+    std::vector<bool> isSet;
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      const auto &t    = transitions[i];
+      const auto  s    = intern(t.source);
+      const auto  next = intern(t.target);
+      const auto  cell = s * NumBytes + byteOf(t.event);
+      isSet.resize(targets.size(), false);
+      if (isSet[cell]) { continue; } // earlier transitions win
+      isSet[cell]   = true;
+      targets[cell] = next;
+      if constexpr (Transition::HasAction()) { fired[cell] = static_cast<std::uint32_t>(i + 1); }
+    }
+
+    skips.resize(states.size());
+    for (std::uint32_t s = 0; s < states.size(); s++) {
+      Skip skip{0, {}};
+      for (std::size_t b = 0; b < NumBytes && skip.isEnabled(); b++) {
+        const auto cell = s * NumBytes + b;
+        if (targets[cell] == s && fired[cell] == 0) { continue; }
+        if (skip.numNeedles == MaxNeedles) {
+          skip.numNeedles = Skip::Disabled;
+        } else {
+          skip.needles[skip.numNeedles++] = static_cast<unsigned char>(b);
+        }
+      }
+      skips[s] = skip;
+    }
+  }
+
+  // Consumes size bytes, firing the action of each transition taken.
+  void consume(const void *data, std::size_t size) {
+    consume(data, size, [](Transition &t, std::size_t) {
+      if constexpr (Transition::HasAction()) { t.action(); }
+    });
+  }
+
+  // Consumes size bytes, calling onAction(transition, offset) rather than the action itself for
+  // each transition with an action that is taken, with offset the position of the byte that
+  // triggered it in the stream (counting from the first byte ever consumed). As in the other
+  // engines, actions see the machine in the source state of their transition, with position at
+  // that byte; the state is only kept in a local in between.
+  template <typename OnAction>
+  void consume(const void *data, std::size_t size, OnAction &&onAction) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    const auto  start = position;
+
+    std::uint32_t s = currentId;
+    for (std::size_t i = 0; i < size; i++) {
+      if (skips[s].isEnabled()) {
+        i += findNeedle(bytes + i, size - i, skips[s]);
+        if (i == size) { break; }
+      }
+      const auto cell = s * NumBytes + bytes[i];
+      if (fired[cell] != 0) {
+        setState(s);
+        position = start + i;
+        onAction(transitions[fired[cell] - 1], position);
+      }
+      s = targets[cell];
+    }
+    setState(s);
+    position = start + size;
+  }
+
+  void trigger(const Event &event) {
+    const auto byte = static_cast<unsigned char>(byteOf(event));
+    consume(&byte, 1);
+  }
+
+  // helper functions
+  void setState(std::uint32_t id) {
+    if (id == currentId) { return; }
+    currentId    = id;
+    currentState = states[id];
+  }
+
+  static constexpr std::size_t byteOf(const Event &event) {
+    return static_cast<unsigned char>(event);
+  }
+};
+
+} // namespace susml::bytestream
+
+#endif
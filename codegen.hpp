@@ -0,0 +1,299 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CODEGEN_HPP
+#define CODEGEN_HPP
+
+#include "common.hpp"
+#include "loader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace susml::codegen {
+
+// Guard or action that is only a name, for definitions that are turned into code rather than run.
+// The loader makes these from the guard and action names it reads.
+template <typename R>
+struct Hook {
+  std::string name;
+
+  Hook() = default;
+  explicit Hook(std::string_view name) : name(name) {}
+
+  R operator()() const { return R(); }
+};
+
+using Loader = loader::Loader<Hook<bool>, Hook<void>>;
+
+// Machine definition by name: the names of states, events, guards and actions, and transitions
+// between them by id. Empty guard or action names stand for none.
+struct Definition {
+  struct Transition {
+    std::uint32_t source;
+    std::uint32_t target;
+    std::uint32_t event;
+    std::string   guard;
+    std::string   action;
+  };
+
+  std::vector<std::string> states; // indexed by id
+  std::vector<std::string> events; // indexed by id
+  std::uint32_t            initialState = 0;
+  std::vector<Transition>  transitions; // in order of priority
+};
+
+// Takes the definition read by a loader. The names, transitions and initial state are moved out
+// of the loader, which is left as if nothing had been read (with its registered guards and
+// actions), so it can be reused to load another definition.
+inline Definition fromLoader(Loader &&loader) {
+  Definition definition;
+  definition.states       = std::move(loader.states.values);
+  definition.events       = std::move(loader.events.values);
+  definition.initialState = loader.initial();
+  definition.transitions.reserve(loader.transitions.size());
+  for (auto &t : loader.transitions) {
+    definition.transitions.push_back(
+        {t.source, t.target, t.event, std::move(t.guard.name), std::move(t.action.name)});
+  }
+  loader.states       = {};
+  loader.events       = {};
+  loader.stateNames   = {};
+  loader.eventNames   = {};
+  loader.transitions  = {};
+  loader.bySource     = {};
+  loader.initialState = loader::NoId;
+  return definition;
+}
+
+// Names the states, events, guards and actions of transitions of a vector-based machine (or any
+// other vector of transitions), e.g. of a definition that is built in code. stateName(state) and
+// eventName(event) return names, guardName(transition) and actionName(transition) return a name or
+// an empty string for none. States and events with the same name are the same.
+template <typename Transition,
+          typename StateName,
+          typename EventName,
+          typename GuardName,
+          typename ActionName>
+Definition fromTransitions(const typename Transition::State &initialState,
+                           const std::vector<Transition> &   transitions,
+                           StateName &&                      stateName,
+                           EventName &&                      eventName,
+                           GuardName &&                      guardName,
+                           ActionName &&                     actionName) {
+  Definition                           definition;
+  std::map<std::string, std::uint32_t> stateIds;
+  std::map<std::string, std::uint32_t> eventIds;
+  auto intern = [](auto &ids, auto &names, std::string name) {
+    const auto [found, isNew] = ids.emplace(name, static_cast<std::uint32_t>(names.size()));
+    if (isNew) { names.push_back(std::move(name)); }
+    return found->second;
+  };
+
+  definition.initialState = intern(stateIds, definition.states, stateName(initialState));
+  for (const auto &t : transitions) {
+    definition.transitions.push_back({intern(stateIds, definition.states, stateName(t.source)),
+                                      intern(stateIds, definition.states, stateName(t.target)),
+                                      intern(eventIds, definition.events, eventName(t.event)),
+                                      guardName(t),
+                                      actionName(t)});
+  }
+  return definition;
+}
+
+// Definitions that are built in code, registered by name (see Registration) such that the
+// susml-codegen executable, when linked with the file registering them, can generate code for them.
+inline std::map<std::string, std::function<Definition()>> &registry() {
+  static std::map<std::string, std::function<Definition()>> definitions;
+  return definitions;
+}
+
+// Registers a definition on construction, for use as a global in the file defining it.
+struct Registration {
+  Registration(const std::string &name, std::function<Definition()> make) {
+    registry()[name] = std::move(make);
+  }
+};
+
+namespace detail {
+inline bool isKeyword(const std::string &word) {
+  static const std::unordered_set<std::string> keywords = {
+      "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char",
+      "char16_t", "char32_t", "class", "const", "const_cast", "constexpr", "continue", "decltype",
+      "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export",
+      "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+      "namespace", "new", "noexcept", "not", "nullptr", "operator", "or", "private", "protected",
+      "public", "register", "reinterpret_cast", "return", "short", "signed", "sizeof", "static",
+      "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local",
+      "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using",
+      "virtual", "void", "volatile", "wchar_t", "while", "xor"};
+  return keywords.count(word) != 0;
+}
+
+// Turns a name into a C++ identifier, replacing the characters that cannot appear in one.
+inline std::string toIdentifier(const std::string &name) {
+  std::string identifier;
+  for (const char c : name) {
+    const bool isValid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                         (c >= '0' && c <= '9') || c == '_';
+    identifier += isValid ? c : '_';
+  }
+  if (identifier.empty() || (identifier[0] >= '0' && identifier[0] <= '9')) {
+    identifier.insert(0, "_");
+  }
+  if (isKeyword(identifier)) { identifier += '_'; }
+  return identifier;
+}
+
+// Identifiers for a list of names, made unique by appending a number where needed.
+inline std::vector<std::string> toIdentifiers(const std::vector<std::string> &names) {
+  std::vector<std::string>        identifiers;
+  std::unordered_set<std::string> isTaken;
+  for (const auto &name : names) {
+    auto identifier = toIdentifier(name);
+    for (std::size_t n = 2; isTaken.count(identifier) != 0; n++) {
+      identifier = toIdentifier(name) + "_" + std::to_string(n);
+    }
+    isTaken.insert(identifier);
+    identifiers.push_back(std::move(identifier));
+  }
+  return identifiers;
+}
+} // namespace detail
+
+// Writes a standalone header with the definition as handcrafted code, in namespace ns: enums State
+// and Event, the initialState, and a trigger(currentState, event, hooks) with a switch on the
+// state and a switch on the event within it, as in the handcrafted contenders of the benchmarks.
+// Guards and actions are calls hooks.name(), on a hooks object of any type, so they are inlined
+// like handwritten calls. Guard and action names share the members of the hooks object, and are
+// made unique identifiers together (listed in a comment if that changed them). trigger() returns
+// whether a transition was taken. Definitions without guards and actions also get a
+// trigger(currentState, event) without hooks.
+// The definition must have at least one state.
+inline void generate(std::ostream &out, const Definition &definition, const std::string &ns) {
+  const auto states = detail::toIdentifiers(definition.states);
+  const auto events = detail::toIdentifiers(definition.events);
+
+  std::vector<std::vector<std::size_t>>        bySource(states.size());
+  std::vector<std::string>                     hookNames; // in order of first mention
+  std::unordered_map<std::string, std::size_t> hookIds;   // index in hookNames, by name
+  for (std::size_t i = 0; i < definition.transitions.size(); i++) {
+    const auto &t = definition.transitions[i];
+    bySource[t.source].push_back(i);
+    for (const auto *name : {&t.guard, &t.action}) {
+      if (!name->empty() && hookIds.emplace(*name, hookNames.size()).second) {
+        hookNames.push_back(*name);
+      }
+    }
+  }
+  const bool hasHooks    = !hookNames.empty();
+  const auto identifiers = detail::toIdentifiers(hookNames);
+  const auto hook        = [&](const std::string &name) {
+    return identifiers[hookIds.find(name)->second];
+  };
+
+  std::string includeGuard = "SUSML_GENERATED_" + detail::toIdentifier(ns) + "_HPP";
+  std::transform(includeGuard.begin(), includeGuard.end(), includeGuard.begin(), [](char c) {
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+  });
+
+  out << "// Generated by susml-codegen, do not edit.\n\n";
+  out << "#ifndef " << includeGuard << "\n#define " << includeGuard << "\n\n";
+  out << "#include <cstdint>\n\n";
+  bool isAnyRenamed = false;
+  for (std::size_t h = 0; h < hookNames.size(); h++) {
+    if (identifiers[h] == hookNames[h]) { continue; }
+    out << "// hook \"" << hookNames[h] << "\" is hooks." << identifiers[h] << "()\n";
+    isAnyRenamed = true;
+  }
+  if (isAnyRenamed) { out << "\n"; }
+  out << "namespace " << ns << " {\n\n";
+
+  auto writeEnum = [&](const char *name, const std::vector<std::string> &values) {
+    out << "enum class " << name << " : std::uint32_t {\n";
+    for (const auto &v : values) {
+      out << "  " << v << ",\n";
+    }
+    out << "};\n\n";
+  };
+  writeEnum("State", states);
+  writeEnum("Event", events);
+  out << "constexpr State initialState = State::" << states[definition.initialState] << ";\n\n";
+
+  out << "template <typename Hooks>\n";
+  out << "inline bool trigger(State &currentState, Event event, Hooks &hooks) {\n";
+  out << "  static_cast<void>(hooks);\n";
+  out << "  switch (currentState) {\n";
+  for (std::size_t s = 0; s < states.size(); s++) {
+    if (bySource[s].empty()) { continue; }
+    out << "  case State::" << states[s] << ":\n";
+    out << "    switch (event) {\n";
+
+    // the transitions on each event, in order of priority
+    std::vector<std::uint32_t> eventOrder;
+    for (const auto i : bySource[s]) {
+      const auto e = definition.transitions[i].event;
+      if (std::find(eventOrder.begin(), eventOrder.end(), e) == eventOrder.end()) {
+        eventOrder.push_back(e);
+      }
+    }
+    for (const auto e : eventOrder) {
+      out << "    case Event::" << events[e] << ":\n";
+      bool isGuarded = true;
+      for (const auto i : bySource[s]) {
+        const auto &t = definition.transitions[i];
+        if (t.event != e) { continue; }
+        isGuarded                = !t.guard.empty();
+        const std::string indent = isGuarded ? "        " : "      ";
+        if (isGuarded) { out << "      if (hooks." << hook(t.guard) << "()) {\n"; }
+        if (!t.action.empty()) { out << indent << "hooks." << hook(t.action) << "();\n"; }
+        out << indent << "currentState = State::" << states[t.target] << ";\n";
+        out << indent << "return true;\n";
+        if (!isGuarded) { break; } // the transitions after it are never taken
+        out << "      }\n";
+      }
+      if (isGuarded) { out << "      break;\n"; }
+    }
+    out << "    default:\n";
+    out << "      break;\n";
+    out << "    }\n";
+    out << "    break;\n";
+  }
+  out << "  default:\n";
+  out << "    break;\n";
+  out << "  }\n";
+  out << "  return false;\n";
+  out << "}\n";
+
+  if (!hasHooks) {
+    out << "\nstruct NoHooks {};\n\n";
+    out << "inline bool trigger(State &currentState, Event event) {\n";
+    out << "  NoHooks hooks;\n";
+    out << "  return trigger(currentState, event, hooks);\n";
+    out << "}\n";
+  }
+
+  out << "\n} // namespace " << ns << "\n\n#endif\n";
+}
+
+} // namespace susml::codegen
+
+#endif
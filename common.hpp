@@ -14,7 +14,9 @@
 #ifndef COMMON_HPP
 #define COMMON_HPP
 
+#include <cstddef>
 #include <type_traits>
+#include <utility>
 
 namespace susml {
 struct NoneType {
@@ -27,15 +29,86 @@ constexpr bool isNoneType() {
   return std::is_same<T, NoneType>::value || std::is_same<T, const NoneType>::value;
 }
 
-template <typename StateT, typename EventT, typename GuardT = NoneType, typename ActionT = NoneType>
+// States and events of integral or enum type can be used directly as an index into a table.
+template <typename T>
+constexpr bool isIndexable() {
+  return std::is_integral<T>::value || std::is_enum<T>::value;
+}
+
+template <typename T>
+constexpr std::size_t toIndex(const T &value) {
+  static_assert(isIndexable<T>(), "Only integral and enum types can be used as index");
+  return static_cast<std::size_t>(value);
+}
+
+// Event type of time-triggered transitions: the transition is taken once the machine has been in
+// its source state for (at least) the given delay. See timed.hpp.
+template <typename DurationT>
+struct Timeout {
+  using Duration = DurationT;
+
+  Duration delay;
+
+  constexpr bool operator==(const Timeout &other) const { return delay == other.delay; }
+  constexpr bool operator!=(const Timeout &other) const { return delay != other.delay; }
+};
+
+// Applies Trait (std::is_invocable or std::invoke_result) to f and the arguments its calls take:
+// a Context & (if there is a context) followed by a const Payload & (if there is a payload).
+template <template <typename...> class Trait, typename F, typename Payload, typename Context>
+struct WithArguments {
+  using WithPayload = typename std::conditional<isNoneType<Context>(),
+                                                Trait<F, const Payload &>,
+                                                Trait<F, Context &, const Payload &>>::type;
+  using WithoutPayload =
+      typename std::conditional<isNoneType<Context>(), Trait<F>, Trait<F, Context &>>::type;
+  using type =
+      typename std::conditional<isNoneType<Payload>(), WithoutPayload, WithPayload>::type;
+};
+
+template <typename F, typename Payload, typename Context = NoneType>
+using IsCallable = typename WithArguments<std::is_invocable, F, Payload, Context>::type;
+template <typename F, typename Payload, typename Context = NoneType>
+using CallResult = typename WithArguments<std::invoke_result, F, Payload, Context>::type;
+
+// Whether a guard or action stands for none, so that a guard passes and an action does nothing:
+// a null function pointer, or an empty std::function or fixed::InlineFunction (anything with an
+// explicit operator bool). Transition::isAllowed and fire check this, as do engines that call
+// guards and actions themselves.
+template <typename F>
+constexpr bool isNull(const F &f) {
+  if constexpr (std::is_pointer<F>::value) {
+    return f == nullptr;
+  } else if constexpr (std::is_constructible<bool, const F &>::value) {
+    return !static_cast<bool>(f);
+  } else {
+    static_cast<void>(f);
+    return false;
+  }
+}
+
+// Transitions with a Payload type are triggered with trigger(event, payload), and their guard and
+// action take the payload as argument: bool(const Payload &) and void(const Payload &).
+// Transitions with a Context type run against a context supplied by the machine (see context.hpp),
+// and their guard and action take it as first argument: bool(Context &) and void(Context &).
+template <typename StateT,
+          typename EventT,
+          typename GuardT   = NoneType,
+          typename ActionT  = NoneType,
+          typename PayloadT = NoneType,
+          typename ContextT = NoneType>
 struct Transition {
-  using State  = StateT;
-  using Event  = EventT;
-  using Guard  = GuardT;
-  using Action = ActionT;
+  using State   = StateT;
+  using Event   = EventT;
+  using Guard   = GuardT;
+  using Action  = ActionT;
+  using Payload = PayloadT;
+  using Context = ContextT;
 
   static constexpr bool HasGuard() { return !isNoneType<Guard>(); }
   static constexpr bool HasAction() { return !isNoneType<Action>(); }
+  static constexpr bool HasPayload() { return !isNoneType<Payload>(); }
+  static constexpr bool HasContext() { return !isNoneType<Context>(); }
 
   State  source;
   State  target;
@@ -43,22 +116,76 @@ struct Transition {
   Guard  guard;
   Action action;
 
-  constexpr Transition(
-      const State &s, const State &t, const Event &e, const Guard &g = {}, const Action &a = {})
-      : source(s), target(t), event(e), guard(g), action(a) {
+  // The guard and action are forwarded, so temporaries (e.g. a std::function with large captures)
+  // are moved into the transition rather than copied.
+  template <typename G = Guard,
+            typename A = Action,
+            typename   = typename std::enable_if<std::is_constructible<Guard, G &&>::value &&
+                                               std::is_constructible<Action, A &&>::value>::type>
+  constexpr Transition(const State &s, const State &t, const Event &e, G &&g = {}, A &&a = {})
+      : source(s), target(t), event(e), guard(std::forward<G>(g)), action(std::forward<A>(a)) {
     if constexpr (HasGuard()) {
-      static_assert(std::is_invocable<Guard>::value, "Guard should be invocable");
-      static_assert(std::is_same<typename std::invoke_result<Guard>::type, bool>::value,
+      static_assert(IsCallable<Guard, Payload, Context>::value, "Guard should be invocable");
+      static_assert(std::is_same<typename CallResult<Guard, Payload, Context>::type, bool>::value,
                     "Guard should return bool.");
     }
     if constexpr (HasAction()) {
-      static_assert(std::is_invocable<Action>::value, "Action should be invocable");
-      static_assert(std::is_same<typename std::invoke_result<Action>::type, void>::value,
+      static_assert(IsCallable<Action, Payload, Context>::value, "Action should be invocable");
+      static_assert(std::is_same<typename CallResult<Action, Payload, Context>::type, void>::value,
                     "Action should return void.");
     }
   }
+
+  // Evaluates the guard, passing the payload if this transition takes one. Transitions without a
+  // payload ignore it, so they can be triggered along with transitions that do take it. A null
+  // guard passes and a null action does nothing (see isNull).
+  template <typename P>
+  constexpr bool isAllowed(const P &payload) {
+    NoneType none;
+    return isAllowed(none, payload);
+  }
+
+  template <typename C, typename P>
+  constexpr bool isAllowed(C &context, const P &payload) {
+    return isNull(guard) || call(guard, context, payload);
+  }
+
+  template <typename P>
+  constexpr void fire(const P &payload) {
+    NoneType none;
+    fire(none, payload);
+  }
+
+  template <typename C, typename P>
+  constexpr void fire(C &context, const P &payload) {
+    if (!isNull(action)) { call(action, context, payload); }
+  }
+
+  // helper functions
+  template <typename F, typename C, typename P>
+  static constexpr decltype(auto) call(F &f, C &context, const P &payload) {
+    static_cast<void>(context);
+    static_cast<void>(payload);
+    if constexpr (HasContext() && HasPayload()) {
+      return f(context, payload);
+    } else if constexpr (HasContext()) {
+      return f(context);
+    } else if constexpr (HasPayload()) {
+      return f(payload);
+    } else {
+      return f();
+    }
+  }
 };
 
+// deduce the guard and action types from the arguments, which the forwarding constructor cannot do
+template <typename State, typename Event>
+Transition(State, State, Event) -> Transition<State, Event>;
+template <typename State, typename Event, typename Guard>
+Transition(State, State, Event, Guard) -> Transition<State, Event, Guard>;
+template <typename State, typename Event, typename Guard, typename Action>
+Transition(State, State, Event, Guard, Action) -> Transition<State, Event, Guard, Action>;
+
 } // namespace susml
 
 #endif
@@ -0,0 +1,120 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef CONTEXT_HPP
+#define CONTEXT_HPP
+
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include <type_traits>
+#include <vector>
+
+namespace susml::context {
+
+// Guards and actions that get everything they need from the context they are passed, rather than
+// from captured references, can be plain function pointers (captureless lambdas convert to them).
+template <typename Context>
+using Guard = bool (*)(Context &);
+template <typename Context>
+using Action = void (*)(Context &);
+
+template <typename State, typename Event, typename Context>
+using Transition =
+    susml::Transition<State, Event, Guard<Context>, Action<Context>, NoneType, Context>;
+
+// The transitions of a machine, built once and shared by any number of StateMachine instances,
+// each with their own context and current state.
+template <typename TransitionT>
+struct Definition {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  static_assert(Transition::HasContext(), "Transitions must have a Context type.");
+
+  std::vector<Transition>              transitions;
+  vectorbased::EventMask<State, Event> acceptedEvents;
+
+  explicit Definition(const std::vector<Transition> &transitions)
+      : transitions(transitions), acceptedEvents(this->transitions) {}
+};
+
+// Takes the first transition of definition (anything with transitions and acceptedEvents) out of
+// currentState on event whose guard passes against context, and returns whether there was one.
+// Shared with the instances in hotswap.hpp, which run a definition that may change under them.
+template <typename DefinitionT, typename Context, typename State, typename Event, typename Payload>
+constexpr bool take(const DefinitionT &definition,
+                    Context &          context,
+                    State &            currentState,
+                    const Event &      event,
+                    const Payload &    payload) {
+  using Transition = typename DefinitionT::Transition;
+
+  if (!definition.acceptedEvents.accepts(currentState, event)) { return false; }
+
+  for (const auto &t : definition.transitions) {
+    if (!(t.source == currentState && t.event == event)) { continue; }
+    if constexpr (Transition::HasGuard()) {
+      if (!isNull(t.guard) && !Transition::call(t.guard, context, payload)) { continue; }
+    }
+    if constexpr (Transition::HasAction()) {
+      if (!isNull(t.action)) { Transition::call(t.action, context, payload); }
+    }
+    currentState = t.target;
+    return true;
+  }
+  return false;
+}
+
+// Vector-based state machine that runs the transitions of a shared Definition against its own
+// context: guards and actions are called as f(context), or f(context, payload) for transitions
+// with a payload. Null guards and actions (see isNull in common.hpp) always pass and do nothing,
+// respectively, so transitions with and without them have the same type.
+//
+// The definition and the context must outlive the machine.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+  using Context    = typename Transition::Context;
+
+  const Definition<Transition> *definition;
+  Context *                     context;
+  State                         currentState;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  StateMachine(const Definition<Transition> &definition,
+               Context &                     context,
+               const State &                 initialState)
+      : definition(&definition), context(&context), currentState(initialState) {}
+
+  constexpr void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  constexpr void trigger(const Event &event, const Payload &payload) {
+    if (!take(*definition, *context, currentState, event, payload)) { numUnhandledEvents++; }
+  }
+};
+
+} // namespace susml::context
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "common.hpp"
 #include <type_traits>
+#include <utility>
 
 namespace susml::factory {
 template <typename StateT  = NoneType,
@@ -39,52 +40,78 @@ struct PartialTransition {
   Guard  guard;
   Action action;
 
+  // Every step has an overload for rvalues, which moves the guard and action into the next step
+  // rather than copying them, so a chain like From(a).To(b).On(e).If(g).Do(f).make() copies a
+  // (heavy) guard or action at most once.
   template <typename NewState>
-  constexpr auto From(NewState newSource) const {
-    if constexpr (std::is_same<State, NewState>::value) {
-      // we already have a target (of the same type), keep it
-      return PartialTransition{newSource, target, event, guard, action};
-    }
-    // we need to set a new target, we will create a self-loop
-    return PartialTransition<NewState, Event, Guard, Action>{
-        newSource, newSource, event, guard, action};
+  constexpr auto From(NewState newSource) const & {
+    return from(*this, newSource);
+  }
+  template <typename NewState>
+  constexpr auto From(NewState newSource) && {
+    return from(std::move(*this), newSource);
   }
 
   template <typename NewState>
-  constexpr auto To(NewState newTarget) const {
-    if constexpr (std::is_same<State, NewState>::value) {
-      // we already have a source (of the same type), keep it
-      return PartialTransition<State, Event, Guard, Action>{
-          source, newTarget, event, guard, action};
-    }
-    // we need to set a new source, we will create a self-loop
-    return PartialTransition<NewState, Event, Guard, Action>{
-        newTarget, newTarget, event, guard, action};
+  constexpr auto To(NewState newTarget) const & {
+    return to(*this, newTarget);
+  }
+  template <typename NewState>
+  constexpr auto To(NewState newTarget) && {
+    return to(std::move(*this), newTarget);
   }
 
   template <typename NewEvent>
-  constexpr auto On(NewEvent newEvent) const {
-    return PartialTransition<State, NewEvent, Guard, Action>{
-        source, target, newEvent, guard, action};
+  constexpr auto On(NewEvent newEvent) const & {
+    return on(*this, newEvent);
+  }
+  template <typename NewEvent>
+  constexpr auto On(NewEvent newEvent) && {
+    return on(std::move(*this), newEvent);
+  }
+
+  template <typename Duration>
+  constexpr auto After(Duration delay) const & {
+    return On(Timeout<Duration>{delay});
+  }
+  template <typename Duration>
+  constexpr auto After(Duration delay) && {
+    return std::move(*this).On(Timeout<Duration>{delay});
   }
 
   template <typename NewGuard>
-  constexpr PartialTransition<State, Event, NewGuard, Action> If(NewGuard newGuard) const {
-    return {source, target, event, newGuard, action};
+  constexpr PartialTransition<State, Event, NewGuard, Action> If(NewGuard newGuard) const & {
+    return {source, target, event, std::move(newGuard), action};
+  }
+  template <typename NewGuard>
+  constexpr PartialTransition<State, Event, NewGuard, Action> If(NewGuard newGuard) && {
+    return {source, target, event, std::move(newGuard), std::move(action)};
   }
 
   template <typename NewAction>
-  constexpr PartialTransition<State, Event, Guard, NewAction> Do(NewAction newAction) const {
-    return {source, target, event, guard, newAction};
+  constexpr PartialTransition<State, Event, Guard, NewAction> Do(NewAction newAction) const & {
+    return {source, target, event, guard, std::move(newAction)};
+  }
+  template <typename NewAction>
+  constexpr PartialTransition<State, Event, Guard, NewAction> Do(NewAction newAction) && {
+    return {source, target, event, std::move(guard), std::move(newAction)};
   }
 
-  constexpr auto If() const { return If<NoneType>({}); }
-  constexpr auto Do() const { return Do<NoneType>({}); }
-
-  constexpr auto make() const {
-    static_assert(HasState() && HasEvent(),
-                  "Transition must have at least State and Event types defined");
-    return Transition<State, Event, Guard, Action>{source, target, event, guard, action};
+  constexpr auto If() const & { return If<NoneType>({}); }
+  constexpr auto If() && { return std::move(*this).template If<NoneType>({}); }
+  constexpr auto Do() const & { return Do<NoneType>({}); }
+  constexpr auto Do() && { return std::move(*this).template Do<NoneType>({}); }
+
+  // make<Payload>() makes a transition whose guard and action take a const Payload &, and
+  // make<Payload, Context>() one whose guard and action take a Context & (and then the payload,
+  // unless Payload is NoneType)
+  template <typename Payload = NoneType, typename Context = NoneType>
+  constexpr auto make() const & {
+    return makeFrom<Payload, Context>(*this);
+  }
+  template <typename Payload = NoneType, typename Context = NoneType>
+  constexpr auto make() && {
+    return makeFrom<Payload, Context>(std::move(*this));
   }
 
   template <typename... Types>
@@ -101,6 +128,65 @@ struct PartialTransition {
   constexpr bool operator!=(const PartialTransition<Types...> &other) const {
     return !(*this == other);
   }
+
+  // helper functions, taking the partial transition as Self (const & or &&) to forward its guard
+  // and action from
+  template <typename Self, typename NewState>
+  static constexpr auto from(Self &&self, NewState newSource) {
+    if constexpr (std::is_same<State, NewState>::value) {
+      // we already have a target (of the same type), keep it
+      return PartialTransition{newSource,
+                               self.target,
+                               self.event,
+                               std::forward<Self>(self).guard,
+                               std::forward<Self>(self).action};
+    }
+    // we need to set a new target, we will create a self-loop
+    return PartialTransition<NewState, Event, Guard, Action>{newSource,
+                                                             newSource,
+                                                             self.event,
+                                                             std::forward<Self>(self).guard,
+                                                             std::forward<Self>(self).action};
+  }
+
+  template <typename Self, typename NewState>
+  static constexpr auto to(Self &&self, NewState newTarget) {
+    if constexpr (std::is_same<State, NewState>::value) {
+      // we already have a source (of the same type), keep it
+      return PartialTransition<State, Event, Guard, Action>{self.source,
+                                                            newTarget,
+                                                            self.event,
+                                                            std::forward<Self>(self).guard,
+                                                            std::forward<Self>(self).action};
+    }
+    // we need to set a new source, we will create a self-loop
+    return PartialTransition<NewState, Event, Guard, Action>{newTarget,
+                                                             newTarget,
+                                                             self.event,
+                                                             std::forward<Self>(self).guard,
+                                                             std::forward<Self>(self).action};
+  }
+
+  template <typename Self, typename NewEvent>
+  static constexpr auto on(Self &&self, NewEvent newEvent) {
+    return PartialTransition<State, NewEvent, Guard, Action>{self.source,
+                                                             self.target,
+                                                             newEvent,
+                                                             std::forward<Self>(self).guard,
+                                                             std::forward<Self>(self).action};
+  }
+
+  template <typename Payload, typename Context, typename Self>
+  static constexpr auto makeFrom(Self &&self) {
+    static_assert(HasState() && HasEvent(),
+                  "Transition must have at least State and Event types defined");
+    return Transition<State, Event, Guard, Action, Payload, Context>{
+        self.source,
+        self.target,
+        self.event,
+        std::forward<Self>(self).guard,
+        std::forward<Self>(self).action};
+  }
 };
 
 template <typename State>
@@ -120,14 +206,19 @@ constexpr PartialTransition<NoneType, Event> On(Event newEvent) {
   return {{}, {}, newEvent, {}, {}};
 }
 
+template <typename Duration>
+constexpr PartialTransition<NoneType, Timeout<Duration>> After(Duration delay) {
+  return {{}, {}, Timeout<Duration>{delay}, {}, {}};
+}
+
 template <typename Guard>
 constexpr PartialTransition<NoneType, NoneType, Guard> If(Guard guard) {
-  return {{}, {}, {}, guard, {}};
+  return {{}, {}, {}, std::move(guard), {}};
 }
 
 template <typename Action>
 constexpr PartialTransition<NoneType, NoneType, NoneType, Action> Do(Action action) {
-  return {{}, {}, {}, {}, action};
+  return {{}, {}, {}, {}, std::move(action)};
 }
 
 } // namespace susml::factory
@@ -0,0 +1,162 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef FIXED_HPP
+#define FIXED_HPP
+
+#include "common.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace susml::fixed {
+
+// Callable stored inline in Size bytes, as a replacement for std::function that never allocates.
+// Only trivially copyable callables are accepted (function pointers, and lambdas that capture
+// references, pointers or plain values), so an InlineFunction is itself trivially copyable and
+// there is nothing to copy or destroy. A default-constructed InlineFunction is empty.
+template <typename Signature, std::size_t Size = 2 * sizeof(void *)>
+struct InlineFunction;
+
+template <typename R, typename... Args, std::size_t Size>
+struct InlineFunction<R(Args...), Size> {
+  alignas(std::max_align_t) unsigned char storage[Size] = {};
+  R (*invoke)(void *, Args...)                            = nullptr;
+
+  constexpr InlineFunction() = default;
+  constexpr InlineFunction(std::nullptr_t) {} // NOLINT: implicit, like std::function
+
+  template <typename F,
+            typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type, InlineFunction>::value &&
+                !std::is_same<typename std::decay<F>::type, std::nullptr_t>::value>::type>
+  InlineFunction(const F &f) { // NOLINT: implicit, like std::function
+    static_assert(std::is_invocable_r<R, F &, Args...>::value, "F has the wrong signature.");
+    static_assert(sizeof(F) <= Size, "F does not fit in the inline storage, increase Size.");
+    static_assert(alignof(F) <= alignof(std::max_align_t), "F is over-aligned.");
+    static_assert(std::is_trivially_copyable<F>::value,
+                  "F must be trivially copyable (e.g. capture by reference or pointer).");
+    new (storage) F(f);
+    invoke = [](void *p, Args... args) -> R {
+      return (*std::launder(static_cast<F *>(p)))(std::forward<Args>(args)...);
+    };
+  }
+
+  constexpr explicit operator bool() const { return invoke != nullptr; }
+
+  R operator()(Args... args) { return invoke(storage, std::forward<Args>(args)...); }
+};
+
+template <typename State, typename Event, std::size_t Size = 2 * sizeof(void *)>
+using Transition =
+    susml::Transition<State, Event, InlineFunction<bool(), Size>, InlineFunction<void(), Size>>;
+
+// Array of up to Capacity elements with a size, stored inline. Unlike std::array, the elements
+// need not be default-constructible; they must be trivially copyable.
+template <typename T, std::size_t Capacity>
+struct Array {
+  static_assert(Capacity > 0, "Capacity must be at least 1.");
+  static_assert(std::is_trivially_copyable<T>::value, "Elements must be trivially copyable.");
+
+  union Slot {
+    NoneType none;
+    T        value;
+
+    constexpr Slot() : none() {}
+    constexpr explicit Slot(const T &value) : value(value) {}
+  };
+
+  Slot        slots[Capacity];
+  std::size_t count = 0;
+
+  constexpr std::size_t size() const { return count; }
+  constexpr bool        full() const { return count == Capacity; }
+
+  constexpr T &      operator[](std::size_t i) { return slots[i].value; }
+  constexpr const T &operator[](std::size_t i) const { return slots[i].value; }
+
+  // Returns false (and leaves the array as is) if it is full.
+  constexpr bool push_back(const T &value) {
+    if (full()) { return false; }
+    slots[count++] = Slot(value);
+    return true;
+  }
+};
+
+// Vector-based state machine with room for up to Capacity transitions, stored inline rather than
+// in a std::vector. Together with guards and actions that are function pointers or InlineFunctions,
+// it never allocates: the transitions must be trivially copyable, which is checked at compile time,
+// so neither they nor the machine can own heap memory. A trigger compares at most Capacity
+// transitions and calls at most one action, so its worst case is known from the type alone.
+//
+// An empty guard always passes and an empty action does nothing (see isNull in common.hpp).
+template <typename TransitionT, std::size_t CapacityT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+
+  static constexpr std::size_t Capacity = CapacityT;
+
+  static_assert(std::is_trivially_copyable<Transition>::value,
+                "Transitions must be trivially copyable, e.g. use fixed::InlineFunction or "
+                "function pointers rather than std::function for guards and actions.");
+
+  State                       currentState;
+  Array<Transition, Capacity> transitions;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  template <std::size_t N>
+  constexpr StateMachine(const State &initialState, const Transition (&transitions)[N])
+      : currentState(initialState) {
+    static_assert(N <= Capacity, "More transitions than the capacity of the machine.");
+    for (const auto &t : transitions) {
+      this->transitions.push_back(t);
+    }
+  }
+
+  explicit constexpr StateMachine(const State &initialState) : currentState(initialState) {}
+
+  // Appends a transition, returns false if the machine is full.
+  constexpr bool add(const Transition &transition) { return transitions.push_back(transition); }
+
+  constexpr void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  constexpr void trigger(const Event &event, const Payload &payload) {
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      auto &t = transitions[i];
+      if (!(t.source == currentState && t.event == event)) { continue; }
+      if constexpr (Transition::HasGuard()) {
+        if (!t.isAllowed(payload)) { continue; }
+      }
+      if constexpr (Transition::HasAction()) { t.fire(payload); }
+      currentState = t.target;
+      return;
+    }
+    numUnhandledEvents++;
+  }
+};
+
+} // namespace susml::fixed
+
+#endif
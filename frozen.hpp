@@ -0,0 +1,375 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef FROZEN_HPP
+#define FROZEN_HPP
+
+#include "common.hpp"
+#include "packed.hpp"
+#include "vectorbased.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::frozen {
+
+enum class Representation {
+  denseTable,    // a cell per state and event, with the first candidate transition
+  narrowTable,   // the same, with cells of as few bits as the number of transitions requires
+  sourceOffsets, // the candidates of each state are a range, found through a table of offsets
+  hashIndex,     // the same, with the range found through a hash map from state to range
+  linear,        // all transitions are searched, as in the vector-based machine
+};
+
+constexpr const char *toString(Representation representation) {
+  switch (representation) {
+  case Representation::denseTable: return "dense table";
+  case Representation::narrowTable: return "narrow table";
+  case Representation::sourceOffsets: return "source offsets";
+  case Representation::hashIndex: return "hash index";
+  case Representation::linear: return "linear";
+  }
+  return "";
+}
+
+// What freeze() found out about a machine, and what it chose because of it.
+struct Report {
+  std::size_t numTransitions  = 0;
+  std::size_t numStates       = 0; // distinct states, or 0 if states cannot be counted
+  std::size_t numEvents       = 0; // distinct events, or 0 if events cannot be counted
+  std::size_t maxState        = 0; // largest state value, for integral or enum states
+  std::size_t maxEvent        = 0; // largest event value, for integral or enum events
+  bool        hasGuards       = false;
+  bool        isDeterministic = false; // at most one transition per state and event
+
+  Representation representation = Representation::linear;
+  std::size_t    indexBytes     = 0; // memory used by the index, besides the transitions
+};
+
+namespace detail {
+template <typename T, typename = void>
+struct IsHashable : std::false_type {};
+
+template <typename T>
+struct IsHashable<T, std::void_t<decltype(std::hash<T>{}(std::declval<const T &>()))>>
+    : std::is_default_constructible<std::hash<T>> {};
+
+// tables up to this size are kept at 32 bits per cell, as they fit in a typical L1 cache anyway
+constexpr std::size_t WideTableBytes = 32 * 1024;
+
+// up to this many transitions, searching them all beats hashing the state
+constexpr std::size_t MaxLinearTransitions = 16;
+} // namespace detail
+
+// Immutable machine with the trigger semantics of the vector-based machine (the first transition
+// from the current state on the event whose guard passes is taken), on the representation chosen
+// by freeze(). The transitions are grouped by source, which keeps the order among the transitions
+// of each state and thereby their priority. The table representations hold, per state and event,
+// the first candidate transition, and next links each candidate to the one after it, so guards
+// that fail move on to the next candidate without searching.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+
+  State                   currentState;
+  std::vector<Transition> transitions; // grouped by source, unless linear
+  Representation          representation = Representation::linear;
+
+  // tables: cell s * numColumns + e holds the index + 1 of the first candidate, or 0
+  std::size_t                numRows    = 0;
+  std::size_t                numColumns = 0;
+  std::vector<std::uint32_t> table;
+  packed::PackedArray        narrowTable;
+  std::vector<std::uint32_t> next; // index + 1 of the next candidate, or 0 (if there are guards)
+
+  // source offsets: the candidates of state s are [offsets[s], offsets[s+1])
+  std::vector<std::uint32_t> offsets;
+
+  // hash index: the candidates of each state, if states can be hashed
+  using Ranges = std::conditional_t<
+      detail::IsHashable<State>::value,
+      std::unordered_map<State, std::pair<std::uint32_t, std::uint32_t>>,
+      NoneType>;
+  Ranges ranges;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  // NOTE: the machine starts out without transitions, freeze() fills it in.
+  explicit StateMachine(const State &initialState) : currentState(initialState) {}
+
+  void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  void trigger(const Event &event, const Payload &payload) {
+    switch (representation) {
+    case Representation::denseTable:
+    case Representation::narrowTable: {
+      if constexpr (isIndexable<State>() && isIndexable<Event>()) {
+        const auto s = toIndex(currentState);
+        const auto e = toIndex(event);
+        if (s < numRows && e < numColumns) {
+          const auto cell = s * numColumns + e;
+          auto       i    = (representation == Representation::denseTable)
+                                   ? table[cell]
+                                   : narrowTable.get(cell);
+          for (; i != 0; i = next.empty() ? 0 : next[i - 1]) {
+            if (take(transitions[i - 1], payload)) { return; }
+          }
+        }
+      }
+      break;
+    }
+    case Representation::sourceOffsets: {
+      if constexpr (isIndexable<State>()) {
+        const auto s = toIndex(currentState);
+        // offsets is never empty, and s + 1 would wrap for negative states
+        if (s < offsets.size() - 1 && search(offsets[s], offsets[s + 1], event, payload)) {
+          return;
+        }
+      }
+      break;
+    }
+    case Representation::hashIndex: {
+      if constexpr (detail::IsHashable<State>::value) {
+        const auto found = ranges.find(currentState);
+        if (found != ranges.end() &&
+            search(found->second.first, found->second.second, event, payload)) {
+          return;
+        }
+      }
+      break;
+    }
+    case Representation::linear: {
+      for (auto &t : transitions) {
+        if (t.source == currentState && t.event == event && take(t, payload)) { return; }
+      }
+      break;
+    }
+    }
+    numUnhandledEvents++;
+  }
+
+  // helper functions
+  bool search(std::uint32_t first, std::uint32_t last, const Event &event, const Payload &payload) {
+    for (auto i = first; i < last; i++) {
+      if (transitions[i].event == event && take(transitions[i], payload)) { return true; }
+    }
+    return false;
+  }
+
+  bool take(Transition &t, const Payload &payload) {
+    if constexpr (Transition::HasGuard()) {
+      if (!t.isAllowed(payload)) { return false; }
+    }
+    if constexpr (Transition::HasAction()) { t.fire(payload); }
+    currentState = t.target;
+    return true;
+  }
+};
+
+template <typename TransitionT>
+struct Frozen {
+  using Transition = TransitionT;
+
+  StateMachine<Transition> machine;
+  Report                   report;
+};
+
+// Analyzes a vector-based machine (its number and density of states and events, whether it has
+// guards and whether it is deterministic) and freezes it into the representation that suits it
+// best, starting from its current state:
+// - integral or enum states and events that are dense enough for a table of at most 8 cells per
+//   transition get a table, which is narrowed once it outgrows the L1 cache;
+// - otherwise, integral or enum states that are dense get a table of offsets per state;
+// - otherwise, hashable states get a hash index per state, unless there are only a few transitions;
+// - otherwise, the transitions are searched as they are.
+// The machine is copied, and removed transitions are left out.
+template <typename Transition>
+Frozen<Transition> freeze(const vectorbased::StateMachine<Transition> &original) {
+  using State = typename Transition::State;
+  using Event = typename Transition::Event;
+
+  std::vector<Transition> transitions;
+  transitions.reserve(original.transitions.size());
+  for (std::size_t i = 0; i < original.transitions.size(); i++) {
+    if (!original.isTombstone(i)) { transitions.push_back(original.transitions[i]); }
+  }
+  const std::size_t n = transitions.size();
+
+  Frozen<Transition> frozen{StateMachine<Transition>{original.currentState}, Report{}};
+  auto &             m      = frozen.machine;
+  auto &             report = frozen.report;
+  report.numTransitions     = n;
+  report.hasGuards          = Transition::HasGuard();
+
+  // distinct states and events, and whether any state has two transitions on the same event
+  if constexpr (isIndexable<State>() && isIndexable<Event>()) {
+    std::vector<std::pair<std::size_t, std::size_t>> keys;
+    std::vector<std::size_t>                         states{toIndex(original.currentState)};
+    std::vector<std::size_t>                         events;
+    for (const auto &t : transitions) {
+      keys.emplace_back(toIndex(t.source), toIndex(t.event));
+      states.push_back(toIndex(t.source));
+      states.push_back(toIndex(t.target));
+      events.push_back(toIndex(t.event));
+    }
+    auto countDistinct = [](std::vector<std::size_t> &values) {
+      std::sort(values.begin(), values.end());
+      return static_cast<std::size_t>(std::unique(values.begin(), values.end()) - values.begin());
+    };
+    report.numStates = countDistinct(states);
+    report.numEvents = countDistinct(events);
+    report.maxState  = states.back();
+    report.maxEvent  = events.empty() ? 0 : events.back();
+    std::sort(keys.begin(), keys.end());
+    report.isDeterministic = std::adjacent_find(keys.begin(), keys.end()) == keys.end();
+  } else if constexpr (detail::IsHashable<State>::value && detail::IsHashable<Event>::value) {
+    std::unordered_map<State, std::unordered_map<Event, std::size_t>> counts;
+    std::unordered_map<Event, bool>                                   events;
+    counts[original.currentState];
+    report.isDeterministic = true;
+    for (const auto &t : transitions) {
+      counts[t.target];
+      report.isDeterministic = (++counts[t.source][t.event] == 1) && report.isDeterministic;
+      events[t.event]        = true;
+    }
+    report.numStates = counts.size();
+    report.numEvents = events.size();
+  }
+
+  // choose
+  std::size_t maxSource = 0;
+  if constexpr (isIndexable<State>()) {
+    for (const auto &t : transitions) {
+      maxSource = std::max(maxSource, toIndex(t.source));
+    }
+  }
+  const std::size_t numCells = (report.maxState + 1) * (report.maxEvent + 1);
+  const bool        isTable  = isIndexable<State>() && isIndexable<Event>() && n > 0 &&
+                       report.maxState < 8 * n + 256 && report.maxEvent < 8 * n + 256 &&
+                       numCells <= 8 * n + 256;
+  if (isTable) {
+    const bool isNarrow = numCells * sizeof(std::uint32_t) > detail::WideTableBytes &&
+                          packed::PackedArray::bitsFor(n + 1) < 32;
+    report.representation = isNarrow ? Representation::narrowTable : Representation::denseTable;
+  } else if (isIndexable<State>() && n > 0 && maxSource < 2 * n + 256) {
+    report.representation = Representation::sourceOffsets;
+  } else if (detail::IsHashable<State>::value && n > detail::MaxLinearTransitions) {
+    report.representation = Representation::hashIndex;
+  } else {
+    report.representation = Representation::linear;
+  }
+  m.representation = report.representation;
+
+  if (report.representation == Representation::linear) {
+    m.transitions = std::move(transitions);
+    return frozen;
+  }
+
+  // group the transitions by source, keeping their order otherwise
+  std::vector<std::size_t> order(n);
+  for (std::size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  if constexpr (isIndexable<State>()) {
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return toIndex(transitions[a].source) < toIndex(transitions[b].source);
+    });
+  } else if constexpr (detail::IsHashable<State>::value) {
+    std::unordered_map<State, std::size_t> firstSeen;
+    for (const auto &t : transitions) {
+      firstSeen.emplace(t.source, firstSeen.size());
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return firstSeen.at(transitions[a].source) < firstSeen.at(transitions[b].source);
+    });
+  }
+  m.transitions.reserve(n);
+  for (const auto i : order) {
+    m.transitions.push_back(std::move(transitions[i]));
+  }
+
+  // build the index
+  switch (report.representation) {
+  case Representation::denseTable:
+  case Representation::narrowTable: {
+    if constexpr (isIndexable<State>() && isIndexable<Event>()) {
+      m.numRows    = report.maxState + 1;
+      m.numColumns = report.maxEvent + 1;
+      std::vector<std::uint32_t> cells(m.numRows * m.numColumns, 0);
+      if (!report.isDeterministic && Transition::HasGuard()) { m.next.assign(n, 0); }
+      for (std::size_t i = n; i-- > 0;) { // earlier transitions end up first
+        const auto &t    = m.transitions[i];
+        auto &      cell = cells[toIndex(t.source) * m.numColumns + toIndex(t.event)];
+        if (!m.next.empty()) { m.next[i] = cell; }
+        cell = static_cast<std::uint32_t>(i + 1);
+      }
+      if (report.representation == Representation::denseTable) {
+        m.table           = std::move(cells);
+        report.indexBytes = m.table.size() * sizeof(std::uint32_t);
+      } else {
+        m.narrowTable = packed::PackedArray(cells.size(), packed::PackedArray::bitsFor(n + 1));
+        for (std::size_t c = 0; c < cells.size(); c++) {
+          m.narrowTable.set(c, cells[c]);
+        }
+        report.indexBytes = m.narrowTable.bytes();
+      }
+      report.indexBytes += m.next.size() * sizeof(std::uint32_t);
+    }
+    break;
+  }
+  case Representation::sourceOffsets: {
+    if constexpr (isIndexable<State>()) {
+      m.offsets.assign(maxSource + 2, 0);
+      for (const auto &t : m.transitions) {
+        m.offsets[toIndex(t.source) + 1]++;
+      }
+      for (std::size_t s = 1; s < m.offsets.size(); s++) {
+        m.offsets[s] += m.offsets[s - 1];
+      }
+      report.indexBytes = m.offsets.size() * sizeof(std::uint32_t);
+    }
+    break;
+  }
+  case Representation::hashIndex: {
+    if constexpr (detail::IsHashable<State>::value) {
+      for (std::uint32_t i = 0; i < n; i++) {
+        auto range = m.ranges.emplace(m.transitions[i].source, std::make_pair(i, i)).first;
+        range->second.second = i + 1;
+      }
+      report.indexBytes =
+          m.ranges.size() * (sizeof(State) + 2 * sizeof(std::uint32_t) + 2 * sizeof(void *));
+    }
+    break;
+  }
+  case Representation::linear: break;
+  }
+  return frozen;
+}
+
+} // namespace susml::frozen
+
+#endif
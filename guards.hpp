@@ -0,0 +1,467 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef GUARDS_HPP
+#define GUARDS_HPP
+
+#include "common.hpp"
+#include "interning.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace susml::guards {
+
+enum class Op { isTrue, eq, ne, lt, le, gt, ge };
+
+// A single condition on an input variable: a bool variable being true (or equal to a constant),
+// or an int variable compared to a constant.
+struct Atom {
+  const bool *flag     = nullptr;
+  const int * number   = nullptr;
+  Op          op       = Op::isTrue;
+  int         constant = 0;
+
+  constexpr bool operator()() const {
+    if (flag != nullptr) { return (op == Op::eq) ? (*flag == (constant != 0)) : *flag; }
+    switch (op) {
+    case Op::eq: return *number == constant;
+    case Op::ne: return *number != constant;
+    case Op::lt: return *number < constant;
+    case Op::le: return *number <= constant;
+    case Op::gt: return *number > constant;
+    case Op::ge: return *number >= constant;
+    case Op::isTrue: return *number != 0;
+    }
+    return false;
+  }
+
+  constexpr bool operator==(const Atom &other) const {
+    return flag == other.flag && number == other.number && op == other.op &&
+           constant == other.constant;
+  }
+};
+
+// A conjunction of atoms (or their negations), over at most 64 atoms numbered 0..63 (which Guard
+// checks at compile time): it holds for a snapshot of the atoms' values if (snapshot & mask) ==
+// value.
+struct Term {
+  std::uint64_t mask  = 0;
+  std::uint64_t value = 0;
+};
+
+// Expression in disjunctive normal form (any of the terms holds), over a list of atoms.
+struct Dnf {
+  std::vector<Atom> atoms;
+  std::vector<Term> terms;
+
+  // bit of the atom in the terms, adding it if it is new; callers must keep to 64 atoms
+  std::uint64_t bitOf(const Atom &atom) {
+    std::size_t i = 0;
+    while (i < atoms.size() && !(atoms[i] == atom)) { i++; }
+    if (i == atoms.size()) { atoms.push_back(atom); }
+    return std::uint64_t{1} << i;
+  }
+};
+
+// Expression templates. Every expression can be evaluated directly (so it can be used as a guard
+// as is, e.g. in a tuple-based machine), and can be added to a Dnf with toDnf(dnf, isNegated).
+namespace expression {
+
+template <typename T>
+struct IsExpression : std::false_type {};
+
+template <typename T>
+constexpr bool isExpression() {
+  return IsExpression<typename std::decay<T>::type>::value;
+}
+
+template <typename A, typename B>
+void combineAny(Dnf &dnf, const A &a, const B &b, bool isNegated);
+template <typename A, typename B>
+void combineAll(Dnf &dnf, const A &a, const B &b, bool isNegated);
+
+template <typename T>
+struct Var;
+
+template <>
+struct Var<bool> {
+  const bool *flag;
+
+  constexpr bool operator()() const { return *flag; }
+
+  void toDnf(Dnf &dnf, bool isNegated) const {
+    const auto bit = dnf.bitOf({flag, nullptr, Op::isTrue, 0});
+    dnf.terms      = {{bit, isNegated ? 0 : bit}};
+  }
+};
+
+template <>
+struct Var<int> {
+  const int *number;
+
+  constexpr bool operator()() const { return *number != 0; }
+
+  void toDnf(Dnf &dnf, bool isNegated) const {
+    const auto bit = dnf.bitOf({nullptr, number, Op::isTrue, 0});
+    dnf.terms      = {{bit, isNegated ? 0 : bit}};
+  }
+};
+
+struct Compare {
+  Atom atom;
+
+  constexpr bool operator()() const { return atom(); }
+
+  void toDnf(Dnf &dnf, bool isNegated) const {
+    if (atom.flag != nullptr) { // var(flag) == constant, or its negation
+      const auto bit = dnf.bitOf({atom.flag, nullptr, Op::isTrue, 0});
+      dnf.terms      = {{bit, (isNegated == (atom.constant != 0)) ? 0 : bit}};
+      return;
+    }
+    const auto bit = dnf.bitOf(atom);
+    dnf.terms      = {{bit, isNegated ? 0 : bit}};
+  }
+};
+
+template <typename E>
+struct Not {
+  E operand;
+
+  constexpr bool operator()() const { return !operand(); }
+
+  void toDnf(Dnf &dnf, bool isNegated) const { operand.toDnf(dnf, !isNegated); }
+};
+
+// a && b (or, negated, !a || !b)
+template <typename L, typename R>
+struct And {
+  L left;
+  R right;
+
+  constexpr bool operator()() const { return left() && right(); }
+
+  void toDnf(Dnf &dnf, bool isNegated) const {
+    if (isNegated) {
+      combineAny(dnf, left, right, true);
+    } else {
+      combineAll(dnf, left, right, false);
+    }
+  }
+};
+
+// a || b (or, negated, !a && !b)
+template <typename L, typename R>
+struct Or {
+  L left;
+  R right;
+
+  constexpr bool operator()() const { return left() || right(); }
+
+  void toDnf(Dnf &dnf, bool isNegated) const {
+    if (isNegated) {
+      combineAll(dnf, left, right, true);
+    } else {
+      combineAny(dnf, left, right, false);
+    }
+  }
+};
+
+// dnf becomes the disjunction of (possibly negated) a and b
+template <typename A, typename B>
+void combineAny(Dnf &dnf, const A &a, const B &b, bool isNegated) {
+  a.toDnf(dnf, isNegated);
+  auto terms = std::move(dnf.terms);
+  b.toDnf(dnf, isNegated);
+  dnf.terms.insert(dnf.terms.begin(), terms.begin(), terms.end());
+}
+
+// dnf becomes the conjunction of (possibly negated) a and b, distributed over their terms; terms
+// that contradict themselves (x && !x) are dropped
+template <typename A, typename B>
+void combineAll(Dnf &dnf, const A &a, const B &b, bool isNegated) {
+  a.toDnf(dnf, isNegated);
+  const auto left = std::move(dnf.terms);
+  b.toDnf(dnf, isNegated);
+  const auto right = std::move(dnf.terms);
+
+  dnf.terms.clear();
+  for (const auto &l : left) {
+    for (const auto &r : right) {
+      const auto shared = l.mask & r.mask;
+      if ((l.value & shared) != (r.value & shared)) { continue; }
+      dnf.terms.push_back({l.mask | r.mask, l.value | r.value});
+    }
+  }
+}
+
+// number of atoms in an expression, counting repeated atoms once per use, which bounds the
+// number of distinct atoms in its Dnf at compile time
+template <typename T>
+struct NumAtoms;
+template <typename T>
+struct NumAtoms<Var<T>> : std::integral_constant<std::size_t, 1> {};
+template <>
+struct NumAtoms<Compare> : std::integral_constant<std::size_t, 1> {};
+template <typename E>
+struct NumAtoms<Not<E>> : NumAtoms<E> {};
+template <typename L, typename R>
+struct NumAtoms<And<L, R>>
+    : std::integral_constant<std::size_t, NumAtoms<L>::value + NumAtoms<R>::value> {};
+template <typename L, typename R>
+struct NumAtoms<Or<L, R>>
+    : std::integral_constant<std::size_t, NumAtoms<L>::value + NumAtoms<R>::value> {};
+
+template <typename E>
+constexpr std::size_t numAtoms() {
+  return NumAtoms<typename std::decay<E>::type>::value;
+}
+
+template <typename T>
+struct IsExpression<Var<T>> : std::true_type {};
+template <>
+struct IsExpression<Compare> : std::true_type {};
+template <typename E>
+struct IsExpression<Not<E>> : std::true_type {};
+template <typename L, typename R>
+struct IsExpression<And<L, R>> : std::true_type {};
+template <typename L, typename R>
+struct IsExpression<Or<L, R>> : std::true_type {};
+
+template <typename E, typename = std::enable_if_t<isExpression<E>()>>
+constexpr Not<E> operator!(const E &e) {
+  return {e};
+}
+
+template <typename L,
+          typename R,
+          typename = std::enable_if_t<isExpression<L>() && isExpression<R>()>>
+constexpr And<L, R> operator&&(const L &l, const R &r) {
+  return {l, r};
+}
+
+template <typename L,
+          typename R,
+          typename = std::enable_if_t<isExpression<L>() && isExpression<R>()>>
+constexpr Or<L, R> operator||(const L &l, const R &r) {
+  return {l, r};
+}
+
+constexpr Compare operator==(const Var<bool> &v, bool c) {
+  return {{v.flag, nullptr, Op::eq, c ? 1 : 0}};
+}
+constexpr Compare operator==(const Var<int> &v, int c) { return {{nullptr, v.number, Op::eq, c}}; }
+constexpr Compare operator!=(const Var<int> &v, int c) { return {{nullptr, v.number, Op::ne, c}}; }
+constexpr Compare operator<(const Var<int> &v, int c) { return {{nullptr, v.number, Op::lt, c}}; }
+constexpr Compare operator<=(const Var<int> &v, int c) { return {{nullptr, v.number, Op::le, c}}; }
+constexpr Compare operator>(const Var<int> &v, int c) { return {{nullptr, v.number, Op::gt, c}}; }
+constexpr Compare operator>=(const Var<int> &v, int c) { return {{nullptr, v.number, Op::ge, c}}; }
+
+} // namespace expression
+
+// Refers to an input variable in a guard expression, e.g. var(a) && !var(b), or var(n) >= 3. The
+// variable is read whenever the guard is evaluated, so it must outlive the guard.
+constexpr expression::Var<bool> var(const bool &flag) { return {&flag}; }
+constexpr expression::Var<int>  var(const int &number) { return {&number}; }
+
+// Guard type for runtime polymorphic machines, constructed from any guard expression. It can be
+// called like any other guard, and can be compiled into a table by guards::StateMachine. As its
+// terms are 64-bit masks, an expression may use at most 64 atoms, where an atom that is used
+// twice counts twice; larger expressions do not compile, and can be used directly as guards.
+struct Guard {
+  Dnf dnf{{}, {Term{}}}; // a default constructed guard always passes
+
+  Guard() = default;
+
+  // implicit, so expressions can be used wherever a Guard is expected
+  template <typename E, typename = std::enable_if_t<expression::isExpression<E>()>>
+  Guard(const E &e) {
+    static_assert(expression::numAtoms<E>() <= 64,
+                  "A Guard is limited to 64 atoms, each use of an atom counting as one.");
+    e.toDnf(dnf, false);
+  }
+
+  bool operator()() const {
+    std::uint64_t snapshot = 0;
+    for (std::size_t i = 0; i < dnf.atoms.size(); i++) {
+      snapshot |= std::uint64_t{dnf.atoms[i]()} << i;
+    }
+    for (const auto &t : dnf.terms) {
+      if ((snapshot & t.mask) == t.value) { return true; }
+    }
+    return false;
+  }
+};
+
+// State machine with guards given as expressions (see Guard). On construction, the atoms of all
+// guards are collected (deduplicated) into one list, and the terms of all guards are laid out per
+// state and event, in order of the transitions. A trigger reads all atoms into a bitmask snapshot
+// once, and then tests all terms of the current state and event against the snapshot without
+// branching: the first transition with a matching term is taken.
+//
+// If there are more than 64 distinct atoms, or more than 64 terms for a state and event, it falls
+// back to calling the guards one by one. Requires std::hash for the State and Event types.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  static_assert(std::is_same<typename Transition::Guard, Guard>::value,
+                "Transitions must have guards::Guard as guard type.");
+
+  struct Candidate {
+    std::uint64_t mask;
+    std::uint64_t value;
+    std::uint32_t transition;
+  };
+
+  static constexpr std::uint32_t NoId = interning::NoId;
+
+  State                      currentState;
+  std::uint32_t              currentId = 0;
+  std::vector<Transition>    transitions;
+  std::vector<Atom>          atoms; // bit i of a snapshot is the value of atoms[i]
+  interning::Interner<State> stateIds;
+  interning::IdMap<Event>    eventIds; // by table if events are dense
+  std::vector<std::uint32_t> targets;  // per transition: target state id
+  std::vector<std::uint32_t> offsets;  // [state * numEvents + event], into candidates
+  std::vector<Candidate>     candidates;
+  bool                       isCompiled = false;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  StateMachine(const State &initialState, const std::vector<Transition> &transitions)
+      : currentState(initialState), transitions(transitions) {
+    isCompiled = compile();
+  }
+
+  void trigger(const Event &event) {
+    if (!isCompiled) {
+      for (auto &t : transitions) {
+        if (t.source == currentState && t.event == event && t.guard()) {
+          take(t);
+          return;
+        }
+      }
+      numUnhandledEvents++;
+      return;
+    }
+
+    const auto e = eventId(event);
+    if (e == NoId) {
+      numUnhandledEvents++;
+      return;
+    }
+
+    const auto cell  = currentId * eventIds.size() + e;
+    const auto first = offsets[cell];
+    const auto last  = offsets[cell + 1];
+    if (first == last) {
+      numUnhandledEvents++;
+      return;
+    }
+
+    const auto    values  = snapshot();
+    std::uint64_t matches = 0;
+    for (auto i = first; i < last; i++) {
+      const auto &c = candidates[i];
+      matches |= std::uint64_t{(values & c.mask) == c.value} << (i - first);
+    }
+    if (matches != 0) {
+      const auto i = candidates[first + __builtin_ctzll(matches)].transition;
+      take(transitions[i]);
+      currentId = targets[i];
+    } else {
+      numUnhandledEvents++;
+    }
+  }
+
+  // helper functions
+  std::uint32_t eventId(const Event &event) const { return eventIds.find(event); }
+
+  std::uint64_t snapshot() const {
+    std::uint64_t values = 0;
+    for (std::size_t i = 0; i < atoms.size(); i++) {
+      values |= std::uint64_t{atoms[i]()} << i;
+    }
+    return values;
+  }
+
+  void take(Transition &t) {
+    if constexpr (Transition::HasAction()) { t.action(); }
+    currentState = t.target;
+  }
+
+  bool compile() {
+    currentId = stateIds.intern(currentState);
+
+    std::vector<std::uint32_t> sources;
+    std::vector<std::uint32_t> events;
+    for (const auto &t : transitions) {
+      sources.push_back(stateIds.intern(t.source));
+      targets.push_back(stateIds.intern(t.target));
+      events.push_back(eventIds.intern(t.event));
+    }
+    eventIds.index();
+
+    // translate the atom bits of each guard to bits in the shared snapshot
+    Dnf                    shared;
+    std::vector<Candidate> unordered;
+    for (std::uint32_t i = 0; i < transitions.size(); i++) {
+      const auto &dnf = transitions[i].guard.dnf;
+
+      std::vector<std::uint64_t> bits;
+      for (const auto &atom : dnf.atoms) {
+        const bool isNew = std::find(shared.atoms.begin(), shared.atoms.end(), atom) ==
+                           shared.atoms.end();
+        if (isNew && shared.atoms.size() == 64) { return false; }
+        bits.push_back(shared.bitOf(atom));
+      }
+      for (const auto &term : dnf.terms) {
+        Candidate c{0, 0, i};
+        for (std::size_t a = 0; a < bits.size(); a++) {
+          if (((term.mask >> a) & 1U) != 0) { c.mask |= bits[a]; }
+          if (((term.value >> a) & 1U) != 0) { c.value |= bits[a]; }
+        }
+        unordered.push_back(c);
+      }
+    }
+
+    // group the candidates by state and event, keeping them in order of the transitions
+    std::vector<std::size_t> cells;
+    cells.reserve(unordered.size());
+    for (const auto &c : unordered) {
+      cells.push_back(sources[c.transition] * eventIds.size() + events[c.transition]);
+    }
+    const auto order = interning::groupByKey(cells, stateIds.size() * eventIds.size(), offsets);
+    for (std::size_t cell = 0; cell + 1 < offsets.size(); cell++) {
+      if (offsets[cell + 1] - offsets[cell] > 64) { return false; }
+    }
+    candidates.reserve(order.size());
+    for (const auto i : order) {
+      candidates.push_back(unordered[i]);
+    }
+
+    atoms = std::move(shared.atoms);
+    return true;
+  }
+};
+
+} // namespace susml::guards
+
+#endif
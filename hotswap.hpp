@@ -0,0 +1,249 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef HOTSWAP_HPP
+#define HOTSWAP_HPP
+
+#include "common.hpp"
+#include "context.hpp"
+#include "vectorbased.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace susml::hotswap {
+
+// One version of a machine definition: its transitions, and how the current state of an instance
+// that ran an earlier version maps onto the states of this one (the identity if mapState is
+// empty). As instances may skip versions, mapState must accept the states of every earlier
+// version that is still in use.
+template <typename TransitionT>
+struct Version {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  std::vector<Transition>              transitions;
+  vectorbased::EventMask<State, Event> acceptedEvents;
+  std::function<State(const State &)>  mapState;
+  std::uint64_t                        number = 0; // assigned when published
+
+  explicit Version(std::vector<Transition>             transitions,
+                   std::function<State(const State &)> mapState = {})
+      : transitions(std::move(transitions)),
+        acceptedEvents(this->transitions),
+        mapState(std::move(mapState)) {}
+};
+
+// Epoch in which a reader (i.e. a machine instance) pinned the current version, or Idle. Each
+// slot has a cache line of its own, so readers pinning at the same time do not contend.
+struct alignas(64) ReaderSlot {
+  static constexpr std::uint64_t Idle = std::numeric_limits<std::uint64_t>::max();
+
+  std::atomic<std::uint64_t> epoch{Idle};
+  bool                       isRegistered = false; // guarded by the mutex of the holder
+};
+
+// Holds the current version of a definition and publishes new ones, read-copy-update style.
+// Readers pin the current version for the duration of a single trigger, which costs two stores
+// and two loads to the reader's own slot and the holder, without locks. Publishing swaps in the
+// new version atomically and retires the old one, which is deleted once every reader that might
+// still be using it has unpinned: by the publish or reclaim() after that, or by that unpin itself,
+// which reclaims when versions are waiting and the mutex is free. So the last retired versions do
+// not outlive their readers just because nothing is published anymore. Only registering readers,
+// publishing and reclaiming take the mutex.
+//
+// Publishing starts a new epoch. A version retired at the start of epoch e+1 can only have been
+// loaded by readers that pinned epoch e or earlier, so it is deleted once no slot holds an epoch
+// of e or earlier.
+template <typename TransitionT>
+struct Holder {
+  using Transition = TransitionT;
+  using Version    = hotswap::Version<Transition>;
+
+  std::atomic<Version *>     current;
+  std::atomic<std::uint64_t> epoch{0};
+
+  std::mutex                                                      mutex;
+  std::vector<std::unique_ptr<ReaderSlot>>                        slots;
+  std::vector<std::pair<std::uint64_t, std::unique_ptr<Version>>> retired; // with their epoch
+
+  // retired.size(), for unpin to check without taking the mutex
+  std::atomic<std::size_t> numRetired{0};
+
+  explicit Holder(Version initial) : current(new Version(std::move(initial))) {}
+
+  Holder(const Holder &) = delete;
+  Holder &operator=(const Holder &) = delete;
+
+  // All readers must be gone by now.
+  ~Holder() { delete current.load(); }
+
+  // Makes next the current version, and returns its number. Instances switch to it on their next
+  // trigger, and versions that are no longer in use are reclaimed.
+  std::uint64_t publish(Version next) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    next.number   = current.load()->number + 1;
+    auto *version = new Version(std::move(next));
+    auto *old     = current.exchange(version);
+    retired.emplace_back(epoch.fetch_add(1), std::unique_ptr<Version>(old));
+    reclaimLocked();
+    return version->number;
+  }
+
+  // Deletes the retired versions that are no longer in use, returns how many remain.
+  std::size_t reclaim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reclaimLocked();
+  }
+
+  ReaderSlot *registerReader() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &slot : slots) {
+      if (!slot->isRegistered) {
+        slot->isRegistered = true;
+        return slot.get();
+      }
+    }
+    slots.push_back(std::make_unique<ReaderSlot>());
+    slots.back()->isRegistered = true;
+    return slots.back().get();
+  }
+
+  void unregisterReader(ReaderSlot *slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slot->epoch.store(ReaderSlot::Idle);
+    slot->isRegistered = false;
+  }
+
+  // Returns the current version, which stays alive until unpin().
+  const Version *pin(ReaderSlot &slot) const {
+    slot.epoch.store(epoch.load());
+    return current.load();
+  }
+
+  void unpin(ReaderSlot &slot) {
+    slot.epoch.store(ReaderSlot::Idle, std::memory_order_release);
+    if (numRetired.load(std::memory_order_relaxed) == 0) { return; }
+
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+    if (lock.owns_lock()) { reclaimLocked(); }
+  }
+
+  // helper functions
+  std::size_t reclaimLocked() {
+    std::uint64_t oldest = ReaderSlot::Idle;
+    for (const auto &slot : slots) {
+      oldest = std::min(oldest, slot->epoch.load());
+    }
+    retired.erase(std::remove_if(retired.begin(),
+                                 retired.end(),
+                                 [&](const auto &version) { return version.first < oldest; }),
+                  retired.end());
+    numRetired.store(retired.size(), std::memory_order_relaxed);
+    return retired.size();
+  }
+};
+
+// Instance of a definition in a Holder, with its own current state (and context, for transitions
+// with a Context type). Each trigger runs against the current version of the definition, so
+// instances can keep triggering on their own threads while new versions are published. When an
+// instance first triggers on a newer version, its state is mapped with the version's mapState.
+//
+// The guards and actions of a version are shared by all instances, and may be called from several
+// threads at once, so they should take their data from the context (see context.hpp).
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+  using Context    = typename Transition::Context;
+
+  Holder<Transition> *holder;
+  ReaderSlot *        slot;
+  Context *           context;
+  State               currentState;
+  std::uint64_t       versionNumber = 0;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  StateMachine(Holder<Transition> &holder, Context &context, const State &initialState)
+      : holder(&holder),
+        slot(holder.registerReader()),
+        context(&context),
+        currentState(initialState) {
+    versionNumber = holder.pin(*slot)->number;
+    holder.unpin(*slot);
+  }
+
+  StateMachine(Holder<Transition> &holder, const State &initialState)
+      : StateMachine(holder, none(), initialState) {
+    static_assert(!Transition::HasContext(), "Transitions with a context need a context.");
+  }
+
+  StateMachine(const StateMachine &) = delete;
+  StateMachine &operator=(const StateMachine &) = delete;
+
+  StateMachine(StateMachine &&other) noexcept
+      : holder(other.holder),
+        slot(std::exchange(other.slot, nullptr)),
+        context(other.context),
+        currentState(std::move(other.currentState)),
+        versionNumber(other.versionNumber),
+        numUnhandledEvents(other.numUnhandledEvents) {}
+  StateMachine &operator=(StateMachine &&) = delete;
+
+  ~StateMachine() {
+    if (slot != nullptr) { holder->unregisterReader(slot); }
+  }
+
+  void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  void trigger(const Event &event, const Payload &payload) {
+    const auto *version = holder->pin(*slot);
+    if (version->number != versionNumber) {
+      if (version->mapState) { currentState = version->mapState(currentState); }
+      versionNumber = version->number;
+    }
+    if (!susml::context::take(*version, *context, currentState, event, payload)) {
+      numUnhandledEvents++;
+    }
+    holder->unpin(*slot);
+  }
+
+  // helper functions
+  static Context &none() {
+    static Context context;
+    return context;
+  }
+};
+
+} // namespace susml::hotswap
+
+#endif
@@ -0,0 +1,409 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_HPP
+#define IMAGE_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace susml::image {
+
+constexpr std::uint32_t FormatVersion = 1;
+constexpr std::uint32_t NoAction      = static_cast<std::uint32_t>(-1);
+constexpr std::uint32_t NoId          = static_cast<std::uint32_t>(-1);
+
+// Binary image of a frozen guardless machine with integral or enum states and events, laid out to
+// be used in place, e.g. straight from a memory-mapped file. It holds no pointers, only offsets
+// from its start, so it can be mapped at any address and shared by processes. All sections are
+// 8-byte aligned, and numbers are in the byte order of the machine that wrote the image (which is
+// checked on load).
+//
+//   Header
+//   stateValues    std::int64_t[numStates]      sorted, the state id is the position
+//   eventValues    std::int64_t[numEvents]      sorted, the event id is the position
+//   denseEventIds  std::uint32_t[numDense]      event id of minEvent + i, or NoId (if dense)
+//   offsets        std::uint32_t[numStates + 1] state s: records [offsets[s], offsets[s+1])
+//   records        Record[numRecords]           sorted by event within each state
+//
+// Only the first transition from each state on each event is kept, as the others are never taken.
+struct Header {
+  static constexpr char          Magic[8]  = {'S', 'U', 'S', 'M', 'L', 'I', 'M', 'G'};
+  static constexpr std::uint32_t ByteOrder = 0x01020304;
+
+  char          magic[8];
+  std::uint32_t byteOrder;
+  std::uint32_t version;
+  std::uint64_t size; // of the whole image, in bytes
+  std::uint32_t numStates;
+  std::uint32_t numEvents;
+  std::uint32_t numDense;
+  std::uint32_t numRecords;
+  std::uint32_t numActions; // action ids are below this
+  std::uint32_t initialState;
+  std::int64_t  minEvent;
+  std::uint64_t stateValues;
+  std::uint64_t eventValues;
+  std::uint64_t denseEventIds;
+  std::uint64_t offsets;
+  std::uint64_t records;
+};
+
+struct Record {
+  std::uint32_t event;
+  std::uint32_t target;
+  std::uint32_t action; // or NoAction
+};
+
+namespace detail {
+constexpr std::uint64_t alignUp(std::uint64_t offset) { return (offset + 7) / 8 * 8; }
+} // namespace detail
+
+// Serializes a guardless machine into an image. actionIdOf(transition) returns the id under which
+// the action of a transition is bound on load, or NoAction.
+template <typename Transition, typename ActionIdOf>
+std::vector<std::uint8_t> write(const typename Transition::State &initialState,
+                                const std::vector<Transition> &   transitions,
+                                ActionIdOf &&                     actionIdOf) {
+  static_assert(!Transition::HasGuard(), "Only guardless machines can be written to an image.");
+  static_assert(isIndexable<typename Transition::State>() &&
+                    isIndexable<typename Transition::Event>(),
+                "Images require integral or enum states and events.");
+
+  auto value = [](const auto &v) { return static_cast<std::int64_t>(v); };
+
+  std::vector<std::int64_t> states{value(initialState)};
+  std::vector<std::int64_t> events;
+  for (const auto &t : transitions) {
+    states.push_back(value(t.source));
+    states.push_back(value(t.target));
+    events.push_back(value(t.event));
+  }
+  std::sort(states.begin(), states.end());
+  states.erase(std::unique(states.begin(), states.end()), states.end());
+  std::sort(events.begin(), events.end());
+  events.erase(std::unique(events.begin(), events.end()), events.end());
+
+  auto idOf = [](const std::vector<std::int64_t> &values, std::int64_t v) {
+    return static_cast<std::uint32_t>(std::lower_bound(values.begin(), values.end(), v) -
+                                      values.begin());
+  };
+
+  // (source, event, index) of every transition, of which the first per source and event is kept
+  struct Key {
+    std::uint32_t source;
+    std::uint32_t event;
+    std::size_t   index;
+  };
+  std::vector<Key> keys;
+  keys.reserve(transitions.size());
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    keys.push_back(
+        {idOf(states, value(transitions[i].source)), idOf(events, value(transitions[i].event)), i});
+  }
+  std::sort(keys.begin(), keys.end(), [](const Key &a, const Key &b) {
+    return (a.source != b.source) ? a.source < b.source
+                                  : (a.event != b.event) ? a.event < b.event : a.index < b.index;
+  });
+  keys.erase(std::unique(keys.begin(),
+                         keys.end(),
+                         [](const Key &a, const Key &b) {
+                           return a.source == b.source && a.event == b.event;
+                         }),
+             keys.end());
+
+  std::uint64_t numDense = 0;
+  if (!events.empty()) {
+    const auto range = static_cast<std::uint64_t>(events.back()) -
+                       static_cast<std::uint64_t>(events.front()) + 1;
+    if (range < 8 * events.size() + 256) { numDense = range; }
+  }
+
+  Header header{};
+  std::memcpy(header.magic, Header::Magic, sizeof(header.magic));
+  header.byteOrder     = Header::ByteOrder;
+  header.version       = FormatVersion;
+  header.numStates     = static_cast<std::uint32_t>(states.size());
+  header.numEvents     = static_cast<std::uint32_t>(events.size());
+  header.numDense      = static_cast<std::uint32_t>(numDense);
+  header.numRecords    = static_cast<std::uint32_t>(keys.size());
+  header.initialState  = idOf(states, value(initialState));
+  header.minEvent      = events.empty() ? 0 : events.front();
+  header.stateValues   = detail::alignUp(sizeof(Header));
+  header.eventValues   = detail::alignUp(header.stateValues + states.size() * 8);
+  header.denseEventIds = detail::alignUp(header.eventValues + events.size() * 8);
+  header.offsets       = detail::alignUp(header.denseEventIds + numDense * 4);
+  header.records       = detail::alignUp(header.offsets + (states.size() + 1) * 4);
+  header.size          = detail::alignUp(header.records + keys.size() * sizeof(Record));
+
+  std::vector<std::uint32_t> denseEventIds(numDense, NoId);
+  for (std::uint32_t e = 0; e < events.size() && numDense != 0; e++) {
+    denseEventIds[static_cast<std::uint64_t>(events[e] - header.minEvent)] = e;
+  }
+
+  std::vector<std::uint32_t> offsets(states.size() + 1, 0);
+  std::vector<Record>        records;
+  records.reserve(keys.size());
+  for (const auto &k : keys) {
+    const auto &t      = transitions[k.index];
+    const auto  action = static_cast<std::uint32_t>(actionIdOf(t));
+    offsets[k.source + 1]++;
+    records.push_back({k.event, idOf(states, value(t.target)), action});
+    if (action != NoAction) { header.numActions = std::max(header.numActions, action + 1); }
+  }
+  for (std::size_t s = 1; s < offsets.size(); s++) {
+    offsets[s] += offsets[s - 1];
+  }
+
+  std::vector<std::uint8_t> image(header.size, 0);
+  auto copy = [&](std::uint64_t offset, const void *data, std::size_t size) {
+    if (size != 0) { std::memcpy(image.data() + offset, data, size); }
+  };
+  copy(0, &header, sizeof(Header));
+  copy(header.stateValues, states.data(), states.size() * 8);
+  copy(header.eventValues, events.data(), events.size() * 8);
+  copy(header.denseEventIds, denseEventIds.data(), denseEventIds.size() * 4);
+  copy(header.offsets, offsets.data(), offsets.size() * 4);
+  copy(header.records, records.data(), records.size() * sizeof(Record));
+  return image;
+}
+
+// Serializes a guardless machine without actions (or whose actions are not needed).
+template <typename Transition>
+std::vector<std::uint8_t> write(const typename Transition::State &initialState,
+                                const std::vector<Transition> &   transitions) {
+  return write(initialState, transitions, [](const Transition &) { return NoAction; });
+}
+
+// View of an image in memory, which must stay valid (and 8-byte aligned) for as long as the view
+// is used. Loading only checks the header, in constant time: the sections are not read until they
+// are used, so pages of a mapped file are only loaded (and shared) on demand. isConsistent()
+// additionally checks every record.
+struct Image {
+  const std::uint8_t *data   = nullptr;
+  const Header *      header = nullptr;
+
+  static Image load(const void *data, std::size_t size) {
+    Image image;
+    if (data == nullptr || size < sizeof(Header) ||
+        reinterpret_cast<std::uintptr_t>(data) % 8 != 0) {
+      return image;
+    }
+    const auto *header = static_cast<const Header *>(data);
+    if (std::memcmp(header->magic, Header::Magic, sizeof(header->magic)) != 0 ||
+        header->byteOrder != Header::ByteOrder || header->version != FormatVersion ||
+        header->size > size) {
+      return image;
+    }
+
+    auto fits = [&](std::uint64_t offset, std::uint64_t bytes) {
+      return offset % 8 == 0 && offset <= header->size && bytes <= header->size - offset;
+    };
+    if (!fits(header->stateValues, std::uint64_t{header->numStates} * 8) ||
+        !fits(header->eventValues, std::uint64_t{header->numEvents} * 8) ||
+        !fits(header->denseEventIds, std::uint64_t{header->numDense} * 4) ||
+        !fits(header->offsets, (std::uint64_t{header->numStates} + 1) * 4) ||
+        !fits(header->records, std::uint64_t{header->numRecords} * sizeof(Record)) ||
+        header->initialState >= header->numStates) {
+      return image;
+    }
+
+    image.data   = static_cast<const std::uint8_t *>(data);
+    image.header = header;
+    return image;
+  }
+
+  bool isValid() const { return header != nullptr; }
+
+  // Checks that all offsets and ids in the sections are in range, in time linear in the size.
+  bool isConsistent() const {
+    if (!isValid()) { return false; }
+    const auto *o = offsets();
+    if (o[0] != 0 || o[header->numStates] != header->numRecords) { return false; }
+    for (std::uint32_t s = 0; s < header->numStates; s++) {
+      if (o[s] > o[s + 1]) { return false; }
+    }
+    for (std::uint32_t i = 0; i < header->numRecords; i++) {
+      const auto &r = records()[i];
+      if (r.event >= header->numEvents || r.target >= header->numStates ||
+          (r.action != NoAction && r.action >= header->numActions)) {
+        return false;
+      }
+    }
+    for (std::uint32_t i = 0; i < header->numDense; i++) {
+      if (denseEventIds()[i] != NoId && denseEventIds()[i] >= header->numEvents) { return false; }
+    }
+    return true;
+  }
+
+  const std::int64_t *stateValues() const { return section<std::int64_t>(header->stateValues); }
+  const std::int64_t *eventValues() const { return section<std::int64_t>(header->eventValues); }
+  const std::uint32_t *denseEventIds() const {
+    return section<std::uint32_t>(header->denseEventIds);
+  }
+  const std::uint32_t *offsets() const { return section<std::uint32_t>(header->offsets); }
+  const Record *       records() const { return section<Record>(header->records); }
+
+  std::uint32_t stateId(std::int64_t value) const {
+    return find(stateValues(), header->numStates, value);
+  }
+
+  std::uint32_t eventId(std::int64_t value) const {
+    if (header->numDense != 0) {
+      const auto e =
+          static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(header->minEvent);
+      return (e < header->numDense) ? denseEventIds()[e] : NoId;
+    }
+    return find(eventValues(), header->numEvents, value);
+  }
+
+  // helper functions
+  template <typename T>
+  const T *section(std::uint64_t offset) const {
+    return reinterpret_cast<const T *>(data + offset);
+  }
+
+  static std::uint32_t find(const std::int64_t *values, std::uint32_t size, std::int64_t value) {
+    const auto *found = std::lower_bound(values, values + size, value);
+    return (found == values + size || *found != value) ? NoId
+                                                       : static_cast<std::uint32_t>(found - values);
+  }
+};
+
+// Guardless state machine that runs directly on an image, without copying any of it. Actions are
+// bound to their ids with bind(); actions that are not bound do nothing. Many machines can run on
+// the same image.
+//
+// A machine made from an image that is not valid (see Image::load) has no states: isValid() is
+// false, every trigger is unhandled and setState fails. currentState() requires a valid machine.
+template <typename StateT, typename EventT, typename ActionT = std::function<void()>>
+struct StateMachine {
+  using State  = StateT;
+  using Event  = EventT;
+  using Action = ActionT;
+
+  static_assert(isIndexable<State>() && isIndexable<Event>(),
+                "Images require integral or enum states and events.");
+
+  Image               image;
+  std::uint32_t       currentId;
+  std::vector<Action> actions; // indexed by action id
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  explicit StateMachine(const Image &image)
+      : image(image),
+        currentId(image.isValid() ? image.header->initialState : NoId),
+        actions(image.isValid() ? image.header->numActions : 0) {}
+
+  bool isValid() const { return currentId != NoId; }
+
+  // Binds an action to its id, returns false (and binds nothing) if the image has no such id.
+  bool bind(std::uint32_t actionId, Action action) {
+    if (actionId >= actions.size()) { return false; }
+    actions[actionId] = std::move(action);
+    return true;
+  }
+
+  State currentState() const { return static_cast<State>(image.stateValues()[currentId]); }
+
+  // Sets the current state, returns false (and leaves it as is) if the image has no such state.
+  bool setState(const State &state) {
+    if (!isValid()) { return false; }
+    const auto id = image.stateId(static_cast<std::int64_t>(state));
+    if (id == NoId) { return false; }
+    currentId = id;
+    return true;
+  }
+
+  void trigger(const Event &event) {
+    const auto e = isValid() ? image.eventId(static_cast<std::int64_t>(event)) : NoId;
+    if (e == NoId) {
+      numUnhandledEvents++;
+      return;
+    }
+
+    const auto *offsets = image.offsets();
+    const auto *first   = image.records() + offsets[currentId];
+    const auto *last    = image.records() + offsets[currentId + 1];
+    const auto *found   = std::lower_bound(
+        first, last, e, [](const Record &r, std::uint32_t event) { return r.event < event; });
+    if (found == last || found->event != e) {
+      numUnhandledEvents++;
+      return;
+    }
+    if (found->action != NoAction && actions[found->action]) { actions[found->action](); }
+    currentId = found->target;
+  }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+// Read-only memory mapping of a whole file, which is shared with other processes mapping the same
+// file. The mapping is page-aligned, so an image in it can be loaded in place.
+struct MappedFile {
+  const void *data = nullptr;
+  std::size_t size = 0;
+
+  explicit MappedFile(const char *path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) { return; }
+    struct stat status {};
+    if (::fstat(fd, &status) == 0 && status.st_size > 0) {
+      void *mapped =
+          ::mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, fd, 0);
+      if (mapped != MAP_FAILED) {
+        data = mapped;
+        size = static_cast<std::size_t>(status.st_size);
+      }
+    }
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (data != nullptr) { ::munmap(const_cast<void *>(data), size); }
+  }
+
+  bool isOpen() const { return data != nullptr; }
+
+  Image load() const { return Image::load(data, size); }
+};
+#endif
+
+// Writes an image to a file, returns false on failure.
+inline bool writeFile(const char *path, const std::vector<std::uint8_t> &image) {
+  std::FILE *file = std::fopen(path, "wb");
+  if (file == nullptr) { return false; }
+  const bool isWritten = std::fwrite(image.data(), 1, image.size(), file) == image.size();
+  return (std::fclose(file) == 0) && isWritten;
+}
+
+} // namespace susml::image
+
+#endif
@@ -0,0 +1,221 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef INDEXED_HPP
+#define INDEXED_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace susml::indexed {
+
+namespace detail {
+// Calls f(c) for every chunk c in [0, numChunks), chunk 0 on the calling thread and the others on
+// threads of their own.
+template <typename F>
+void forEachChunk(std::size_t numChunks, F &&f) {
+  std::vector<std::thread> threads;
+  for (std::size_t c = 1; c < numChunks; c++) {
+    threads.emplace_back([&f, c] { f(c); });
+  }
+  f(0);
+  for (auto &t : threads) {
+    t.join();
+  }
+}
+} // namespace detail
+
+// Vector-based state machine for very large numbers of transitions, with an index from each
+// source state to its transitions. The transitions are stably grouped by source on construction
+// (so the first matching transition still wins), and a trigger only looks at the transitions of
+// the current state. Requires integral or enum states.
+//
+// When the source states are reasonably dense the grouping is a counting sort and the index a
+// table of offsets per state. Otherwise the transitions are sorted by source with a merge sort and
+// a trigger finds the current state among the distinct sources by binary search. Both are split
+// over up to numThreads threads.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+
+  static_assert(isIndexable<State>(), "Indexed machines require an integral or enum State type.");
+
+  State                    currentState;
+  std::vector<Transition>  transitions; // grouped by source, otherwise in order
+  std::vector<std::size_t> sources;     // distinct sources in order, if sources are sparse
+  std::vector<std::size_t> offsets;     // source s (or sources[s]): [offsets[s], offsets[s+1])
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  // The transitions are taken by value, so a vector that is passed as an rvalue is moved into the
+  // machine (and then reordered) rather than copied.
+  StateMachine(const State &           initialState,
+               std::vector<Transition> unordered,
+               std::size_t             numThreads = 1)
+      : currentState(initialState) {
+    const std::size_t n = unordered.size();
+
+    // chunks of at least 64k transitions, such that threads are worth starting
+    std::size_t numChunks = std::max<std::size_t>(1, std::min(numThreads, n / 65536));
+    auto        chunk     = [&](std::size_t c) { return n * c / numChunks; };
+
+    std::vector<std::size_t> maxOf(numChunks, 0);
+    detail::forEachChunk(numChunks, [&](std::size_t c) {
+      for (auto i = chunk(c); i < chunk(c + 1); i++) {
+        maxOf[c] = std::max(maxOf[c], toIndex(unordered[i].source));
+      }
+    });
+    const std::size_t maxSource = *std::max_element(maxOf.begin(), maxOf.end());
+
+    std::vector<std::size_t> order(n);
+    if (maxSource < 2 * n + 256) {
+      // counting sort, with a count per state per chunk. The number of chunks is limited such that
+      // the counts take no more memory than the order itself.
+      const std::size_t numStates = maxSource + 1;
+      numChunks = std::max<std::size_t>(1, std::min(numChunks, n / numStates));
+
+      std::vector<std::size_t> counts(numChunks * numStates, 0); // [chunk * numStates + state]
+      detail::forEachChunk(numChunks, [&](std::size_t c) {
+        for (auto i = chunk(c); i < chunk(c + 1); i++) {
+          counts[c * numStates + toIndex(unordered[i].source)]++;
+        }
+      });
+
+      // turn the counts into the position of the first transition of each state in each chunk
+      offsets.assign(numStates + 1, 0);
+      std::size_t position = 0;
+      for (std::size_t s = 0; s < numStates; s++) {
+        offsets[s] = position;
+        for (std::size_t c = 0; c < numChunks; c++) {
+          const auto count          = counts[c * numStates + s];
+          counts[c * numStates + s] = position;
+          position += count;
+        }
+      }
+      offsets[numStates] = position;
+
+      detail::forEachChunk(numChunks, [&](std::size_t c) {
+        for (auto i = chunk(c); i < chunk(c + 1); i++) {
+          order[counts[c * numStates + toIndex(unordered[i].source)]++] = i;
+        }
+      });
+    } else {
+      // merge sort of (source, index) pairs: each chunk is sorted on its own, then pairs of
+      // neighbouring runs are merged. The index breaks ties, so the order is stable.
+      std::vector<std::pair<std::size_t, std::size_t>> keys(n);
+      auto at = [&](std::size_t c) { return keys.begin() + chunk(std::min(c, numChunks)); };
+
+      detail::forEachChunk(numChunks, [&](std::size_t c) {
+        for (auto i = chunk(c); i < chunk(c + 1); i++) {
+          keys[i] = {toIndex(unordered[i].source), i};
+        }
+        std::sort(at(c), at(c + 1));
+      });
+      for (std::size_t width = 1; width < numChunks; width *= 2) {
+        const std::size_t numMerges = (numChunks + 2 * width - 1) / (2 * width);
+        detail::forEachChunk(numMerges, [&](std::size_t m) {
+          const auto c = 2 * width * m;
+          std::inplace_merge(at(c), at(c + width), at(c + 2 * width));
+        });
+      }
+
+      for (std::size_t i = 0; i < n; i++) {
+        const auto [source, index] = keys[i];
+        order[i]                   = index;
+        if (sources.empty() || sources.back() != source) {
+          sources.push_back(source);
+          offsets.push_back(i);
+        }
+      }
+      offsets.push_back(n);
+    }
+
+    transitions.reserve(n);
+    for (const auto i : order) {
+      transitions.push_back(std::move(unordered[i]));
+    }
+  }
+
+  void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  void trigger(const Event &event, const Payload &payload) {
+    const auto [first, last] = candidates(currentState);
+    for (auto i = first; i < last; i++) {
+      auto &t = transitions[i];
+      if (!(t.event == event)) { continue; }
+      if constexpr (Transition::HasGuard()) {
+        if (!t.isAllowed(payload)) { continue; }
+      }
+      if constexpr (Transition::HasAction()) { t.fire(payload); }
+      currentState = t.target;
+      return;
+    }
+    numUnhandledEvents++;
+  }
+
+  // helper functions
+  // range of the transitions from state
+  std::pair<std::size_t, std::size_t> candidates(const State &state) const {
+    const auto s = toIndex(state);
+    if (sources.empty()) {
+      if (s >= offsets.size() - 1) { return {0, 0}; } // s + 1 would wrap for negative states
+      return {offsets[s], offsets[s + 1]};
+    }
+    const auto found = std::lower_bound(sources.begin(), sources.end(), s);
+    if (found == sources.end() || *found != s) { return {0, 0}; }
+    const auto k = static_cast<std::size_t>(found - sources.begin());
+    return {offsets[k], offsets[k + 1]};
+  }
+};
+
+// Collects the transitions of a large machine one at a time, e.g. while reading them from a file,
+// and then builds an indexed StateMachine from them in one go. The transitions are moved into the
+// machine, which leaves the builder empty.
+template <typename TransitionT>
+struct Builder {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+
+  std::vector<Transition> transitions; // in the order they were added
+
+  void reserve(std::size_t numTransitions) { transitions.reserve(numTransitions); }
+
+  void add(const Transition &transition) { transitions.push_back(transition); }
+  void add(Transition &&transition) { transitions.push_back(std::move(transition)); }
+
+  std::size_t size() const { return transitions.size(); }
+
+  StateMachine<Transition>
+  build(const State &initialState, std::size_t numThreads = std::thread::hardware_concurrency()) {
+    auto machine = StateMachine<Transition>{initialState, std::move(transitions), numThreads};
+    transitions.clear();
+    return machine;
+  }
+};
+
+} // namespace susml::indexed
+
+#endif
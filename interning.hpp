@@ -0,0 +1,284 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef INTERNING_HPP
+#define INTERNING_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::interning {
+
+constexpr std::uint32_t NoId = static_cast<std::uint32_t>(-1);
+
+// splitmix64 finalizer, to spread the bits of (possibly weak) std::hash values
+constexpr std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30U;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27U;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31U;
+  return x;
+}
+
+// Maps values of an arbitrary (hashable, equality comparable) type to dense ids 0..N-1 and back.
+// Values are interned while building, after which freeze() builds a perfect hash (hash and
+// displace): each value is found with a single probe plus one comparison, and values that were
+// never interned are rejected by that same comparison. If no perfect hash can be found (e.g. when
+// distinct values have the same hash), lookups keep using the map.
+template <typename T, typename Hash = std::hash<T>>
+struct Interner {
+  using Value = T;
+
+  std::vector<Value>                             values; // indexed by id
+  std::unordered_map<Value, std::uint32_t, Hash> ids;
+  Hash                                           hash;
+
+  // perfect hash, built by freeze()
+  std::vector<std::uint32_t> displacements; // per bucket
+  std::vector<std::uint32_t> slots;         // id of the value in each slot, or NoId
+
+  std::uint32_t intern(const Value &value) {
+    const auto [found, isNew] = ids.emplace(value, static_cast<std::uint32_t>(values.size()));
+    if (isNew) {
+      values.push_back(value);
+      slots.clear(); // any perfect hash is outdated now
+    }
+    return found->second;
+  }
+
+  constexpr std::size_t size() const { return values.size(); }
+  constexpr bool        isPerfect() const { return !slots.empty(); }
+
+  constexpr const Value &value(std::uint32_t id) const { return values[id]; }
+
+  std::uint32_t find(const Value &value) const {
+    if (isPerfect()) {
+      const auto h  = static_cast<std::uint64_t>(hash(value));
+      const auto id = slots[slot(h, displacements[bucket(h)])];
+      return (id != NoId && values[id] == value) ? id : NoId;
+    }
+    const auto found = ids.find(value);
+    return (found == ids.end()) ? NoId : found->second;
+  }
+
+  // Builds the perfect hash. Returns false if there is none, in which case lookups use the map.
+  bool freeze() {
+    slots.clear();
+    if (values.empty()) { return false; }
+
+    const std::size_t numBuckets = values.size() / 4 + 1;
+    const std::size_t numSlots   = values.size() + values.size() / 4 + 1;
+
+    std::vector<std::vector<std::uint32_t>> buckets(numBuckets);
+    std::vector<std::uint64_t>              hashes(values.size());
+    displacements.assign(numBuckets, 0);
+    for (std::uint32_t id = 0; id < values.size(); id++) {
+      hashes[id] = static_cast<std::uint64_t>(hash(values[id]));
+      buckets[bucket(hashes[id])].push_back(id);
+    }
+
+    std::vector<std::uint32_t> byBucketSize(numBuckets);
+    for (std::uint32_t b = 0; b < numBuckets; b++) {
+      byBucketSize[b] = b;
+    }
+    std::stable_sort(byBucketSize.begin(), byBucketSize.end(), [&](auto a, auto b) {
+      return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<std::uint32_t> table(numSlots, NoId);
+    std::vector<std::size_t>   positions;
+    for (const auto b : byBucketSize) {
+      if (buckets[b].empty()) { break; }
+
+      constexpr std::uint32_t maxAttempts = 1U << 16U;
+      std::uint32_t           d           = 0;
+      for (; d < maxAttempts; d++) {
+        positions.clear();
+        bool fits = true;
+        for (const auto id : buckets[b]) {
+          const auto p = slotIn(hashes[id], d, numSlots);
+          const bool isTaken =
+              std::find(positions.begin(), positions.end(), p) != positions.end();
+          if (table[p] != NoId || isTaken) {
+            fits = false;
+            break;
+          }
+          positions.push_back(p);
+        }
+        if (fits) { break; }
+      }
+      if (d == maxAttempts) { return false; }
+
+      displacements[b] = d;
+      for (std::size_t i = 0; i < positions.size(); i++) {
+        table[positions[i]] = buckets[b][i];
+      }
+    }
+    slots = std::move(table);
+    return true;
+  }
+
+  // helper functions
+  constexpr std::size_t bucket(std::uint64_t h) const { return mix(h) % displacements.size(); }
+  constexpr std::size_t slot(std::uint64_t h, std::uint32_t d) const {
+    return slotIn(h, d, slots.size());
+  }
+  static constexpr std::size_t slotIn(std::uint64_t h, std::uint32_t d, std::size_t numSlots) {
+    return mix(h ^ (0x9e3779b97f4a7c15ULL * (d + 1))) % numSlots;
+  }
+};
+
+// Dense ids of values (such as the events of a machine) in order of first interning, without
+// keeping the values themselves. Once all values are interned, index() replaces the hashing of
+// integral and enum values by a table indexed by the value, if the values are dense enough (the
+// largest below 8 per id plus 256).
+template <typename T>
+struct IdMap {
+  std::unordered_map<T, std::uint32_t> ids;
+  std::vector<std::uint32_t>           dense; // indexed by value: its id, or NoId
+
+  std::uint32_t intern(const T &value) {
+    return ids.emplace(value, static_cast<std::uint32_t>(ids.size())).first->second;
+  }
+
+  std::size_t size() const { return ids.size(); }
+  bool        isDense() const { return !dense.empty(); }
+
+  void index() {
+    if constexpr (isIndexable<T>()) {
+      std::size_t maxValue = 0;
+      for (const auto &[value, id] : ids) {
+        maxValue = std::max(maxValue, toIndex(value));
+      }
+      if (!ids.empty() && maxValue < 8 * ids.size() + 256) {
+        dense.assign(maxValue + 1, NoId);
+        for (const auto &[value, id] : ids) {
+          dense[toIndex(value)] = id;
+        }
+      }
+    }
+  }
+
+  std::uint32_t find(const T &value) const {
+    if constexpr (isIndexable<T>()) {
+      if (isDense()) {
+        const auto v = toIndex(value);
+        return (v < dense.size()) ? dense[v] : NoId;
+      }
+    }
+    const auto found = ids.find(value);
+    return (found == ids.end()) ? NoId : found->second;
+  }
+};
+
+// Groups items by key with a counting sort, keeping the items of each key in their order. Returns
+// the items in grouped order, given the key of each item (below numKeys), and sets offsets such
+// that the items of key k are [offsets[k], offsets[k + 1]) of that order.
+template <typename Key>
+std::vector<std::size_t> groupByKey(const std::vector<Key> &    keys,
+                                    std::size_t                 numKeys,
+                                    std::vector<std::uint32_t> &offsets) {
+  offsets.assign(numKeys + 1, 0);
+  for (const auto k : keys) {
+    offsets[k + 1]++;
+  }
+  for (std::size_t k = 1; k < offsets.size(); k++) {
+    offsets[k] += offsets[k - 1];
+  }
+
+  std::vector<std::size_t> order(keys.size());
+  auto                     fill = offsets;
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    order[fill[keys[i]]++] = i;
+  }
+  return order;
+}
+
+// State machine that runs on interned ids rather than on the user's State and Event types, such
+// that no operator== on (possibly heavy) states or events is needed while triggering: an incoming
+// event is resolved to its id with a single perfect hash probe, or the caller resolves it once up
+// front with eventId() and uses triggerById(). The transitions are grouped by source state, and the
+// current state is reported through reverse lookup.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  struct Record {
+    std::uint32_t event;
+    std::uint32_t target;
+  };
+
+  std::uint32_t              currentId = 0;
+  Interner<State>            states;
+  Interner<Event>            events;
+  std::vector<Transition>    transitions; // grouped by source, otherwise in order
+  std::vector<Record>        records;     // event and target id of each transition
+  std::vector<std::uint32_t> offsets;     // state s: [offsets[s], offsets[s+1])
+
+  StateMachine(const State &initialState, const std::vector<Transition> &uninterned) {
+    currentId = states.intern(initialState);
+
+    std::vector<std::uint32_t> sources;
+    sources.reserve(uninterned.size());
+    for (const auto &t : uninterned) {
+      sources.push_back(states.intern(t.source));
+      states.intern(t.target);
+      events.intern(t.event);
+    }
+    states.freeze();
+    events.freeze();
+
+    const auto order = groupByKey(sources, states.size(), offsets);
+    transitions.reserve(uninterned.size());
+    records.reserve(uninterned.size());
+    for (const auto i : order) {
+      const auto &t = uninterned[i];
+      transitions.push_back(t);
+      records.push_back({events.find(t.event), states.find(t.target)});
+    }
+  }
+
+  const State &currentState() const { return states.value(currentId); }
+
+  std::uint32_t eventId(const Event &event) const { return events.find(event); }
+
+  void trigger(const Event &event) {
+    const auto e = eventId(event);
+    if (e != NoId) { triggerById(e); }
+  }
+
+  constexpr void triggerById(std::uint32_t event) {
+    for (auto i = offsets[currentId]; i < offsets[currentId + 1]; i++) {
+      if (records[i].event != event) { continue; }
+      if constexpr (Transition::HasGuard()) {
+        if (!transitions[i].guard()) { continue; }
+      }
+      if constexpr (Transition::HasAction()) { transitions[i].action(); }
+      currentId = records[i].target;
+      return;
+    }
+  }
+};
+
+} // namespace susml::interning
+
+#endif
@@ -0,0 +1,403 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LOADER_HPP
+#define LOADER_HPP
+
+#include "common.hpp"
+#include "indexed.hpp"
+#include "interning.hpp"
+#include "vectorbased.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::loader {
+
+constexpr std::uint32_t NoId = interning::NoId;
+
+enum class Format { table, dot };
+
+namespace detail {
+constexpr bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+inline std::string_view trim(std::string_view text) {
+  while (!text.empty() && isSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && isSpace(text.back())) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+constexpr bool isAnyOf(char c, std::string_view chars) {
+  for (const char other : chars) {
+    if (c == other) { return true; }
+  }
+  return false;
+}
+
+inline bool startsWith(std::string_view text, std::string_view prefix) {
+  return text.substr(0, prefix.size()) == prefix;
+}
+
+// Splits off the next token of text: a quoted string (without its quotes) or a run of characters
+// up to whitespace, one of the delimiters or the stop sequence (if any). Returns an empty view if
+// there is none.
+inline std::string_view
+nextToken(std::string_view &text, std::string_view delimiters = "", std::string_view stop = "") {
+  text = trim(text);
+  if (text.empty()) { return {}; }
+
+  std::size_t end = 0;
+  if (text.front() == '"') {
+    end = 1;
+    while (end < text.size() && text[end] != '"') {
+      end += (text[end] == '\\') ? 2 : 1;
+    }
+    const auto token = text.substr(1, std::min(end, text.size()) - 1);
+    text.remove_prefix(std::min(end + 1, text.size()));
+    return token;
+  }
+  while (end < text.size() && !isSpace(text[end]) && !isAnyOf(text[end], delimiters) &&
+         (stop.empty() || !startsWith(text.substr(end), stop))) {
+    end++;
+  }
+  const auto token = text.substr(0, end);
+  text.remove_prefix(end);
+  return token;
+}
+
+// FNV-1a, finalized with the splitmix64 mix of interning.hpp
+inline std::uint64_t hash(std::string_view text) {
+  std::uint64_t h = 0xcbf29ce484222325ULL;
+  for (const char c : text) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+  }
+  return interning::mix(h);
+}
+
+// Interns names while loading. Names are looked up by string_view in an open-addressing table
+// of ids and hash tags, next to the interner, which takes a single probe into a flat array for
+// most names rather than a walk through the nodes of the interner's map (and no std::string).
+// The interner is passed on every call rather than kept, so that a copy of the loader that owns
+// both does not keep interning into the interner of the original.
+struct NameTable {
+  using Interner = interning::Interner<std::string>;
+
+  // hash in the upper half, id + 1 in the lower, or 0
+  std::vector<std::uint64_t> slots = std::vector<std::uint64_t>(1024, 0);
+
+  std::uint32_t intern(Interner &interner, std::string_view name) {
+    const auto h    = hash(name);
+    const auto tag  = h >> 32U;
+    const auto mask = slots.size() - 1;
+    for (auto i = h & mask;; i = (i + 1) & mask) {
+      const auto slot = slots[i];
+      if (slot == 0) { break; }
+      const auto id = static_cast<std::uint32_t>(slot) - 1;
+      if ((slot >> 32U) == tag && interner.value(id) == name) { return id; }
+    }
+
+    const auto id = interner.intern(std::string(name));
+    if (2 * interner.size() > slots.size()) { grow(interner, 2 * slots.size()); }
+    insert(h, id);
+    return id;
+  }
+
+  // helper functions
+  void insert(std::uint64_t h, std::uint32_t id) {
+    const auto mask = slots.size() - 1;
+    auto       i    = h & mask;
+    while (slots[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = ((h >> 32U) << 32U) | (std::uint64_t{id} + 1);
+  }
+
+  void grow(const Interner &interner, std::size_t size) {
+    slots.assign(size, 0);
+    for (std::uint32_t id = 0; id < interner.size(); id++) {
+      insert(hash(interner.value(id)), id);
+    }
+  }
+};
+} // namespace detail
+
+// Streaming loader of machine definitions in text form, which builds a vector-based (or indexed)
+// machine directly rather than going through generated code. The input is read a line at a time,
+// each line is parsed in place, and state and event names are interned as they come, so the
+// machine runs on dense ids (std::uint32_t) rather than on strings. Guard and action names are
+// looked up in the guards and actions registered with the loader. Guard and action types that
+// can be made from a name (such as codegen::Hook) are made from the names that are not registered.
+//
+// Two formats are supported, both with one statement per line:
+//
+// A transition table, with a transition per line as "source target event [guard [action]]",
+// where "-" stands for no guard or action. An "initial state" line sets the initial state, and
+// lines starting with '#' are comments.
+//
+// A subset of Graphviz DOT, with a transition per edge statement "source -> target [label=...]",
+// where the label is "event", "event [guard]", "event / action" or "event [guard] / action" (the
+// usual notation of UML state diagrams). An edge without a label attribute marks its target as the
+// initial state, as in "start -> idle" with start drawn as a point, and an empty label is an
+// error. Other statements (graph, node and attribute statements) and "//" or '#' comments are
+// skipped.
+//
+// Without an explicit initial state, the source of the first transition is the initial state.
+// Naming two different initial states is an error.
+// Errors are reported through the return value of load(), with a message in error and the number
+// of the offending line in errorLine.
+//
+// Transitions without a guard or action get an empty (null) one, which the engines skip (see
+// isNull in common.hpp). The list of transitions of each state that build() hands to the
+// vector-based machine is filled in as the transitions are read, so it is not built in a pass of
+// its own.
+template <typename GuardT = std::function<bool()>, typename ActionT = std::function<void()>>
+struct Loader {
+  using Guard      = GuardT;
+  using Action     = ActionT;
+  using Transition = susml::Transition<std::uint32_t, std::uint32_t, Guard, Action>;
+
+  // registry of guards and actions by name, filled in before loading
+  std::unordered_map<std::string, Guard>  guards;
+  std::unordered_map<std::string, Action> actions;
+
+  interning::Interner<std::string> states;
+  interning::Interner<std::string> events;
+  std::vector<Transition>          transitions; // in the order they were read
+  std::uint32_t                    initialState = NoId;
+
+  // indices of the transitions from each state, in order (see vectorbased::StateMachine)
+  std::vector<std::vector<std::size_t>> bySource;
+
+  std::string error;
+  std::size_t errorLine = 0;
+
+  std::string       name; // reused for the lookups of guards and actions, so they do not allocate
+  detail::NameTable stateNames;
+  detail::NameTable eventNames;
+
+  // Reserves room for the given number of transitions, if known up front (e.g. from a header).
+  void reserve(std::size_t numTransitions) { transitions.reserve(numTransitions); }
+
+  // Reads all statements from in, adding to the transitions read so far. Returns false on the
+  // first error, after which the loader should not be used to build a machine.
+  bool load(std::istream &in, Format format) {
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+      lineNumber++;
+      const bool isParsed = (format == Format::table) ? parseTableLine(line) : parseDotLine(line);
+      if (!isParsed) {
+        errorLine = lineNumber;
+        return false;
+      }
+    }
+    states.freeze();
+    events.freeze();
+    return true;
+  }
+
+  // Builds a vector-based machine of the transitions read, which are moved into it along with
+  // their index by source.
+  vectorbased::StateMachine<Transition> build() {
+    auto machine     = vectorbased::StateMachine<Transition>{initial(), std::move(transitions)};
+    machine.bySource = std::move(bySource);
+    bySource         = {};
+    return machine;
+  }
+
+  // Builds an indexed machine of the transitions read (for large machines), which are moved into
+  // it. As the state ids are dense, the transitions are grouped with a counting sort.
+  indexed::StateMachine<Transition>
+  buildIndexed(std::size_t numThreads = std::thread::hardware_concurrency()) {
+    bySource = {};
+    return indexed::StateMachine<Transition>{initial(), std::move(transitions), numThreads};
+  }
+
+  std::uint32_t stateId(const std::string &state) const { return states.find(state); }
+  std::uint32_t eventId(const std::string &event) const { return events.find(event); }
+
+  // helper functions
+  std::uint32_t initial() const {
+    if (initialState != NoId) { return initialState; }
+    return transitions.empty() ? 0 : transitions.front().source;
+  }
+
+  bool setInitial(std::string_view state) {
+    const auto id = stateNames.intern(states, state);
+    if (initialState != NoId && initialState != id) {
+      return fail("initial state \"" + states.value(initialState) + "\" is already set");
+    }
+    initialState = id;
+    return true;
+  }
+
+  bool parseTableLine(std::string_view line) {
+    line = detail::trim(line);
+    if (line.empty() || line.front() == '#') { return true; }
+
+    std::string_view fields[6];
+    std::size_t      numFields = 0;
+    while (numFields < 6) {
+      const auto field = detail::nextToken(line);
+      if (field.empty()) { break; }
+      fields[numFields++] = field;
+    }
+
+    if (fields[0] == "initial") {
+      if (numFields != 2) { return fail("expected \"initial state\""); }
+      return setInitial(fields[1]);
+    }
+    if (numFields < 3 || numFields > 5) {
+      return fail("expected \"source target event [guard [action]]\"");
+    }
+    const auto none = std::string_view("-");
+    return add(fields[0],
+               fields[1],
+               fields[2],
+               (numFields > 3) ? fields[3] : none,
+               (numFields > 4) ? fields[4] : none);
+  }
+
+  bool parseDotLine(std::string_view line) {
+    line = detail::trim(line);
+    if (line.empty() || line.front() == '#' || detail::startsWith(line, "//")) { return true; }
+    if (line.find("->") == std::string_view::npos) { return true; } // not an edge
+
+    const auto source = detail::nextToken(line, "[;", "->");
+    line              = detail::trim(line);
+    if (source.empty() || !detail::startsWith(line, "->")) {
+      return fail("expected \"source -> target\"");
+    }
+    line.remove_prefix(2);
+    const auto target = detail::nextToken(line, "[;", "->");
+    line              = detail::trim(line);
+    if (target.empty() || detail::startsWith(line, "->")) {
+      return fail("expected a single \"source -> target\" per edge statement");
+    }
+
+    // attribute lists, [name=value, ...], of which only the label is used
+    bool             hasLabel = false;
+    std::string_view label;
+    while (!line.empty() && line.front() == '[') {
+      line.remove_prefix(1);
+      for (;;) {
+        const auto attribute = detail::nextToken(line, "=,;]");
+        if (attribute.empty()) { break; }
+        line = detail::trim(line);
+        if (line.empty() || line.front() != '=') { return fail("expected attribute=value"); }
+        line.remove_prefix(1);
+        const auto value = detail::nextToken(line, ",;]");
+        if (attribute == "label") {
+          hasLabel = true;
+          label    = detail::trim(value);
+        }
+        line = detail::trim(line);
+        if (!line.empty() && detail::isAnyOf(line.front(), ",;")) { line.remove_prefix(1); }
+      }
+      line = detail::trim(line);
+      if (line.empty() || line.front() != ']') { return fail("expected ']' after the attributes"); }
+      line = detail::trim(line.substr(1));
+    }
+
+    if (!hasLabel) { return setInitial(target); }
+
+    // event [guard] / action
+    std::string_view action = "-";
+    std::string_view guard  = "-";
+    if (const auto slash = label.find('/'); slash != std::string_view::npos) {
+      action = detail::trim(label.substr(slash + 1));
+      label  = label.substr(0, slash);
+    }
+    if (const auto open = label.find('['); open != std::string_view::npos) {
+      const auto close = label.find(']', open);
+      if (close == std::string_view::npos) { return fail("expected ']' after the guard"); }
+      guard = detail::trim(label.substr(open + 1, close - open - 1));
+      label = label.substr(0, open);
+    }
+    const auto event = detail::trim(label);
+    if (event.empty() || guard.empty() || action.empty()) { // including an empty label
+      return fail("expected \"event [guard] / action\" as label");
+    }
+    return add(source, target, event, guard, action);
+  }
+
+  bool add(std::string_view source,
+           std::string_view target,
+           std::string_view event,
+           std::string_view guardName,
+           std::string_view actionName) {
+    Guard  guard{};
+    Action action{};
+    if (guardName != "-") {
+      if constexpr (Transition::HasGuard()) {
+        name.assign(guardName);
+        const auto found = guards.find(name);
+        if (found != guards.end()) {
+          guard = found->second;
+        } else if constexpr (std::is_constructible<Guard, std::string_view>::value) {
+          guard = Guard(guardName);
+        } else {
+          return fail("unknown guard \"" + name + "\"");
+        }
+      } else {
+        return fail("guards are not supported by this loader");
+      }
+    }
+    if (actionName != "-") {
+      if constexpr (Transition::HasAction()) {
+        name.assign(actionName);
+        const auto found = actions.find(name);
+        if (found != actions.end()) {
+          action = found->second;
+        } else if constexpr (std::is_constructible<Action, std::string_view>::value) {
+          action = Action(actionName);
+        } else {
+          return fail("unknown action \"" + name + "\"");
+        }
+      } else {
+        return fail("actions are not supported by this loader");
+      }
+    }
+    // interned one by one, as the order in which arguments are evaluated is unspecified, and ids
+    // are given in order of first mention
+    const auto s = stateNames.intern(states, source);
+    const auto t = stateNames.intern(states, target);
+    const auto e = eventNames.intern(events, event);
+    if (s >= bySource.size()) { bySource.resize(s + 1); }
+    bySource[s].push_back(transitions.size());
+    transitions.emplace_back(s, t, e, std::move(guard), std::move(action));
+    return true;
+  }
+
+  bool fail(std::string message) {
+    error = std::move(message);
+    return false;
+  }
+};
+
+} // namespace susml::loader
+
+#endif
@@ -0,0 +1,257 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef MINIMIZE_HPP
+#define MINIMIZE_HPP
+
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include <cstddef>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::vectorbased {
+
+template <typename StateMachineT>
+struct Minimized {
+  using StateMachine = StateMachineT;
+  using State        = typename StateMachine::State;
+
+  StateMachine machine;
+
+  // maps every state that is reachable in the original machine to the state that replaces it in
+  // the minimized machine, unreachable states are not in the map
+  std::unordered_map<State, State> stateMap;
+};
+
+// Returns the smallest machine that behaves the same as the given guardless machine: states that
+// cannot be reached from the current state are removed, as are transitions that can never be
+// taken (because an earlier transition has the same source and event), and states that cannot be
+// told apart by the actions fired on any sequence of events are merged (Hopcroft's partition
+// refinement). An event without transition leaves the state as is, so a self-loop without action is
+// equivalent to no transition at all.
+//
+// States that should never be merged can be kept apart by giving them a different label, e.g.
+// when the user inspects the current state to see if the machine is in an accepting state.
+//
+// Each group of merged states is represented by the first of its states that was reached from the
+// current state. Requires std::hash for both the State and Event types.
+template <typename StateMachine, typename Label>
+Minimized<StateMachine> minimize(const StateMachine &machine, Label label) {
+  using Transition = typename StateMachine::Transition;
+  using State      = typename StateMachine::State;
+  using Event      = typename StateMachine::Event;
+
+  static_assert(!Transition::HasGuard(), "Only guardless machines can be minimized.");
+  static_assert(std::is_invocable_r<std::size_t, Label, const State &>::value,
+                "Label should map a State to a std::size_t.");
+
+  constexpr std::size_t None = static_cast<std::size_t>(-1);
+
+  const auto &transitions = machine.transitions;
+
+  // number the events, and the states in the order in which they are reached
+  std::unordered_map<Event, std::size_t> eventIds;
+  for (const auto &t : transitions) {
+    eventIds.emplace(t.event, eventIds.size());
+  }
+  const std::size_t numEvents = eventIds.size();
+
+  std::unordered_map<State, std::size_t> stateIds{{machine.currentState, 0}};
+  std::vector<State>                     states{machine.currentState};
+
+  std::unordered_map<State, std::vector<std::size_t>> outgoing;
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    outgoing[transitions[i].source].push_back(i);
+  }
+
+  // effective[s * numEvents + e] is the transition taken on event e in state s
+  std::vector<std::size_t> effective;
+  for (std::size_t s = 0; s < states.size(); s++) {
+    effective.resize((s + 1) * numEvents, None);
+
+    const auto found = outgoing.find(states[s]);
+    if (found == outgoing.end()) { continue; }
+    for (const auto i : found->second) {
+      auto &slot = effective[s * numEvents + eventIds.at(transitions[i].event)];
+      if (slot != None) { continue; } // dead transition, shadowed by an earlier one
+      slot = i;
+      if (stateIds.emplace(transitions[i].target, states.size()).second) {
+        states.push_back(transitions[i].target);
+      }
+    }
+  }
+  const std::size_t numStates = states.size();
+
+  const auto actionClasses = detail::classifyActions(transitions);
+
+  auto next = [&](std::size_t s, std::size_t e) {
+    const auto i = effective[s * numEvents + e];
+    return (i == None) ? s : stateIds.at(transitions[i].target);
+  };
+  auto output = [&](std::size_t s, std::size_t e) {
+    const auto i = effective[s * numEvents + e];
+    return (i == None) ? std::size_t{0} : actionClasses[i];
+  };
+
+  // predecessors[(t * numEvents + e)] holds all states that go to t on event e
+  std::vector<std::size_t> predecessorOffsets(numStates * numEvents + 1, 0);
+  for (std::size_t s = 0; s < numStates; s++) {
+    for (std::size_t e = 0; e < numEvents; e++) {
+      predecessorOffsets[next(s, e) * numEvents + e + 1]++;
+    }
+  }
+  for (std::size_t i = 1; i < predecessorOffsets.size(); i++) {
+    predecessorOffsets[i] += predecessorOffsets[i - 1];
+  }
+  std::vector<std::size_t> predecessors(numStates * numEvents);
+  {
+    auto fill = predecessorOffsets;
+    for (std::size_t s = 0; s < numStates; s++) {
+      for (std::size_t e = 0; e < numEvents; e++) {
+        predecessors[fill[next(s, e) * numEvents + e]++] = s;
+      }
+    }
+  }
+
+  // initial partition: states with the same label and the same outputs on all events
+  std::vector<std::size_t>              blockOf(numStates);
+  std::vector<std::vector<std::size_t>> blocks;
+  {
+    std::map<std::vector<std::size_t>, std::size_t> signatures;
+    for (std::size_t s = 0; s < numStates; s++) {
+      std::vector<std::size_t> signature{label(states[s])};
+      for (std::size_t e = 0; e < numEvents; e++) {
+        signature.push_back(output(s, e));
+      }
+      const auto [found, isNew] = signatures.emplace(std::move(signature), blocks.size());
+      if (isNew) { blocks.emplace_back(); }
+      blockOf[s] = found->second;
+      blocks[found->second].push_back(s);
+    }
+  }
+
+  // refine until no splitter (block, event) splits any block
+  std::vector<std::pair<std::size_t, std::size_t>> worklist;
+  std::vector<bool>                                inWorklist;
+
+  auto addSplitter = [&](std::size_t b, std::size_t e) {
+    if (inWorklist.size() < (b + 1) * numEvents) { inWorklist.resize((b + 1) * numEvents, false); }
+    if (!inWorklist[b * numEvents + e]) {
+      inWorklist[b * numEvents + e] = true;
+      worklist.emplace_back(b, e);
+    }
+  };
+  for (std::size_t b = 0; b < blocks.size(); b++) {
+    for (std::size_t e = 0; e < numEvents; e++) {
+      addSplitter(b, e);
+    }
+  }
+
+  std::vector<std::size_t> marked(numStates, 0); // number of marked states per block
+  std::vector<bool>        isMarked(numStates, false);
+  std::vector<std::size_t> markedStates;
+  std::vector<std::size_t> touchedBlocks;
+  while (!worklist.empty()) {
+    const auto [splitter, e] = worklist.back();
+    worklist.pop_back();
+    inWorklist[splitter * numEvents + e] = false;
+
+    for (const auto t : blocks[splitter]) {
+      for (auto i = predecessorOffsets[t * numEvents + e];
+           i < predecessorOffsets[t * numEvents + e + 1];
+           i++) {
+        const auto s = predecessors[i];
+        if (isMarked[s]) { continue; }
+        isMarked[s] = true;
+        markedStates.push_back(s);
+        if (marked[blockOf[s]]++ == 0) { touchedBlocks.push_back(blockOf[s]); }
+      }
+    }
+
+    for (const auto b : touchedBlocks) {
+      if (marked[b] < blocks[b].size()) {
+        std::vector<std::size_t> in;
+        std::vector<std::size_t> out;
+        for (const auto s : blocks[b]) {
+          (isMarked[s] ? in : out).push_back(s);
+        }
+        const std::size_t newBlock = blocks.size();
+        blocks[b]                  = std::move(out);
+        blocks.push_back(std::move(in));
+        for (const auto s : blocks[newBlock]) {
+          blockOf[s] = newBlock;
+        }
+        marked.resize(blocks.size(), 0);
+        inWorklist.resize(blocks.size() * numEvents, false); // even if only b becomes a splitter
+
+        for (std::size_t c = 0; c < numEvents; c++) {
+          if (inWorklist[b * numEvents + c] || blocks[newBlock].size() <= blocks[b].size()) {
+            addSplitter(newBlock, c);
+          } else {
+            addSplitter(b, c);
+          }
+        }
+      }
+      marked[b] = 0;
+    }
+    touchedBlocks.clear();
+    for (const auto s : markedStates) {
+      isMarked[s] = false;
+    }
+    markedStates.clear();
+  }
+
+  // every block is represented by its first reached state
+  std::vector<std::size_t> representative(blocks.size(), None);
+  for (std::size_t s = 0; s < numStates; s++) {
+    if (representative[blockOf[s]] == None) { representative[blockOf[s]] = s; }
+  }
+
+  std::vector<bool> isKept(transitions.size(), false);
+  for (std::size_t b = 0; b < blocks.size(); b++) {
+    const auto s = representative[b];
+    for (std::size_t e = 0; e < numEvents; e++) {
+      const auto i = effective[s * numEvents + e];
+      if (i == None || (output(s, e) == 0 && blockOf[next(s, e)] == b)) { continue; }
+      isKept[i] = true;
+    }
+  }
+
+  std::vector<Transition> minimizedTransitions;
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    if (!isKept[i]) { continue; }
+    auto t   = transitions[i];
+    t.target = states[representative[blockOf[stateIds.at(t.target)]]];
+    minimizedTransitions.push_back(t);
+  }
+
+  Minimized<StateMachine> result{StateMachine{machine.currentState, minimizedTransitions}, {}};
+  for (std::size_t s = 0; s < numStates; s++) {
+    result.stateMap.emplace(states[s], states[representative[blockOf[s]]]);
+  }
+  return result;
+}
+
+template <typename StateMachine>
+Minimized<StateMachine> minimize(const StateMachine &machine) {
+  return minimize(machine, [](const typename StateMachine::State &) { return std::size_t{0}; });
+}
+
+} // namespace susml::vectorbased
+
+#endif
@@ -0,0 +1,233 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef NFA_HPP
+#define NFA_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::nfa {
+
+// Set of state ids, one bit per state.
+struct StateSet {
+  std::vector<std::uint64_t> words;
+
+  StateSet() = default;
+  explicit StateSet(std::size_t numStates) : words((numStates + 63) / 64, 0) {}
+
+  bool test(std::size_t s) const { return ((words[s / 64] >> (s % 64)) & 1U) != 0; }
+  void set(std::size_t s) { words[s / 64] |= std::uint64_t{1} << (s % 64); }
+
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+
+  bool any() const {
+    for (const auto w : words) {
+      if (w != 0) { return true; }
+    }
+    return false;
+  }
+
+  std::size_t count() const {
+    std::size_t n = 0;
+    for (const auto w : words) {
+      n += static_cast<std::size_t>(__builtin_popcountll(w));
+    }
+    return n;
+  }
+
+  // calls f(s) for every state s in the set, in ascending order
+  template <typename F>
+  void forEach(F &&f) const {
+    for (std::size_t w = 0; w < words.size(); w++) {
+      for (auto bits = words[w]; bits != 0; bits &= bits - 1) {
+        f(w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits)));
+      }
+    }
+  }
+};
+
+// What happens to an active state that has no (takeable) transition on a triggered event.
+enum class Unmatched {
+  drop, // it is no longer active, as in a classic NFA
+  stay, // it remains active, as with a single current state in the other engines
+};
+
+// Nondeterministic state machine with a set of current states. On a trigger, every transition
+// from any active state on the event is taken (rather than only the first matching one), and the
+// next set of states is the union of their targets.
+//
+// States and events are interned to dense ids. The targets of the plain transitions from each
+// state on each event, those without guard and action, are merged into a successor mask up front,
+// so a trigger ORs together the masks of the active states (found word by word). This is decided
+// per transition: a null guard or action (see isNull in common.hpp) counts as none. Transitions
+// with a guard or an action are evaluated one by one instead, and those that are taken are
+// reported in fired.
+//
+// Requires std::hash for the State and Event types.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  static constexpr std::uint32_t NoId = static_cast<std::uint32_t>(-1);
+
+  std::vector<Transition>                  transitions;
+  Unmatched                                unmatched;
+  std::vector<State>                       states; // indexed by state id
+  std::unordered_map<State, std::uint32_t> stateIds;
+  std::unordered_map<Event, std::uint32_t> eventIds;
+
+  StateSet                   active;
+  StateSet                   next; // scratch space for trigger
+  StateSet                   handled;
+  std::vector<std::uint32_t> fired; // transitions with guard or action taken by the last trigger
+
+  // per event: the states with plain (guardless, actionless) transitions, and the row of each
+  // state's successor mask in rowWords (or NoId)
+  std::vector<StateSet>                   plainSources;
+  std::vector<std::uint32_t>              rowOf; // [event * numStates + state]
+  std::vector<std::uint64_t>              rowWords;
+  std::vector<std::vector<std::uint32_t>> special;  // per event: transitions with guard or action
+  std::vector<std::uint32_t>              sourceOf; // per transition: source state id
+  std::vector<std::uint32_t>              targetOf; // per transition: target state id
+
+  StateMachine(const std::vector<State> &     initialStates,
+               const std::vector<Transition> &transitions,
+               Unmatched                      unmatched = Unmatched::drop)
+      : transitions(transitions), unmatched(unmatched) {
+    for (const auto &s : initialStates) {
+      intern(s);
+    }
+    for (const auto &t : transitions) {
+      sourceOf.push_back(intern(t.source));
+      targetOf.push_back(intern(t.target));
+      eventIds.emplace(t.event, static_cast<std::uint32_t>(eventIds.size()));
+    }
+
+    const std::size_t numStates = states.size();
+    const std::size_t numWords  = StateSet(numStates).words.size();
+    plainSources.assign(eventIds.size(), StateSet(numStates));
+    rowOf.assign(eventIds.size() * numStates, NoId);
+    special.resize(eventIds.size());
+
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      const auto e = eventIds.at(transitions[i].event);
+      if (!isPlain(transitions[i])) {
+        special[e].push_back(static_cast<std::uint32_t>(i));
+        continue;
+      }
+      auto &row = rowOf[e * numStates + sourceOf[i]];
+      if (row == NoId) {
+        row = static_cast<std::uint32_t>(rowWords.size() / numWords);
+        rowWords.resize(rowWords.size() + numWords, 0);
+        plainSources[e].set(sourceOf[i]);
+      }
+      rowWords[row * numWords + targetOf[i] / 64] |= std::uint64_t{1} << (targetOf[i] % 64);
+    }
+
+    active  = StateSet(numStates);
+    next    = StateSet(numStates);
+    handled = StateSet(numStates);
+    for (const auto &s : initialStates) {
+      active.set(stateIds.at(s));
+    }
+  }
+
+  StateMachine(const State &                  initialState,
+               const std::vector<Transition> &transitions,
+               Unmatched                      unmatched = Unmatched::drop)
+      : StateMachine(std::vector<State>{initialState}, transitions, unmatched) {}
+
+  void trigger(const Event &event) {
+    fired.clear();
+
+    const auto found = eventIds.find(event);
+    if (found == eventIds.end()) {
+      if (unmatched == Unmatched::drop) { active.clear(); }
+      return;
+    }
+    const auto e = found->second;
+
+    const std::size_t numStates = states.size();
+    const std::size_t numWords  = active.words.size();
+    next.clear();
+    for (std::size_t w = 0; w < numWords; w++) {
+      for (auto bits = active.words[w] & plainSources[e].words[w]; bits != 0; bits &= bits - 1) {
+        const auto  s   = w * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+        const auto *row = &rowWords[rowOf[e * numStates + s] * numWords];
+        for (std::size_t v = 0; v < numWords; v++) {
+          next.words[v] |= row[v];
+        }
+      }
+    }
+
+    if (unmatched == Unmatched::stay) { handled = plainSources[e]; }
+    for (const auto i : special[e]) {
+      if (!active.test(sourceOf[i])) { continue; }
+      auto &t = transitions[i];
+      if constexpr (Transition::HasGuard()) {
+        if (!isNull(t.guard) && !t.guard()) { continue; }
+      }
+      if constexpr (Transition::HasAction()) {
+        if (!isNull(t.action)) { t.action(); }
+      }
+      fired.push_back(i);
+      next.set(targetOf[i]);
+      if (unmatched == Unmatched::stay) { handled.set(sourceOf[i]); }
+    }
+
+    if (unmatched == Unmatched::stay) {
+      for (std::size_t w = 0; w < numWords; w++) {
+        next.words[w] |= active.words[w] & ~handled.words[w];
+      }
+    }
+    std::swap(active, next);
+  }
+
+  bool isActive(const State &state) const {
+    const auto found = stateIds.find(state);
+    return found != stateIds.end() && active.test(found->second);
+  }
+
+  std::vector<State> currentStates() const {
+    std::vector<State> result;
+    active.forEach([&](std::size_t s) { result.push_back(states[s]); });
+    return result;
+  }
+
+  // helper functions
+  std::uint32_t intern(const State &s) {
+    const auto [found, isNew] = stateIds.emplace(s, static_cast<std::uint32_t>(states.size()));
+    if (isNew) { states.push_back(s); }
+    return found->second;
+  }
+
+  static bool isPlain(const Transition &t) {
+    bool hasGuardOrAction = false;
+    if constexpr (Transition::HasGuard()) { hasGuardOrAction |= !isNull(t.guard); }
+    if constexpr (Transition::HasAction()) { hasGuardOrAction |= !isNull(t.action); }
+    return !hasGuardOrAction;
+  }
+};
+
+} // namespace susml::nfa
+
+#endif
@@ -0,0 +1,151 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PACKED_HPP
+#define PACKED_HPP
+
+#include "common.hpp"
+#include "interning.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace susml::packed {
+
+// Array of unsigned integers of width bits each (at most 32), packed into 64-bit words.
+struct PackedArray {
+  unsigned                   width = 0;
+  std::size_t                size  = 0;
+  std::vector<std::uint64_t> words;
+
+  PackedArray() = default;
+  PackedArray(std::size_t size, unsigned width)
+      : width(width), size(size), words((size * width + 63) / 64 + 1, 0) {}
+
+  // number of bits needed to store the values 0..count-1 (at least 1)
+  static constexpr unsigned bitsFor(std::size_t count) {
+    unsigned bits = 1;
+    while (bits < 32 && (std::size_t{1} << bits) < count) {
+      bits++;
+    }
+    return bits;
+  }
+
+  std::uint32_t get(std::size_t index) const {
+    const std::size_t bit    = index * width;
+    const std::size_t word   = bit / 64;
+    const unsigned    offset = bit % 64;
+
+    std::uint64_t value = words[word] >> offset;
+    if (offset + width > 64) { value |= words[word + 1] << (64 - offset); }
+    return static_cast<std::uint32_t>(value & ((std::uint64_t{1} << width) - 1));
+  }
+
+  void set(std::size_t index, std::uint32_t value) {
+    const std::size_t   bit    = index * width;
+    const std::size_t   word   = bit / 64;
+    const unsigned      offset = bit % 64;
+    const std::uint64_t mask   = (std::uint64_t{1} << width) - 1;
+
+    words[word] = (words[word] & ~(mask << offset)) | (std::uint64_t{value} << offset);
+    if (offset + width > 64) {
+      const unsigned spill = 64 - offset;
+      words[word + 1] = (words[word + 1] & ~(mask >> spill)) | (std::uint64_t{value} >> spill);
+    }
+  }
+
+  // memory used, in bytes
+  std::size_t bytes() const { return words.size() * sizeof(std::uint64_t); }
+};
+
+// Frozen state machine that interns its states and events into dense ids of as few bits as the
+// number of distinct states and events requires. The transitions are grouped by source state, so
+// the candidates of the current state are a contiguous range of bit-packed (event, target) records:
+// with up to 256 distinct events, 64 candidate keys fit in a single cache line. Guards and actions
+// are kept in the (reordered) transitions. Requires std::hash for the State and Event types.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  State         currentState;
+  std::uint32_t currentId = 0;
+
+  std::vector<Transition>    transitions; // grouped by source, otherwise in order
+  std::vector<State>         states;      // indexed by state id
+  interning::IdMap<Event>    eventIds;    // event to event id, by table if events are dense
+  std::vector<std::uint32_t> offsets;     // state s: [offsets[s], offsets[s+1])
+  PackedArray                events;      // event id of each transition
+  PackedArray                targets;     // target state id of each transition
+
+  static constexpr std::uint32_t NoEvent = interning::NoId;
+
+  StateMachine(const State &initialState, const std::vector<Transition> &unpacked)
+      : currentState(initialState) {
+    interning::Interner<State> stateIds;
+    currentId = stateIds.intern(initialState);
+
+    std::vector<std::uint32_t> sources;
+    sources.reserve(unpacked.size());
+    for (const auto &t : unpacked) {
+      sources.push_back(stateIds.intern(t.source));
+      stateIds.intern(t.target);
+      eventIds.intern(t.event);
+    }
+    const auto order = interning::groupByKey(sources, stateIds.size(), offsets);
+
+    // integral and enum events are resolved with a table rather than by hashing
+    eventIds.index();
+
+    events  = PackedArray(unpacked.size(), PackedArray::bitsFor(eventIds.size()));
+    targets = PackedArray(unpacked.size(), PackedArray::bitsFor(stateIds.size()));
+    transitions.reserve(unpacked.size());
+    for (std::size_t i = 0; i < order.size(); i++) {
+      const auto &t = unpacked[order[i]];
+      transitions.push_back(t);
+      events.set(i, eventIds.find(t.event));
+      targets.set(i, stateIds.find(t.target));
+    }
+    states = std::move(stateIds.values);
+  }
+
+  constexpr void trigger(const Event &event) {
+    const auto e = eventId(event);
+    if (e == NoEvent) { return; }
+
+    for (auto i = offsets[currentId]; i < offsets[currentId + 1]; i++) {
+      if (events.get(i) != e) { continue; }
+      if constexpr (Transition::HasGuard()) {
+        if (!transitions[i].guard()) { continue; }
+      }
+      if constexpr (Transition::HasAction()) { transitions[i].action(); }
+      currentId    = targets.get(i);
+      currentState = states[currentId];
+      return;
+    }
+  }
+
+  // helper functions
+  std::uint32_t eventId(const Event &event) const { return eventIds.find(event); }
+
+  // memory used by the keys of the transitions, in bytes
+  constexpr std::size_t keyBytes() const {
+    return offsets.size() * sizeof(std::uint32_t) + events.bytes() + targets.bytes();
+  }
+};
+
+} // namespace susml::packed
+
+#endif
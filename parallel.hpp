@@ -0,0 +1,205 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "common.hpp"
+#include "interning.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace susml::parallel {
+
+constexpr std::uint32_t NoId = interning::NoId;
+
+// Dense transition table of a guardless machine: the next state id and the transition (index + 1,
+// or 0 if none) for every state id and event id. Events without transition leave the state as is.
+template <typename TransitionT>
+struct Table {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  interning::Interner<State> states;   // to and from state ids
+  interning::IdMap<Event>    eventIds; // event to event id, by table if events are dense
+  std::size_t                numEvents = 0;
+  std::vector<std::uint32_t> targets; // [state * numEvents + event]
+  std::vector<std::uint32_t> taken;   // [state * numEvents + event]
+
+  Table(const State &initialState, const std::vector<Transition> &transitions) {
+    states.intern(initialState);
+    for (const auto &t : transitions) {
+      states.intern(t.source);
+      states.intern(t.target);
+      eventIds.intern(t.event);
+    }
+    numEvents = eventIds.size();
+    eventIds.index();
+
+    targets.resize(states.size() * numEvents);
+    taken.assign(states.size() * numEvents, 0);
+    for (std::uint32_t s = 0; s < states.size(); s++) {
+      std::fill_n(targets.begin() + s * numEvents, numEvents, s);
+    }
+    for (std::size_t i = transitions.size(); i-- > 0;) { // earlier transitions win
+      const auto &t    = transitions[i];
+      const auto  cell = states.find(t.source) * numEvents + eventIds.find(t.event);
+      targets[cell]    = states.find(t.target);
+      taken[cell]      = static_cast<std::uint32_t>(i + 1);
+    }
+  }
+
+  std::uint32_t eventId(const Event &event) const { return eventIds.find(event); }
+
+  // Returns the state id reached from state id s after the events [first, last), calling
+  // onTaken(transition index) for every transition that is taken.
+  template <typename It, typename OnTaken>
+  std::uint32_t run(std::uint32_t s, It first, It last, OnTaken &&onTaken) const {
+    for (; first != last; ++first) {
+      const auto e = eventId(*first);
+      if (e == NoId) { continue; }
+      const auto cell = s * numEvents + e;
+      if (taken[cell] != 0) { onTaken(taken[cell] - 1); }
+      s = targets[cell];
+    }
+    return s;
+  }
+
+  // Returns the state id reached after the events [first, last) from every state id at once (the
+  // transition function of the events). Runs from all states simultaneously, and every so often
+  // merges the runs that have arrived in the same state, so once all runs have converged this
+  // costs no more than a single run.
+  template <typename It>
+  std::vector<std::uint32_t> map(It first, It last) const {
+    const auto numStates = static_cast<std::uint32_t>(states.size());
+
+    std::vector<std::uint32_t> runOf(numStates);   // start state id to run
+    std::vector<std::uint32_t> current(numStates); // current state id of each run
+    for (std::uint32_t s = 0; s < numStates; s++) {
+      runOf[s]   = s;
+      current[s] = s;
+    }
+
+    std::vector<std::uint32_t> runIn(numStates, NoId); // run that is in a state, for merging
+    std::vector<std::uint32_t> merged(numStates);       // old run to merged run
+    std::size_t                n = 0;
+    for (; first != last; ++first, ++n) {
+      const auto e = eventId(*first);
+      if (e == NoId) { continue; }
+      for (auto &s : current) {
+        s = targets[s * numEvents + e];
+      }
+
+      if (n % 64 != 63 || current.size() == 1) { continue; }
+      std::size_t numRuns = 0;
+      for (std::size_t r = 0; r < current.size(); r++) {
+        auto &run = runIn[current[r]];
+        if (run == NoId) {
+          run                = static_cast<std::uint32_t>(numRuns);
+          current[numRuns++] = current[r];
+        }
+        merged[r] = run;
+      }
+      for (std::size_t r = 0; r < numRuns; r++) {
+        runIn[current[r]] = NoId;
+      }
+      current.resize(numRuns);
+      for (auto &run : runOf) {
+        run = merged[run];
+      }
+    }
+
+    std::vector<std::uint32_t> result(numStates);
+    for (std::uint32_t s = 0; s < numStates; s++) {
+      result[s] = current[runOf[s]];
+    }
+    return result;
+  }
+};
+
+// Triggers all events in [first, last) on a guardless machine, using up to numThreads threads.
+// The events are split into one chunk per thread. In parallel, each chunk (except the first) is
+// run from every state at once to find the mapping from start to end state it induces. Composing
+// those mappings in order gives the correct start state of each chunk. If the transitions have
+// actions, the other chunks are then run once more, in parallel, from their correct start states
+// to fire the actions.
+//
+// The actions of a chunk are fired in order, but those of different chunks concurrently, so
+// actions must be safe to call from multiple threads and must not depend on the order in which
+// chunks are processed (e.g. incrementing atomic counters).
+//
+// Works for any machine with currentState and transitions members (e.g. vectorbased or alphabet).
+// Requires std::hash for the State and Event types, and random access iterators.
+template <typename StateMachine, typename It>
+void run(StateMachine &machine,
+         It            first,
+         It            last,
+         std::size_t   numThreads = std::thread::hardware_concurrency()) {
+  using Transition = typename StateMachine::Transition;
+
+  static_assert(!Transition::HasGuard(), "Only guardless machines can be run in parallel.");
+
+  const Table<Transition> table(machine.currentState, machine.transitions);
+
+  auto fire = [&](std::uint32_t i) {
+    if constexpr (Transition::HasAction()) { machine.transitions[i].action(); }
+  };
+
+  const auto        size      = static_cast<std::size_t>(std::distance(first, last));
+  const std::size_t numChunks = std::max<std::size_t>(1, std::min(numThreads, size / 1024));
+  if (numChunks == 1) {
+    machine.currentState = table.states.value(table.run(0, first, last, fire));
+    return;
+  }
+
+  auto chunk = [&](std::size_t c) {
+    return first + static_cast<std::ptrdiff_t>(size * c / numChunks);
+  };
+
+  // the first chunk starts from a known state (id 0) and is simply run, the others are mapped
+  std::vector<std::uint32_t>              starts(numChunks + 1, 0);
+  std::vector<std::vector<std::uint32_t>> mappings(numChunks);
+  {
+    std::vector<std::thread> threads;
+    for (std::size_t c = 1; c < numChunks; c++) {
+      threads.emplace_back([&, c] { mappings[c] = table.map(chunk(c), chunk(c + 1)); });
+    }
+    starts[1] = table.run(0, chunk(0), chunk(1), fire);
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+  for (std::size_t c = 1; c < numChunks; c++) {
+    starts[c + 1] = mappings[c][starts[c]];
+  }
+
+  if constexpr (Transition::HasAction()) {
+    std::vector<std::thread> threads;
+    for (std::size_t c = 1; c < numChunks; c++) {
+      threads.emplace_back([&, c] { table.run(starts[c], chunk(c), chunk(c + 1), fire); });
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+  machine.currentState = table.states.value(starts[numChunks]);
+}
+
+} // namespace susml::parallel
+
+#endif
@@ -0,0 +1,151 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef REACTIVE_HPP
+#define REACTIVE_HPP
+
+#include "common.hpp"
+#include "guards.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace susml::reactive {
+
+// Change flags of a group of observable inputs, one bit per input. Bit 62 is set whenever the
+// machine takes a transition (so the guards of the new state are evaluated at least once), and bit
+// 63 stands for guards that read variables that are not observable inputs, and is never cleared.
+struct Changes {
+  static constexpr std::size_t   MaxInputs = 62;
+  static constexpr std::uint64_t Entered   = std::uint64_t{1} << 62;
+  static constexpr std::uint64_t Untracked = std::uint64_t{1} << 63;
+
+  std::uint64_t             bits = ~std::uint64_t{0};
+  std::vector<const void *> addresses; // of the value of each input, indexed by bit
+
+  // bit of the input whose value is at address, or Untracked if there is none
+  std::uint64_t bitOf(const void *address) const {
+    const auto found = std::find(addresses.begin(), addresses.end(), address);
+    return (found == addresses.end())
+               ? Untracked
+               : std::uint64_t{1} << static_cast<std::size_t>(found - addresses.begin());
+  }
+};
+
+// Input variable that flags itself in its Changes when it is set to a different value. Inputs
+// beyond the first MaxInputs of a group are not tracked, and count as always changed. An input is
+// registered by address, so it can be neither copied nor moved.
+template <typename T>
+struct Input {
+  T             value;
+  Changes *     changes;
+  std::uint64_t bit;
+
+  Input(Changes &changes, const T &initial) : value(initial), changes(&changes) {
+    if (changes.addresses.size() < Changes::MaxInputs) {
+      bit = std::uint64_t{1} << changes.addresses.size();
+      changes.addresses.push_back(&value);
+    } else {
+      bit = Changes::Untracked;
+    }
+  }
+
+  Input(const Input &) = delete;
+  Input &operator=(const Input &) = delete;
+
+  constexpr const T &get() const { return value; }
+
+  constexpr void set(const T &newValue) {
+    if (newValue == value) { return; }
+    value = newValue;
+    changes->bits |= bit;
+  }
+
+  constexpr Input &operator=(const T &newValue) {
+    set(newValue);
+    return *this;
+  }
+};
+
+// Refers to an input in a guard expression, like guards::var does for plain variables.
+constexpr guards::expression::Var<bool> var(const Input<bool> &input) { return {&input.value}; }
+constexpr guards::expression::Var<int>  var(const Input<int> &input) { return {&input.value}; }
+
+// State machine that re-evaluates its guards only when an input they read has changed. It runs
+// like a guards::StateMachine, but also knows the change event: the event that a polling machine
+// would trigger after every input update (e.g. update in the encoder example). Calling update()
+// after updating inputs has the same effect as triggering the change event, but per state the
+// machine knows which inputs the guards of its transitions on the change event read, so an update
+// that changed none of them (and did not follow a transition) costs a single test of the change
+// bits. The number of such skipped updates is counted in numSkippedUpdates.
+//
+// The machine clears the change bits when it evaluates its guards, so a group of inputs must be
+// observed by a single machine. Requires std::hash for the State and Event types.
+template <typename TransitionT>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+
+  guards::StateMachine<Transition> machine;
+  Changes *                        changes;
+  Event                            changeEvent;
+  std::vector<std::uint64_t>       watched; // per state id: change bits read by its guards
+
+  std::size_t numSkippedUpdates = 0;
+
+  StateMachine(const State &                  initialState,
+               const std::vector<Transition> &transitions,
+               Changes &                      changes,
+               const Event &                  changeEvent)
+      : machine(initialState, transitions), changes(&changes), changeEvent(changeEvent) {
+    if (!machine.isCompiled) { // the current state id stays 0, so always evaluate
+      watched.assign(1, Changes::Untracked);
+      return;
+    }
+
+    watched.assign(machine.stateIds.size(), 0);
+    for (const auto &t : machine.transitions) {
+      if (!(t.event == changeEvent)) { continue; }
+      auto &bits = watched[machine.stateIds.find(t.source)];
+      bits |= Changes::Entered;
+      for (const auto &atom : t.guard.dnf.atoms) {
+        bits |= changes.bitOf((atom.flag != nullptr) ? static_cast<const void *>(atom.flag)
+                                                     : static_cast<const void *>(atom.number));
+      }
+    }
+  }
+
+  const State &currentState() const { return machine.currentState; }
+
+  // Triggers the change event, unless nothing it depends on in the current state has changed.
+  void update() {
+    if ((changes->bits & watched[machine.currentId]) == 0) {
+      numSkippedUpdates++;
+      return;
+    }
+    changes->bits = Changes::Untracked;
+    trigger(changeEvent);
+  }
+
+  void trigger(const Event &event) {
+    const auto numUnhandled = machine.numUnhandledEvents;
+    machine.trigger(event);
+    if (machine.numUnhandledEvents == numUnhandled) { changes->bits = ~std::uint64_t{0}; }
+  }
+};
+
+} // namespace susml::reactive
+
+#endif
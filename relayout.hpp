@@ -0,0 +1,282 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef RELAYOUT_HPP
+#define RELAYOUT_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace susml::relayout {
+
+enum class Order {
+  breadthFirst,        // in the order states are reached from the current state
+  reverseCuthillMcKee, // minimizes the distance between the ids of connected states
+  profile,             // follows the hottest transitions first, requires transition counts
+};
+
+template <typename StateMachineT>
+struct Relayout {
+  using StateMachine = StateMachineT;
+  using State        = typename StateMachine::State;
+
+  StateMachine machine;
+
+  std::vector<State>               toOriginal;   // indexed by new state id
+  std::unordered_map<State, State> fromOriginal; // original state to new state
+};
+
+// Counts how often each transition is taken when running the given events from the initial state,
+// following the same first-match rule as the engines (guards are not evaluated, so this is only
+// exact for guardless machines). Use the result as profile for renumber().
+template <typename Transition, typename Events>
+std::vector<std::size_t> countTransitions(const std::vector<Transition> &transitions,
+                                          typename Transition::State     state,
+                                          const Events &                 events) {
+  using State = typename Transition::State;
+  using Event = typename Transition::Event;
+
+  std::map<std::pair<State, Event>, std::size_t> first;
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    first.emplace(std::make_pair(transitions[i].source, transitions[i].event), i);
+  }
+
+  std::vector<std::size_t> counts(transitions.size(), 0);
+  for (const auto &event : events) {
+    const auto found = first.find(std::make_pair(state, event));
+    if (found == first.end()) { continue; }
+    counts[found->second]++;
+    state = transitions[found->second].target;
+  }
+  return counts;
+}
+
+namespace detail {
+template <typename State>
+struct Graph {
+  std::vector<State>                     states;
+  std::unordered_map<State, std::size_t> ids;
+  std::vector<std::vector<std::size_t>>  successors; // transition indices
+  std::vector<std::size_t>               degree;     // in + out
+
+  std::size_t add(const State &s) {
+    const auto [found, isNew] = ids.emplace(s, states.size());
+    if (isNew) {
+      states.push_back(s);
+      successors.emplace_back();
+      degree.push_back(0);
+    }
+    return found->second;
+  }
+};
+
+template <typename State, typename Transition>
+Graph<State> makeGraph(const std::vector<Transition> &transitions, const State &initial) {
+  Graph<State> g;
+  g.add(initial);
+  for (std::size_t i = 0; i < transitions.size(); i++) {
+    const auto s = g.add(transitions[i].source);
+    const auto t = g.add(transitions[i].target);
+    g.successors[s].push_back(i);
+    g.degree[s]++;
+    g.degree[t]++;
+  }
+  return g;
+}
+
+template <typename State, typename Transition>
+std::vector<std::size_t> breadthFirst(const Graph<State> &             g,
+                                      const std::vector<Transition> &transitions) {
+  std::vector<std::size_t> order;
+  std::vector<bool>        isPlaced(g.states.size(), false);
+  for (std::size_t root = 0; root < g.states.size(); root++) { // root 0 is the initial state
+    if (isPlaced[root]) { continue; }
+    isPlaced[root] = true;
+    order.push_back(root);
+    for (std::size_t next = order.size() - 1; next < order.size(); next++) {
+      for (const auto i : g.successors[order[next]]) {
+        const auto t = g.ids.at(transitions[i].target);
+        if (!isPlaced[t]) {
+          isPlaced[t] = true;
+          order.push_back(t);
+        }
+      }
+    }
+  }
+  return order;
+}
+
+template <typename State, typename Transition>
+std::vector<std::size_t> reverseCuthillMcKee(const Graph<State> &             g,
+                                             const std::vector<Transition> &transitions) {
+  // undirected neighbours, sorted by degree
+  std::vector<std::vector<std::size_t>> neighbours(g.states.size());
+  for (std::size_t s = 0; s < g.states.size(); s++) {
+    for (const auto i : g.successors[s]) {
+      const auto t = g.ids.at(transitions[i].target);
+      if (t == s) { continue; }
+      neighbours[s].push_back(t);
+      neighbours[t].push_back(s);
+    }
+  }
+  for (auto &n : neighbours) {
+    std::sort(n.begin(), n.end(), [&](std::size_t a, std::size_t b) {
+      return std::make_pair(g.degree[a], a) < std::make_pair(g.degree[b], b);
+    });
+    n.erase(std::unique(n.begin(), n.end()), n.end());
+  }
+
+  std::vector<std::size_t> byDegree(g.states.size());
+  for (std::size_t s = 0; s < byDegree.size(); s++) {
+    byDegree[s] = s;
+  }
+  std::stable_sort(byDegree.begin(), byDegree.end(), [&](std::size_t a, std::size_t b) {
+    return g.degree[a] < g.degree[b];
+  });
+
+  std::vector<std::size_t> order;
+  std::vector<bool>        isPlaced(g.states.size(), false);
+  for (const auto root : byDegree) {
+    if (isPlaced[root]) { continue; }
+    isPlaced[root] = true;
+    order.push_back(root);
+    for (std::size_t next = order.size() - 1; next < order.size(); next++) {
+      for (const auto t : neighbours[order[next]]) {
+        if (!isPlaced[t]) {
+          isPlaced[t] = true;
+          order.push_back(t);
+        }
+      }
+    }
+  }
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+// Greedily lays out chains of hot transitions: from the last placed state, continue with the target
+// of its hottest transition to a state that is not yet placed. When stuck, restart from the hottest
+// transition (from any placed state) to an unplaced state, or the first unplaced state otherwise.
+template <typename State, typename Transition>
+std::vector<std::size_t> profile(const Graph<State> &             g,
+                                 const std::vector<Transition> &transitions,
+                                 const std::vector<std::size_t> &counts) {
+  std::vector<std::size_t> order;
+  std::vector<bool>        isPlaced(g.states.size(), false);
+
+  // candidates to restart from, hottest first
+  std::vector<std::size_t> byCount(transitions.size());
+  for (std::size_t i = 0; i < byCount.size(); i++) {
+    byCount[i] = i;
+  }
+  std::stable_sort(byCount.begin(), byCount.end(), [&](std::size_t a, std::size_t b) {
+    return counts[a] > counts[b];
+  });
+  std::size_t nextCandidate = 0;
+  std::size_t nextUnplaced  = 0;
+
+  std::size_t current = 0; // the initial state
+  while (true) {
+    isPlaced[current] = true;
+    order.push_back(current);
+    if (order.size() == g.states.size()) { break; }
+
+    std::size_t hottest = g.states.size();
+    std::size_t heat    = 0;
+    for (const auto i : g.successors[current]) {
+      const auto t = g.ids.at(transitions[i].target);
+      if (!isPlaced[t] && (hottest == g.states.size() || counts[i] > heat)) {
+        hottest = t;
+        heat    = counts[i];
+      }
+    }
+
+    while (hottest == g.states.size() && nextCandidate < byCount.size()) {
+      const auto &t = transitions[byCount[nextCandidate++]];
+      const auto  s = g.ids.at(t.source);
+      const auto  u = g.ids.at(t.target);
+      if (isPlaced[s] && !isPlaced[u]) { hottest = u; }
+    }
+    while (hottest == g.states.size()) {
+      if (!isPlaced[nextUnplaced]) { hottest = nextUnplaced; }
+      nextUnplaced++;
+    }
+    current = hottest;
+  }
+  return order;
+}
+} // namespace detail
+
+// Renumbers the states of a machine to 0..N-1 in the given order, such that states that are often
+// visited after one another get adjacent ids (and thereby adjacent rows in any table indexed by
+// state). The transitions are sorted (stably) by their new source, so transitions of the same
+// state are adjacent as well. Works for any machine that can be constructed from an initial state
+// and a vector of transitions, and whose State type can be constructed from an integer.
+template <typename StateMachine>
+Relayout<StateMachine> renumber(const StateMachine &            machine,
+                                Order                           order,
+                                const std::vector<std::size_t> &counts = {}) {
+  using Transition = typename StateMachine::Transition;
+  using State      = typename StateMachine::State;
+
+  static_assert(isIndexable<State>(), "Only integral or enum states can be renumbered.");
+
+  const auto &transitions = machine.transitions;
+  const auto  graph       = detail::makeGraph(transitions, machine.currentState);
+
+  std::vector<std::size_t> newOrder;
+  switch (order) {
+  case Order::breadthFirst: newOrder = detail::breadthFirst(graph, transitions); break;
+  case Order::reverseCuthillMcKee:
+    newOrder = detail::reverseCuthillMcKee(graph, transitions);
+    break;
+  case Order::profile:
+    newOrder = (counts.size() == transitions.size())
+                   ? detail::profile(graph, transitions, counts)
+                   : detail::breadthFirst(graph, transitions);
+    break;
+  }
+
+  std::vector<std::size_t> newId(newOrder.size());
+  for (std::size_t i = 0; i < newOrder.size(); i++) {
+    newId[newOrder[i]] = i;
+  }
+  auto renamed = [&](const State &s) { return static_cast<State>(newId[graph.ids.at(s)]); };
+
+  std::vector<Transition> renumbered;
+  renumbered.reserve(transitions.size());
+  for (const auto &t : transitions) {
+    renumbered.push_back(t);
+    renumbered.back().source = renamed(t.source);
+    renumbered.back().target = renamed(t.target);
+  }
+  std::stable_sort(renumbered.begin(), renumbered.end(), [](const auto &a, const auto &b) {
+    return toIndex(a.source) < toIndex(b.source);
+  });
+
+  Relayout<StateMachine> result{StateMachine{renamed(machine.currentState), renumbered}, {}, {}};
+  for (const auto s : newOrder) {
+    result.toOriginal.push_back(graph.states[s]);
+    result.fromOriginal.emplace(graph.states[s], renamed(graph.states[s]));
+  }
+  return result;
+}
+
+} // namespace susml::relayout
+
+#endif
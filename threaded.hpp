@@ -0,0 +1,170 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef THREADED_HPP
+#define THREADED_HPP
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace susml::threaded {
+
+// Immutable machine that gives the states their own code to run their transitions, rather than
+// running all states through one loop: each state has a block of candidate transitions, in order
+// of priority, and a handler of its own that scans them. The handlers are NumSites copies of the
+// same function (instantiations for each site), handed out to the blocks in turn, so the branches
+// that test the event and guard of the candidates, and the indirect call that dispatches to the
+// handler, are separate branch sites per state for up to NumSites states, and shared by every
+// NumSites-th state beyond that. The candidates of a block are scanned in a loop, so the stack
+// does not grow with the number of candidates.
+// Candidates on an event after a guardless one on the same event are never taken, and are left
+// out.
+template <typename TransitionT, std::size_t NumSitesT = 64>
+struct StateMachine {
+  using Transition = TransitionT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+
+  static constexpr std::size_t NumSites = NumSitesT;
+
+  static_assert(isIndexable<State>(), "Threaded machines require an integral or enum State type.");
+  static_assert(NumSites > 0, "Threaded machines need at least one handler.");
+
+  struct Block;
+  using Handler = void (*)(StateMachine &, const Block &, const Event &, const Payload &);
+
+  struct Block {
+    Handler       handler;
+    std::uint32_t first; // candidates of the block: [first, last)
+    std::uint32_t last;
+  };
+
+  State                      currentState;
+  std::vector<Transition>    transitions; // grouped by source, otherwise in order
+  std::vector<std::uint32_t> candidates;  // per block, the transitions it tests, in order
+  std::vector<Block>         blocks;      // blocks[0] has no candidates, then one per source
+  std::vector<std::size_t>   sources;     // distinct sources in order, if sources are sparse
+  std::vector<std::uint32_t> entries;     // block of source s (or sources[s]), or 0 for none
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  // The transitions are taken by value, so a vector that is passed as an rvalue is moved into the
+  // machine (and then reordered) rather than copied.
+  StateMachine(const State &initialState, std::vector<Transition> unordered)
+      : currentState(initialState) {
+    const std::size_t n = unordered.size();
+
+    std::vector<std::size_t> order(n);
+    for (std::size_t i = 0; i < n; i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return toIndex(unordered[a].source) < toIndex(unordered[b].source);
+    });
+    transitions.reserve(n);
+    for (const auto i : order) {
+      transitions.push_back(std::move(unordered[i]));
+    }
+
+    const std::size_t maxSource = transitions.empty() ? 0 : toIndex(transitions.back().source);
+    const bool        isDense   = maxSource < 2 * n + 256;
+    if (isDense) { entries.assign(maxSource + 1, 0); }
+
+    constexpr auto handlers = makeHandlers(std::make_index_sequence<NumSites>{});
+    blocks.push_back({handlers[0], 0, 0});
+    for (std::size_t first = 0; first < n;) {
+      const auto source = toIndex(transitions[first].source);
+      auto       last   = first;
+      while (last < n && toIndex(transitions[last].source) == source) {
+        last++;
+      }
+
+      const auto entry = static_cast<std::uint32_t>(blocks.size());
+      if (isDense) {
+        entries[source] = entry;
+      } else {
+        sources.push_back(source);
+        entries.push_back(entry);
+      }
+
+      const auto handler = handlers[(entry - 1) % NumSites];
+      Block      block{handler, static_cast<std::uint32_t>(candidates.size()), 0};
+      std::vector<std::size_t> takenOn; // candidates without a guard, by which later ones are cut
+      for (auto i = first; i < last; i++) {
+        const auto &t           = transitions[i];
+        const bool  isReachable = std::none_of(takenOn.begin(), takenOn.end(), [&](std::size_t j) {
+          return transitions[j].event == t.event;
+        });
+        if (!isReachable) { continue; }
+        if (!Transition::HasGuard()) { takenOn.push_back(i); }
+        candidates.push_back(static_cast<std::uint32_t>(i));
+      }
+      block.last = static_cast<std::uint32_t>(candidates.size());
+      blocks.push_back(block);
+      first = last;
+    }
+  }
+
+  void trigger(const Event &event) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  void trigger(const Event &event, const Payload &payload) {
+    const Block &block = blocks[entryOf(currentState)];
+    block.handler(*this, block, event, payload);
+  }
+
+  // helper functions
+  std::uint32_t entryOf(const State &state) const {
+    const auto s = toIndex(state);
+    if (sources.empty()) { return (s < entries.size()) ? entries[s] : 0; }
+    const auto found = std::lower_bound(sources.begin(), sources.end(), s);
+    if (found == sources.end() || *found != s) { return 0; }
+    return entries[static_cast<std::size_t>(found - sources.begin())];
+  }
+
+  template <std::size_t... Sites>
+  static constexpr std::array<Handler, NumSites> makeHandlers(std::index_sequence<Sites...>) {
+    return {&run<Sites>...};
+  }
+
+  // handlers, one instantiation per site
+  template <std::size_t Site>
+  static void run(StateMachine &m, const Block &block, const Event &event, const Payload &payload) {
+    for (auto i = block.first; i < block.last; i++) {
+      auto &t = m.transitions[m.candidates[i]];
+      if (!(t.event == event)) { continue; }
+      if constexpr (Transition::HasGuard()) {
+        if (!t.isAllowed(payload)) { continue; }
+      }
+      if constexpr (Transition::HasAction()) { t.fire(payload); }
+      m.currentState = t.target;
+      return;
+    }
+    m.numUnhandledEvents++;
+  }
+};
+
+} // namespace susml::threaded
+
+#endif
@@ -0,0 +1,366 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef TIMED_HPP
+#define TIMED_HPP
+
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace susml::timed {
+
+// Intrusive, doubly linked timer node. A node is owned by whoever wants to be called back (e.g. a
+// state machine), so arming and cancelling a timer never allocates.
+struct TimerNode {
+  TimerNode *   prev   = nullptr;
+  TimerNode *   next   = nullptr;
+  std::uint64_t expiry = 0;
+  void (*callback)(void *) = nullptr;
+  void *        owner    = nullptr;
+
+  TimerNode() = default;
+  TimerNode(void (*callback)(void *), void *owner) : callback(callback), owner(owner) {}
+
+  TimerNode(const TimerNode &) = delete;
+  TimerNode &operator=(const TimerNode &) = delete;
+
+  // a moved-to node takes over the moved-from node's place in the wheel
+  TimerNode(TimerNode &&other) noexcept
+      : expiry(other.expiry), callback(other.callback), owner(other.owner) {
+    if (other.isArmed()) {
+      prev       = other.prev;
+      next       = other.next;
+      prev->next = this;
+      next->prev = this;
+      other.prev = nullptr;
+      other.next = nullptr;
+    }
+  }
+  TimerNode &operator=(TimerNode &&) = delete;
+
+  ~TimerNode() { unlink(); }
+
+  constexpr bool isArmed() const { return next != nullptr; }
+
+  void unlink() {
+    if (isArmed()) {
+      prev->next = next;
+      next->prev = prev;
+      prev       = nullptr;
+      next       = nullptr;
+    }
+  }
+};
+
+// Clock that only moves when told to, for deterministic tests and benchmarks.
+struct ManualClock {
+  using duration   = std::chrono::nanoseconds;
+  using rep        = duration::rep;
+  using period     = duration::period;
+  using time_point = std::chrono::time_point<ManualClock>;
+
+  time_point currentTime{};
+
+  constexpr time_point now() const { return currentTime; }
+
+  template <typename Duration>
+  constexpr void advance(Duration delta) {
+    currentTime += std::chrono::duration_cast<duration>(delta);
+  }
+};
+
+// Hierarchical timing wheel (Varghese & Lauck) with NumLevels levels of 64 slots each. A timer is
+// placed in the level corresponding to the highest bit in which its expiry tick differs from the
+// current tick, so arming and cancelling are O(1). Whenever the lower levels wrap around, the
+// timers in the corresponding slot of the next level are cascaded down.
+template <typename ClockT = std::chrono::steady_clock>
+struct TimerWheel {
+  using Clock     = ClockT;
+  using Duration  = typename Clock::duration;
+  using TimePoint = typename Clock::time_point;
+
+  static constexpr std::size_t   SlotBits  = 6;
+  static constexpr std::size_t   NumSlots  = std::size_t{1} << SlotBits;
+  static constexpr std::size_t   NumLevels = 8;
+  static constexpr std::uint64_t MaxDelay  = (std::uint64_t{1} << (SlotBits * NumLevels)) - 1;
+
+  Clock         clock;
+  Duration      resolution;
+  TimePoint     start;
+  std::uint64_t currentTick = 0;
+  std::size_t   numArmed    = 0;
+
+  // each slot is the sentinel of a circular list
+  std::array<std::array<TimerNode, NumSlots>, NumLevels> slots;
+
+  explicit TimerWheel(Clock c = {}, Duration resolution = std::chrono::milliseconds(1))
+      : clock(c), resolution(resolution), start(clock.now()) {
+    for (auto &level : slots) {
+      for (auto &sentinel : level) {
+        sentinel.prev = &sentinel;
+        sentinel.next = &sentinel;
+      }
+    }
+  }
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  ~TimerWheel() {
+    for (auto &level : slots) {
+      for (auto &sentinel : level) {
+        while (sentinel.next != &sentinel) { sentinel.next->unlink(); }
+        sentinel.prev = nullptr;
+        sentinel.next = nullptr;
+      }
+    }
+  }
+
+  // number of ticks in a duration, rounded up such that timers never fire early
+  template <typename D>
+  std::uint64_t toTicks(D delay) const {
+    const auto d = std::chrono::duration_cast<Duration>(delay);
+    if (d.count() <= 0) { return 0; }
+    return static_cast<std::uint64_t>((d.count() + resolution.count() - 1) / resolution.count());
+  }
+
+  // Arms the timer such that it fires after the given number of ticks (at least one).
+  void arm(TimerNode &node, std::uint64_t delayTicks) {
+    cancel(node);
+    node.expiry = currentTick + std::min(std::max(delayTicks, std::uint64_t{1}), MaxDelay);
+    insert(node);
+    numArmed++;
+  }
+
+  void cancel(TimerNode &node) {
+    if (node.isArmed()) {
+      node.unlink();
+      numArmed--;
+    }
+  }
+
+  // The current time according to the clock, in ticks rounded up, such that timers armed from it
+  // never fire early. This runs ahead of currentTick until the next poll(), and falls behind it
+  // when the wheel is advanced without the clock (with advanceTo()), in which case it is
+  // currentTick.
+  std::uint64_t now() const {
+    const auto elapsed = std::chrono::duration_cast<Duration>(clock.now() - start);
+    return std::max(currentTick, toTicks(elapsed));
+  }
+
+  // Advances the wheel up to the current time according to the clock.
+  void poll() {
+    const auto elapsed = std::chrono::duration_cast<Duration>(clock.now() - start);
+    advanceTo(static_cast<std::uint64_t>(elapsed.count() / resolution.count()));
+  }
+
+  void advanceTo(std::uint64_t tick) {
+    if (numArmed == 0 && tick > currentTick) {
+      // nothing can fire, skip straight to the target (all slots are empty, so no cascading)
+      currentTick = tick;
+      return;
+    }
+    while (currentTick < tick) { step(); }
+  }
+
+  // helper functions
+  void insert(TimerNode &node) {
+    const std::uint64_t diff  = node.expiry ^ currentTick;
+    std::size_t         level = 0;
+    while (level + 1 < NumLevels && (diff >> (SlotBits * (level + 1))) != 0) { level++; }
+    const std::size_t slot = (node.expiry >> (SlotBits * level)) & (NumSlots - 1);
+
+    TimerNode &sentinel = slots[level][slot];
+    node.prev           = sentinel.prev;
+    node.next           = &sentinel;
+    sentinel.prev->next = &node;
+    sentinel.prev       = &node;
+  }
+
+  // moves all nodes of a slot into a local list, so callbacks can safely (re)arm and cancel timers
+  static void detach(TimerNode &sentinel, TimerNode &list) {
+    list.prev = &list;
+    list.next = &list;
+    if (sentinel.next == &sentinel) { return; }
+    list.next       = sentinel.next;
+    list.prev       = sentinel.prev;
+    list.next->prev = &list;
+    list.prev->next = &list;
+    sentinel.next   = &sentinel;
+    sentinel.prev   = &sentinel;
+  }
+
+  void step() {
+    currentTick++;
+
+    TimerNode list;
+    for (std::size_t level = NumLevels - 1; level > 0; level--) {
+      const std::uint64_t lowerMask = (std::uint64_t{1} << (SlotBits * level)) - 1;
+      if ((currentTick & lowerMask) != 0) { continue; }
+
+      const std::size_t slot = (currentTick >> (SlotBits * level)) & (NumSlots - 1);
+      detach(slots[level][slot], list);
+      while (list.next != &list) {
+        TimerNode &node = *list.next;
+        node.unlink();
+        insert(node);
+      }
+    }
+
+    detach(slots[0][currentTick & (NumSlots - 1)], list);
+    while (list.next != &list) {
+      TimerNode &node = *list.next;
+      node.unlink();
+      numArmed--;
+      node.callback(node.owner);
+    }
+    list.prev = nullptr;
+    list.next = nullptr;
+  }
+};
+
+// State machine with time-triggered transitions in addition to regular event-triggered ones. Each
+// instance owns a single intrusive timer, armed on entering a state that has a timeout and
+// cancelled on leaving it, so many instances can share one wheel without allocating per timer.
+//
+// Timeout transitions are regular Transitions with Timeout<Duration> as event (see After(...) in
+// factory.hpp). Of the timeouts from a state, those with the shortest delay fire first (the first
+// of those whose guard passes is taken), if none is taken the next longer delay is armed.
+// Time in a state counts from the clock's time at the trigger that entered it (see
+// TimerWheel::now()), or from the expiry of the timeout that entered it. Every transition that is
+// taken enters its target anew, so self-transitions restart the state's timeouts, whether they
+// are triggered by an event or by a timeout.
+//
+// NOTE: instances are not copyable, as each armed timer must belong to exactly one instance.
+template <typename TransitionT, typename TimeoutT, typename ClockT = std::chrono::steady_clock>
+struct StateMachine {
+  using Transition = TransitionT;
+  using Timeout    = TimeoutT;
+  using State      = typename Transition::State;
+  using Event      = typename Transition::Event;
+  using Wheel      = TimerWheel<ClockT>;
+
+  static_assert(std::is_same<State, typename Timeout::State>::value,
+                "Transitions and timeouts must have the same State type.");
+
+  State                                currentState;
+  std::vector<Transition>              transitions;
+  std::vector<Timeout>                 timeouts;
+  vectorbased::EventMask<State, Event> acceptedEvents;
+  Wheel *                              wheel;
+  TimerNode                            timer{&onTimer, this};
+  std::uint64_t                        enteredAt  = 0; // tick at which currentState was entered
+  std::uint64_t                        armedDelay = 0; // delay (in ticks) that the timer is armed for
+
+  StateMachine(Wheel &                        wheel,
+               const State &                  initialState,
+               const std::vector<Transition> &transitions,
+               const std::vector<Timeout> &   timeouts)
+      : currentState(initialState),
+        transitions(transitions),
+        timeouts(timeouts),
+        acceptedEvents(this->transitions),
+        wheel(&wheel) {
+    enter(initialState, wheel.now());
+  }
+
+  StateMachine(StateMachine &&other) noexcept
+      : currentState(std::move(other.currentState)),
+        transitions(std::move(other.transitions)),
+        timeouts(std::move(other.timeouts)),
+        acceptedEvents(std::move(other.acceptedEvents)),
+        wheel(other.wheel),
+        timer(std::move(other.timer)),
+        enteredAt(other.enteredAt),
+        armedDelay(other.armedDelay) {
+    timer.owner = this;
+  }
+
+  StateMachine(const StateMachine &) = delete;
+  StateMachine &operator=(const StateMachine &) = delete;
+  StateMachine &operator=(StateMachine &&) = delete;
+
+  ~StateMachine() { wheel->cancel(timer); }
+
+  constexpr bool isTransitionTakeable(Transition &t, const Event &event) {
+    if constexpr (Transition::HasGuard()) {
+      return t.source == currentState && t.event == event && t.guard();
+    }
+    if constexpr (!Transition::HasGuard()) { return t.source == currentState && t.event == event; }
+  }
+
+  void trigger(const Event &event) {
+    if (!acceptedEvents.accepts(currentState, event)) { return; }
+
+    for (auto &t : transitions) {
+      if (isTransitionTakeable(t, event)) {
+        if constexpr (Transition::HasAction()) { t.action(); }
+        enter(t.target, wheel->now());
+        return;
+      }
+    }
+  }
+
+  // helper functions
+  void enter(const State &state, std::uint64_t tick) {
+    currentState = state;
+    enteredAt    = tick;
+    armNext(0);
+  }
+
+  // arms the timer for the shortest timeout from the current state that is longer than minDelay
+  void armNext(std::uint64_t minDelay) {
+    wheel->cancel(timer);
+
+    bool found = false;
+    for (const auto &t : timeouts) {
+      if (!(t.source == currentState)) { continue; }
+      const auto delay = std::max(wheel->toTicks(t.event.delay), std::uint64_t{1});
+      if (delay > minDelay && (!found || delay < armedDelay)) {
+        armedDelay = delay;
+        found      = true;
+      }
+    }
+    if (found) { wheel->arm(timer, enteredAt + armedDelay - wheel->currentTick); }
+  }
+
+  void fireTimeout() {
+    const auto delay = armedDelay;
+    for (auto &t : timeouts) {
+      if (!(t.source == currentState) ||
+          std::max(wheel->toTicks(t.event.delay), std::uint64_t{1}) != delay) {
+        continue;
+      }
+      if constexpr (Timeout::HasGuard()) {
+        if (!t.guard()) { continue; }
+      }
+      if constexpr (Timeout::HasAction()) { t.action(); }
+      enter(t.target, wheel->currentTick); // the tick at which the timeout expired
+      return;
+    }
+    armNext(delay);
+  }
+
+  static void onTimer(void *owner) { static_cast<StateMachine *>(owner)->fireTimeout(); }
+};
+
+} // namespace susml::timed
+
+#endif
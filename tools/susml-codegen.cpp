@@ -0,0 +1,97 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Generates a standalone header with switch-based code for a machine definition, see codegen.hpp.
+//
+//   susml-codegen --table FILE | --dot FILE | --registered NAME  --namespace NS  [--output FILE]
+//
+// Definitions that are built in code are registered with codegen::Registration in source files
+// that are linked into the executable (listed in SUSML_CODEGEN_DEFINITIONS in CMake).
+
+#include "codegen.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace {
+int usage() {
+  std::cerr << "usage: susml-codegen (--table FILE | --dot FILE | --registered NAME) "
+               "--namespace NS [--output FILE]\n";
+  return 2;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  using namespace susml::codegen;
+
+  std::string input;
+  std::string inputKind;
+  std::string ns;
+  std::string output;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string option = argv[i];
+    if (option == "--table" || option == "--dot" || option == "--registered") {
+      inputKind = option;
+      input     = argv[i + 1];
+    } else if (option == "--namespace") {
+      ns = argv[i + 1];
+    } else if (option == "--output") {
+      output = argv[i + 1];
+    } else {
+      return usage();
+    }
+  }
+  if (argc % 2 == 0 || inputKind.empty() || ns.empty()) { return usage(); }
+
+  Definition definition;
+  if (inputKind == "--registered") {
+    const auto found = registry().find(input);
+    if (found == registry().end()) {
+      std::cerr << "susml-codegen: no definition registered as " << input << "\n";
+      return 1;
+    }
+    definition = found->second();
+  } else {
+    std::ifstream in{input};
+    if (!in) {
+      std::cerr << "susml-codegen: cannot read " << input << "\n";
+      return 1;
+    }
+    Loader     loader;
+    const auto format = (inputKind == "--table") ? susml::loader::Format::table
+                                                 : susml::loader::Format::dot;
+    if (!loader.load(in, format)) {
+      std::cerr << input << ":" << loader.errorLine << ": " << loader.error << "\n";
+      return 1;
+    }
+    definition = fromLoader(std::move(loader));
+  }
+  if (definition.states.empty()) {
+    std::cerr << "susml-codegen: " << input << " defines no states\n";
+    return 1;
+  }
+
+  if (output.empty()) {
+    generate(std::cout, definition, ns);
+    return 0;
+  }
+  std::ofstream out{output};
+  generate(out, definition, ns);
+  if (!out) {
+    std::cerr << "susml-codegen: cannot write " << output << "\n";
+    return 1;
+  }
+  return 0;
+}
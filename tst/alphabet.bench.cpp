@@ -0,0 +1,66 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "alphabet.hpp"
+#include "vectorbased.hpp"
+
+#include "lexer.util.hpp"
+
+using util::lexer::makeTransitions;
+using util::lexer::State;
+using util::lexer::Transition;
+
+std::vector<unsigned char> makeInput(std::size_t size) {
+  static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789     .,;";
+
+  std::mt19937                       mt{42};
+  std::uniform_int_distribution<int> dist(0, sizeof(alphabet) - 2);
+
+  std::vector<unsigned char> input(size);
+  for (auto &c : input) {
+    c = static_cast<unsigned char>(alphabet[dist(mt)]);
+  }
+  return input;
+}
+
+template <typename StateMachine>
+static void runLexer(benchmark::State &s) {
+  std::size_t tokens = 0;
+  auto        m      = StateMachine{State::start, makeTransitions(tokens)};
+  const auto  input  = makeInput(s.range(0));
+
+  for (auto _ : s) {
+    for (const auto c : input) {
+      m.trigger(c);
+    }
+  }
+  s.counters["tokens"] = tokens;
+  s.SetBytesProcessed(s.iterations() * s.range(0));
+}
+
+static void lexerVectorBased(benchmark::State &s) {
+  runLexer<susml::vectorbased::StateMachine<Transition>>(s);
+}
+
+static void lexerClassTable(benchmark::State &s) {
+  runLexer<susml::alphabet::StateMachine<Transition, std::uint8_t>>(s);
+}
+
+BENCHMARK(lexerVectorBased)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(lexerClassTable)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
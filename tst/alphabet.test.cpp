@@ -0,0 +1,104 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "alphabet.hpp"
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include "lexer.util.hpp"
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Lexer = util::lexer;
+
+TEST(EventClassesTests, lexerAlphabet) {
+  std::size_t tokens  = 0;
+  auto        classes = susml::alphabet::classifyEvents(Lexer::makeTransitions(tokens));
+
+  // letters, digits, space, and everything else
+  EXPECT_EQ(4, classes.numClasses);
+  EXPECT_EQ(classes.classify('a'), classes.classify('z'));
+  EXPECT_EQ(classes.classify('0'), classes.classify('9'));
+  EXPECT_NE(classes.classify('a'), classes.classify('0'));
+  EXPECT_NE(classes.classify(' '), classes.classify('0'));
+  EXPECT_EQ(0, classes.classify('!'));
+  EXPECT_EQ(0, classes.classify(255));
+}
+
+TEST(EventClassesTests, incomparableActionsAreKeptApart) {
+  using Transition = susml::Transition<int, int, susml::NoneType, std::function<void()>>;
+
+  const std::vector<Transition> transitions = {{0, 1, 0, {}, [] {}}, {0, 1, 1, {}, [] {}}};
+
+  EXPECT_EQ(3, susml::alphabet::classifyEvents(transitions).numClasses);
+}
+
+TEST(ClassTableTests, behavesLikeVectorBased) {
+  std::size_t tokensTable  = 0;
+  std::size_t tokensVector = 0;
+
+  auto table = susml::alphabet::StateMachine<Lexer::Transition>{
+      Lexer::State::start, Lexer::makeTransitions(tokensTable)};
+  auto vector = susml::vectorbased::StateMachine<Lexer::Transition>{
+      Lexer::State::start, Lexer::makeTransitions(tokensVector)};
+
+  ASSERT_TRUE(table.isCompressed());
+  EXPECT_EQ(3 * 4, table.table.size());
+
+  const std::string input = "abc 123 a1 12a !x 42 ";
+  for (const char c : input) {
+    table.trigger(static_cast<unsigned char>(c));
+    vector.trigger(static_cast<unsigned char>(c));
+    ASSERT_EQ(vector.currentState, table.currentState);
+  }
+  EXPECT_EQ(6U, tokensTable);
+  EXPECT_EQ(tokensVector, tokensTable);
+}
+
+TEST(ClassTableTests, firstTransitionWins) {
+  using Transition = susml::Transition<int, int>;
+
+  auto m = susml::alphabet::StateMachine<Transition>{0, {{0, 1, 5}, {0, 2, 5}, {1, 0, 5}}};
+  ASSERT_TRUE(m.isCompressed());
+
+  m.trigger(5);
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(4);
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(5);
+  EXPECT_EQ(0, m.currentState);
+}
+
+TEST(ClassTableTests, sparseStatesFallBackToSearch) {
+  using Transition = susml::Transition<std::size_t, int>;
+
+  constexpr std::size_t far = std::size_t{1} << 40U;
+
+  auto m = susml::alphabet::StateMachine<Transition>{0, {{0, far, 1}, {far, 0, 2}}};
+  EXPECT_FALSE(m.isCompressed());
+
+  m.trigger(1);
+  EXPECT_EQ(far, m.currentState);
+  m.trigger(2);
+  EXPECT_EQ(0, m.currentState);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
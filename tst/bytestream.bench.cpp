@@ -0,0 +1,144 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "alphabet.hpp"
+#include "bytestream.hpp"
+#include "vectorbased.hpp"
+
+#include "lexer.util.hpp"
+
+enum class State { text, quoted, comment };
+
+using util::Count;
+
+using Transition = susml::Transition<State, unsigned char, susml::NoneType, Count>;
+
+// counts lines outside of quoted strings and comments (which run from '#' to the end of the line)
+std::vector<Transition> makeTransitions(std::size_t &lines) {
+  return {{State::text, State::quoted, '"'},
+          {State::text, State::comment, '#'},
+          {State::text, State::text, '\n', {}, {&lines}},
+          {State::quoted, State::text, '"'},
+          {State::comment, State::text, '\n', {}, {&lines}}};
+}
+
+// Log-like text with long quoted strings and comments, written to a temporary file and mapped
+// into memory, as the machine would typically see it. If that fails, data is null and error says
+// why.
+struct MappedInput {
+  std::size_t          size  = 0;
+  const unsigned char *data  = nullptr;
+  const char *         error = nullptr;
+
+  explicit MappedInput(std::size_t size) : size(size) {
+    std::mt19937                       mt{42};
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(0, 120);
+
+    std::vector<unsigned char> text;
+    text.reserve(size);
+    while (text.size() < size) {
+      const auto kind = length(mt) % 3;
+      if (kind == 1) { text.push_back('"'); }
+      if (kind == 2) { text.push_back('#'); }
+      for (auto n = length(mt); n > 0; n--) {
+        text.push_back(static_cast<unsigned char>(letter(mt)));
+      }
+      if (kind == 1) { text.push_back('"'); }
+      text.push_back('\n');
+    }
+    text.resize(size);
+
+    std::FILE *file = std::tmpfile();
+    if (file == nullptr) {
+      error = "cannot create a temporary file";
+      return;
+    }
+    if (std::fwrite(text.data(), 1, text.size(), file) != text.size() || std::fflush(file) != 0) {
+      error = "cannot write the temporary file";
+      std::fclose(file);
+      return;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    std::fclose(file); // the mapping stays valid
+    if (mapped == MAP_FAILED) {
+      error = "cannot map the temporary file";
+      return;
+    }
+    data = static_cast<const unsigned char *>(mapped);
+  }
+  MappedInput(const MappedInput &) = delete;
+  MappedInput &operator=(const MappedInput &) = delete;
+
+  ~MappedInput() {
+    if (data != nullptr) { munmap(const_cast<unsigned char *>(data), size); }
+  }
+};
+
+template <typename StateMachine>
+static void runPerByte(benchmark::State &s) {
+  std::size_t       lines = 0;
+  auto              m     = StateMachine{State::text, makeTransitions(lines)};
+  const MappedInput input(s.range(0));
+  if (input.error != nullptr) {
+    s.SkipWithError(input.error);
+    return;
+  }
+
+  for (auto _ : s) {
+    for (std::size_t i = 0; i < input.size; i++) {
+      m.trigger(input.data[i]);
+    }
+  }
+  s.counters["lines"] = lines;
+  s.SetBytesProcessed(s.iterations() * s.range(0));
+}
+
+static void scanVectorBased(benchmark::State &s) {
+  runPerByte<susml::vectorbased::StateMachine<Transition>>(s);
+}
+
+static void scanClassTable(benchmark::State &s) {
+  runPerByte<susml::alphabet::StateMachine<Transition, std::uint8_t>>(s);
+}
+
+static void scanByteStream(benchmark::State &s) {
+  std::size_t       lines = 0;
+  auto              m     = susml::bytestream::StateMachine<Transition>{State::text,
+                                                             makeTransitions(lines)};
+  const MappedInput input(s.range(0));
+  if (input.error != nullptr) {
+    s.SkipWithError(input.error);
+    return;
+  }
+
+  for (auto _ : s) {
+    m.consume(input.data, input.size);
+  }
+  s.counters["lines"] = lines;
+  s.SetBytesProcessed(s.iterations() * s.range(0));
+}
+
+BENCHMARK(scanVectorBased)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK(scanClassTable)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+BENCHMARK(scanByteStream)->Arg(1 << 24)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
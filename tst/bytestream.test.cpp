@@ -0,0 +1,157 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "bytestream.hpp"
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Csv {
+enum class State { field, quoted, quote, absorbed };
+
+struct Record {
+  std::vector<std::size_t> *offsets = nullptr;
+  std::size_t               offset  = 0; // set by the test when run through consume(...)
+
+  void operator()() const {
+    if (offsets != nullptr) { offsets->push_back(offset); }
+  }
+  bool operator==(const Record &other) const { return offsets == other.offsets; }
+};
+
+using Transition = susml::Transition<State, char, susml::NoneType, Record>;
+
+// records the offset of every line end outside of quotes, '!' outside of quotes ends all parsing
+std::vector<Transition> makeTransitions(std::vector<std::size_t> &lines) {
+  return {{State::field, State::quoted, '"'},
+          {State::field, State::field, '\n', {}, {&lines}},
+          {State::field, State::absorbed, '!'},
+          {State::quoted, State::quote, '"'},
+          {State::quote, State::quoted, '"'}, // escaped quote
+          {State::quote, State::field, ','},
+          {State::quote, State::field, '\n', {}, {&lines}},
+          {State::quote, State::field, ' '}};
+}
+} // namespace Csv
+
+TEST(FindNeedleTests, findsFirstNeedle) {
+  using susml::bytestream::findNeedle;
+  using susml::bytestream::Skip;
+
+  std::string text(100, 'x');
+  text[37] = 'b';
+  text[70] = 'a';
+  const auto *data = reinterpret_cast<const unsigned char *>(text.data());
+
+  EXPECT_EQ(37, findNeedle(data, text.size(), Skip{2, {'a', 'b'}}));
+  EXPECT_EQ(70, findNeedle(data, text.size(), Skip{1, {'a'}}));
+  EXPECT_EQ(70, findNeedle(data + 38, text.size() - 38, Skip{3, {'a', 'b', 'c'}}) + 38);
+  EXPECT_EQ(100, findNeedle(data, text.size(), Skip{2, {'c', 'd'}}));
+  EXPECT_EQ(100, findNeedle(data, text.size(), Skip{0, {}}));
+  EXPECT_EQ(5, findNeedle(data, 5, Skip{4, {'a', 'b', 'c', 'd'}}));
+}
+
+TEST(ByteStreamTests, skipsOnlyStatesWithFewNeedles) {
+  std::vector<std::size_t> lines;
+  auto m = susml::bytestream::StateMachine<Csv::Transition>{Csv::State::field,
+                                                            Csv::makeTransitions(lines)};
+
+  // states are numbered in the order they first appear
+  ASSERT_EQ(4, m.states.size());
+  EXPECT_EQ(3, m.skips[0].numNeedles); // field: '"', '\n', '!'
+  EXPECT_EQ(1, m.skips[1].numNeedles); // quoted: '"'
+  EXPECT_EQ(0, m.skips[2].numNeedles); // absorbed
+  EXPECT_EQ(4, m.skips[3].numNeedles); // quote: '"', ',', '\n', ' '
+
+  using Transition = susml::Transition<int, char>;
+  auto busy        = susml::bytestream::StateMachine<Transition>{
+      0, {{0, 1, 'a'}, {0, 1, 'b'}, {0, 1, 'c'}, {0, 1, 'd'}, {0, 1, 'e'}}};
+  EXPECT_FALSE(busy.skips[0].isEnabled());
+  EXPECT_EQ(0, busy.skips[1].numNeedles);
+}
+
+TEST(ByteStreamTests, behavesLikeVectorBased) {
+  std::vector<std::size_t> linesVector;
+  std::vector<std::size_t> linesStream;
+
+  auto reference = susml::vectorbased::StateMachine<Csv::Transition>{
+      Csv::State::field, Csv::makeTransitions(linesVector)};
+  auto m = susml::bytestream::StateMachine<Csv::Transition>{Csv::State::field,
+                                                            Csv::makeTransitions(linesStream)};
+
+  static const char alphabet[] = "abcdefghij,,\"\n \xff\x80";
+  std::mt19937                       mt{42};
+  std::uniform_int_distribution<int> dist(0, sizeof(alphabet) - 2);
+
+  std::string input(5000, ' ');
+  for (auto &c : input) {
+    c = alphabet[dist(mt)];
+  }
+  input[4000] = '!';
+
+  // feed the stream in chunks of varying size, to cross chunk boundaries while skipping
+  std::size_t offset = 0;
+  std::size_t chunk  = 1;
+  while (offset < input.size()) {
+    const auto size = std::min(chunk, input.size() - offset);
+    m.consume(input.data() + offset, size, [&](Csv::Transition &t, std::size_t at) {
+      EXPECT_EQ(t.source, m.currentState); // machine state is written back before each action
+      EXPECT_EQ(at, m.position);
+      t.action.offset = at;
+      t.action();
+    });
+    for (std::size_t i = offset; i < offset + size; i++) {
+      for (auto &t : reference.transitions) {
+        t.action.offset = i;
+      }
+      reference.trigger(input[i]);
+    }
+    ASSERT_EQ(reference.currentState, m.currentState);
+    offset += size;
+    chunk = chunk * 3 + 1;
+  }
+
+  EXPECT_EQ(input.size(), m.position);
+  EXPECT_EQ(Csv::State::absorbed, m.currentState);
+  EXPECT_FALSE(linesStream.empty());
+  EXPECT_EQ(linesVector, linesStream);
+  for (const auto at : linesStream) {
+    EXPECT_EQ('\n', input[at]);
+  }
+}
+
+TEST(ByteStreamTests, unsignedBytesAndTrigger) {
+  using Transition = susml::Transition<int, unsigned char>;
+
+  auto m = susml::bytestream::StateMachine<Transition>{0, {{0, 1, 0xff}, {1, 0, 0x00}}};
+  m.trigger(0x01);
+  EXPECT_EQ(0, m.currentState);
+  m.trigger(0xff);
+  EXPECT_EQ(1, m.currentState);
+
+  const unsigned char data[] = {0x05, 0x00, 0xff, 0x07};
+  m.consume(data, sizeof(data));
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(6, m.position);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
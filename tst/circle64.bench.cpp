@@ -20,5 +20,6 @@ using util::HasGuards;
 
 BENCH_CIRCLE(64, HasGuards::no);
 BENCH_CIRCLE(64, HasGuards::yes);
+BENCH_CIRCLE_REDUNDANT(64);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -18,7 +18,10 @@
 #include <functional>
 
 #include "common.hpp"
+#include "context.hpp"
 #include "factory.hpp"
+#include "minimize.hpp"
+#include "packed.hpp"
 #include "tuplebased.hpp"
 #include "vectorbased.hpp"
 
@@ -92,8 +95,64 @@ constexpr auto makeStateMachine(std::size_t &counter) {
 
   return susml::vectorbased::StateMachine<Transition>{0, transitions};
 }
+
+// comparable action, such that minimize() can tell which transitions do the same thing
+struct AddToCounter {
+  std::size_t *counter;
+  std::size_t  amount;
+
+  void operator()() const { *counter += amount; }
+  bool operator==(const AddToCounter &other) const {
+    return counter == other.counter && amount == other.amount;
+  }
+};
+
+// The same circle as above, but with redundant states: the circle is unrolled Copies times (state
+// i behaves the same as state i + NumTransitions), and followed by a copy that is unreachable.
+template <std::size_t NumTransitions, std::size_t Copies = 2>
+auto makeRedundantStateMachine(std::size_t &counter) {
+  constexpr std::size_t numReachable = NumTransitions * Copies;
+
+  std::vector<susml::Transition<std::size_t, bool, susml::NoneType, AddToCounter>> transitions;
+  for (std::size_t i = 0; i < numReachable; i++) {
+    const std::size_t target = (i + 1) % numReachable;
+    transitions.push_back(
+        From(i).To(target).On(true).Do(AddToCounter{&counter, i % NumTransitions}).make());
+  }
+  for (std::size_t i = 0; i < NumTransitions; i++) {
+    const std::size_t target = numReachable + (i + 1) % NumTransitions;
+    transitions.push_back(
+        From(numReachable + i).To(target).On(true).Do(AddToCounter{&counter, i}).make());
+  }
+
+  using Transition = typename decltype(transitions)::value_type;
+  return susml::vectorbased::StateMachine<Transition>{0, transitions};
+}
 } // namespace vectorbased
 
+namespace context {
+// the same circle, with the counter as context and plain functions as guards and actions
+using Transition = susml::context::Transition<std::size_t, bool, std::size_t>;
+
+template <std::size_t Index>
+void addIndex(std::size_t &counter) {
+  counter += Index;
+}
+
+inline bool everyOther(std::size_t &counter) { return ((counter++ & 1) == 0); }
+
+template <bool WithGuards, std::size_t... Indices>
+auto makeDefinition(const std::index_sequence<Indices...> &) {
+  constexpr auto totalTransitions = sizeof...(Indices);
+  return susml::context::Definition<Transition>{{Transition{
+      Indices,
+      ((Indices + 1) < totalTransitions) ? Indices + 1 : 0,
+      true,
+      WithGuards ? everyOther : nullptr,
+      addIndex<Indices>}...}};
+}
+} // namespace context
+
 template <typename StateMachine>
 static void runTest(benchmark::State &s, StateMachine &machine, size_t &counter) {
   for (auto _ : s) {
@@ -120,10 +179,73 @@ static void circleVectorBased(benchmark::State &s) {
   runTest(s, m, counter);
 }
 
+// the same as circleVectorBased, but triggering all events in one go
+template <std::size_t NumTransitions, util::HasGuards hasGuards>
+static void circleFastForward(benchmark::State &s) {
+  std::size_t counter = 0;
+  auto        m =
+      vectorbased::makeStateMachine<NumTransitions, (hasGuards == util::HasGuards::yes)>(counter);
+  for (auto _ : s) {
+    m.triggerRepeatedly(true, static_cast<std::size_t>(s.range(0)));
+  }
+  s.counters["c"] = counter;
+}
+
+template <std::size_t NumTransitions, util::HasGuards hasGuards>
+static void circleContext(benchmark::State &s) {
+  std::size_t counter    = 0;
+  const auto  definition = context::makeDefinition<(hasGuards == util::HasGuards::yes)>(
+      std::make_index_sequence<NumTransitions>());
+  auto m = susml::context::StateMachine<context::Transition>{definition, counter, 0};
+  runTest(s, m, counter);
+}
+
+template <std::size_t NumTransitions, util::HasGuards hasGuards>
+static void circlePacked(benchmark::State &s) {
+  std::size_t counter = 0;
+  auto        original =
+      vectorbased::makeStateMachine<NumTransitions, (hasGuards == util::HasGuards::yes)>(counter);
+  auto m = susml::packed::StateMachine<typename decltype(original)::Transition>{
+      original.currentState, original.transitions};
+  runTest(s, m, counter);
+}
+
+template <std::size_t NumTransitions>
+static void circleRedundantVectorBased(benchmark::State &s) {
+  std::size_t counter = 0;
+  auto        m       = vectorbased::makeRedundantStateMachine<NumTransitions>(counter);
+  s.counters["transitions"] = m.transitions.size();
+  runTest(s, m, counter);
+}
+
+template <std::size_t NumTransitions>
+static void circleRedundantMinimized(benchmark::State &s) {
+  std::size_t counter  = 0;
+  auto        original = vectorbased::makeRedundantStateMachine<NumTransitions>(counter);
+  auto        m        = susml::vectorbased::minimize(original).machine;
+  s.counters["transitions"] = m.transitions.size();
+  runTest(s, m, counter);
+}
+
 } // namespace util
 
+#define BENCH_CIRCLE_REDUNDANT(NumTransitions)                                                     \
+  namespace {                                                                                      \
+  using util::circleRedundantMinimized;                                                            \
+  using util::circleRedundantVectorBased;                                                          \
+  BENCHMARK_TEMPLATE(circleRedundantVectorBased, NumTransitions)                                   \
+      ->Arg(100000)                                                                                \
+      ->Unit(benchmark::kMicrosecond);                                                             \
+  BENCHMARK_TEMPLATE(circleRedundantMinimized, NumTransitions)                                     \
+      ->Arg(100000)                                                                                \
+      ->Unit(benchmark::kMicrosecond);                                                             \
+  }
+
 #define BENCH_CIRCLE(NumTransitions, HasGuards)                                                    \
   namespace {                                                                                      \
+  using util::circleContext;                                                                       \
+  using util::circleFastForward;                                                                   \
+  using util::circlePacked;                                                                        \
   using util::circleTupleBased;                                                                    \
   using util::circleVectorBased;                                                                   \
   BENCHMARK_TEMPLATE(circleTupleBased, NumTransitions, HasGuards)                                  \
@@ -132,6 +254,15 @@ static void circleVectorBased(benchmark::State &s) {
   BENCHMARK_TEMPLATE(circleVectorBased, NumTransitions, HasGuards)                                 \
       ->Arg(100000)                                                                                \
       ->Unit(benchmark::kMicrosecond);                                                             \
+  BENCHMARK_TEMPLATE(circleFastForward, NumTransitions, HasGuards)                                 \
+      ->Arg(100000)                                                                                \
+      ->Unit(benchmark::kMicrosecond);                                                             \
+  BENCHMARK_TEMPLATE(circleContext, NumTransitions, HasGuards)                                     \
+      ->Arg(100000)                                                                                \
+      ->Unit(benchmark::kMicrosecond);                                                             \
+  BENCHMARK_TEMPLATE(circlePacked, NumTransitions, HasGuards)                                      \
+      ->Arg(100000)                                                                                \
+      ->Unit(benchmark::kMicrosecond);                                                             \
   }
 
 #endif
\ No newline at end of file
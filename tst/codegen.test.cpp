@@ -0,0 +1,141 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "codegen.hpp"
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+#include "encoder.hpp" // generated from encoder.table at build time
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+TEST(CodegenTests, generatedEncoderMatchesVectorBased) {
+  using Transition = susml::Transition<int, int, susml::NoneType, std::function<void()>>;
+
+  struct Hooks {
+    int delta = 0;
+    void increment() { delta++; }
+    void decrement() { delta--; }
+  };
+
+  // the same encoder as encoder.table, with states and events numbered in order of appearance
+  Hooks      hooks;
+  int        delta     = 0;
+  const auto NoAction  = [] {};
+  auto       increment = [&] { delta++; };
+  auto       decrement = [&] { delta--; };
+  auto       v         = susml::vectorbased::StateMachine<Transition>{
+      0, {{0, 1, 0, {}, NoAction}, {1, 0, 0, {}, NoAction}, {1, 2, 1, {}, NoAction},
+          {2, 1, 1, {}, NoAction}, {2, 3, 0, {}, NoAction}, {3, 2, 0, {}, NoAction},
+          {3, 0, 1, {}, increment}, {0, 4, 1, {}, NoAction}, {4, 0, 1, {}, NoAction},
+          {4, 5, 0, {}, NoAction}, {5, 4, 0, {}, NoAction}, {5, 6, 1, {}, NoAction},
+          {6, 5, 1, {}, NoAction}, {6, 0, 0, {}, decrement}}};
+
+  auto state = encoder::initialState;
+  EXPECT_EQ(encoder::State::idle, state);
+  for (int i = 0; i < 1000; i++) {
+    const int  event          = (i * 7 + i / 3) % 2; // updateB is event 0
+    const auto generatedEvent = (event == 0) ? encoder::Event::updateB : encoder::Event::updateA;
+    encoder::trigger(state, generatedEvent, hooks);
+    v.trigger(event);
+    EXPECT_EQ(v.currentState, static_cast<int>(state));
+  }
+  EXPECT_EQ(delta, hooks.delta);
+}
+
+TEST(CodegenTests, generatesGuardsInOrderOfPriority) {
+  std::istringstream in{"initial locked\n"
+                        "locked unlocked coin  isPaid   count\n"
+                        "locked locked   coin  -        count\n"
+                        "locked open     coin  isBroken\n"
+                        "unlocked locked push\n"};
+  susml::codegen::Loader loader;
+  ASSERT_TRUE(loader.load(in, susml::loader::Format::table)) << loader.error;
+
+  std::ostringstream out;
+  susml::codegen::generate(out, susml::codegen::fromLoader(std::move(loader)), "turnstile");
+  const auto code = out.str();
+
+  const auto guarded   = code.find("if (hooks.isPaid()) {\n        hooks.count();");
+  const auto unguarded = code.find("      hooks.count();\n      currentState = State::locked;");
+  EXPECT_NE(std::string::npos, guarded);
+  EXPECT_NE(std::string::npos, unguarded);
+  EXPECT_LT(guarded, unguarded);
+  EXPECT_EQ(std::string::npos, code.find("isBroken")); // shadowed by the unguarded transition
+  EXPECT_EQ(std::string::npos, code.find("NoHooks"));
+}
+
+TEST(CodegenTests, fromLoaderLeavesTheLoaderEmpty) {
+  std::istringstream first{"a b go\n"
+                           "b c go\n"};
+  susml::codegen::Loader loader;
+  ASSERT_TRUE(loader.load(first, susml::loader::Format::table)) << loader.error;
+  const auto definition = susml::codegen::fromLoader(std::move(loader));
+  EXPECT_EQ(3U, definition.states.size());
+  EXPECT_EQ(2U, definition.transitions.size());
+
+  std::istringstream second{"x y stop\n"};
+  ASSERT_TRUE(loader.load(second, susml::loader::Format::table)) << loader.error;
+  const auto reused = susml::codegen::fromLoader(std::move(loader));
+  EXPECT_EQ((std::vector<std::string>{"x", "y"}), reused.states);
+  EXPECT_EQ((std::vector<std::string>{"stop"}), reused.events);
+  ASSERT_EQ(1U, reused.transitions.size());
+  EXPECT_EQ(0U, reused.transitions[0].source);
+  EXPECT_EQ(1U, reused.transitions[0].target);
+  EXPECT_EQ(0U, reused.initialState);
+}
+
+TEST(CodegenTests, namesBecomeIdentifiers) {
+  using Transition = susml::Transition<int, char>;
+
+  const std::vector<Transition> transitions = {{0, 1, 'a'}, {1, 2, '-'}, {2, 0, 'b'}};
+  const auto stateNames = std::vector<std::string>{"default", "2nd state", "2nd-state"};
+  const auto definition = susml::codegen::fromTransitions(
+      0,
+      transitions,
+      [&](int s) { return stateNames[static_cast<std::size_t>(s)]; },
+      [](char e) { return std::string(1, e); },
+      [](const Transition &) { return std::string(); },
+      [](const Transition &) { return std::string(); });
+  EXPECT_EQ(3U, definition.states.size());
+  EXPECT_EQ(3U, definition.events.size());
+
+  std::ostringstream out;
+  susml::codegen::generate(out, definition, "names");
+  const auto code = out.str();
+  EXPECT_NE(std::string::npos, code.find("  default_,\n  _2nd_state,\n  _2nd_state_2,\n"));
+  EXPECT_NE(std::string::npos, code.find("  a,\n  _,\n  b,\n"));
+  EXPECT_NE(std::string::npos, code.find("struct NoHooks {};"));
+}
+
+TEST(CodegenTests, hooksGetUniqueIdentifiers) {
+  std::istringstream in{"a b go a-b\n"
+                        "b a go a_b a-b\n"
+                        "b c stop - delete\n"};
+  susml::codegen::Loader loader;
+  ASSERT_TRUE(loader.load(in, susml::loader::Format::table)) << loader.error;
+
+  std::ostringstream out;
+  susml::codegen::generate(out, susml::codegen::fromLoader(std::move(loader)), "hooks");
+  const auto code = out.str();
+  EXPECT_NE(std::string::npos, code.find("// hook \"a-b\" is hooks.a_b()\n"));
+  EXPECT_NE(std::string::npos, code.find("// hook \"a_b\" is hooks.a_b_2()\n"));
+  EXPECT_NE(std::string::npos, code.find("// hook \"delete\" is hooks.delete_()\n"));
+  EXPECT_NE(std::string::npos, code.find("if (hooks.a_b_2()) {\n        hooks.a_b();"));
+}
@@ -0,0 +1,147 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "context.hpp"
+#include "factory.hpp"
+
+#include <vector>
+
+using susml::context::Definition;
+using susml::context::StateMachine;
+
+namespace Encoder {
+enum class State { idle, cw1, cw2, cw3, ccw1, ccw2, ccw3 };
+enum class Event { update };
+
+struct Context {
+  bool a     = false;
+  bool b     = false;
+  int  delta = 0;
+};
+
+using Transition = susml::context::Transition<State, Event, Context>;
+
+template <bool A, bool B>
+bool is(Context &c) {
+  return c.a == A && c.b == B;
+}
+
+void up(Context &c) { c.delta++; }
+void down(Context &c) { c.delta--; }
+
+const Definition<Transition> definition{{
+    {State::idle, State::cw1, Event::update, is<false, true>},
+    {State::cw1, State::idle, Event::update, is<false, false>},
+    {State::cw1, State::cw2, Event::update, is<true, true>},
+    {State::cw2, State::cw1, Event::update, is<false, true>},
+    {State::cw2, State::cw3, Event::update, is<true, false>},
+    {State::cw3, State::cw2, Event::update, is<true, true>},
+    {State::cw3, State::idle, Event::update, is<false, false>, up},
+    {State::idle, State::ccw1, Event::update, is<true, false>},
+    {State::ccw1, State::idle, Event::update, is<false, false>},
+    {State::ccw1, State::ccw2, Event::update, is<true, true>},
+    {State::ccw2, State::ccw1, Event::update, is<true, false>},
+    {State::ccw2, State::ccw3, Event::update, is<false, true>},
+    {State::ccw3, State::ccw2, Event::update, is<true, true>},
+    {State::ccw3, State::idle, Event::update, is<false, false>, down},
+}};
+} // namespace Encoder
+
+TEST(ContextTests, transitionsAreSmall) {
+  // two function pointers next to the states and event, no captured state
+  EXPECT_EQ(sizeof(void (*)()), sizeof(Encoder::Transition::Guard));
+  EXPECT_EQ(sizeof(void (*)()), sizeof(Encoder::Transition::Action));
+  EXPECT_LE(sizeof(Encoder::Transition), 32U);
+}
+
+TEST(ContextTests, instancesShareOneDefinition) {
+  using namespace Encoder;
+
+  Context clockwise;
+  Context counterclockwise;
+  auto    m1 = StateMachine<Transition>{definition, clockwise, State::idle};
+  auto    m2 = StateMachine<Transition>{definition, counterclockwise, State::idle};
+
+  auto update = [](auto &m, Context &c, bool a, bool b) {
+    c.a = a;
+    c.b = b;
+    m.trigger(Event::update);
+  };
+
+  for (int i = 0; i < 3; i++) {
+    update(m1, clockwise, false, true);
+    update(m2, counterclockwise, true, false);
+    update(m1, clockwise, true, true);
+    update(m2, counterclockwise, true, true);
+    update(m1, clockwise, true, false);
+    update(m2, counterclockwise, false, true);
+    update(m1, clockwise, false, false);
+    update(m2, counterclockwise, false, false);
+  }
+
+  EXPECT_EQ(State::idle, m1.currentState);
+  EXPECT_EQ(State::idle, m2.currentState);
+  EXPECT_EQ(3, clockwise.delta);
+  EXPECT_EQ(-3, counterclockwise.delta);
+}
+
+TEST(ContextTests, nullGuardsPassAndNullActionsDoNothing) {
+  using Transition = susml::context::Transition<int, int, int>;
+
+  const Definition<Transition> definition{{{0, 1, 0},
+                                           {1, 2, 0, nullptr, [](int &n) { n++; }},
+                                           {2, 0, 0, [](int &n) { return n > 1; }}}};
+
+  int  n = 0;
+  auto m = StateMachine<Transition>{definition, n, 0};
+  m.trigger(0);
+  m.trigger(0);
+  EXPECT_EQ(2, m.currentState);
+  EXPECT_EQ(1, n);
+  m.trigger(0);
+  EXPECT_EQ(2, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+TEST(ContextTests, contextAndPayload) {
+  using namespace susml::factory;
+
+  struct Totals {
+    int sum = 0;
+  };
+  using Guard      = bool (*)(Totals &, const int &);
+  using Action     = void (*)(Totals &, const int &);
+  using Transition = susml::Transition<int, int, Guard, Action, int, Totals>;
+
+  const Guard  fits = [](Totals &t, const int &n) { return t.sum + n <= 10; };
+  const Action add  = [](Totals &t, const int &n) { t.sum += n; };
+
+  const Definition<Transition> definition{
+      {From(0).To(0).On(0).If(fits).Do(add).make<int, Totals>()}};
+
+  Totals totals;
+  auto   m = StateMachine<Transition>{definition, totals, 0};
+  for (int n : {4, 5, 3, 1}) {
+    m.trigger(0, n);
+  }
+  EXPECT_EQ(10, totals.sum);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -19,6 +19,8 @@
 #include "tuplebased.hpp"
 #include "vectorbased.hpp"
 
+#include "encoder.hpp" // generated from encoder.table by susml-codegen
+
 enum class State {
   idle,
   clockwise1,
@@ -257,6 +259,45 @@ static void encoderEventBasedTB(benchmark::State &s) {
 }
 } // namespace tuplebased
 
+namespace generated {
+struct Hooks {
+  int &delta;
+
+  void increment() { delta++; }
+  void decrement() { delta--; }
+};
+
+static void encoderEventBasedGen(benchmark::State &s) {
+  int            delta        = 0;
+  Hooks          hooks{delta};
+  encoder::State currentState = encoder::initialState;
+
+  static std::mt19937                  mt{std::random_device{}()};
+  std::uniform_int_distribution<short> dist(0, 1);
+
+  auto getEvents = [&] {
+    std::vector<encoder::Event> events(s.range(0));
+    for (auto &e : events) {
+      e = (dist(mt) == 0) ? encoder::Event::updateA : encoder::Event::updateB;
+    }
+    return events;
+  };
+
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto events = getEvents();
+    s.ResumeTiming();
+
+    for (const encoder::Event e : events) {
+      encoder::trigger(currentState, e, hooks);
+    }
+  }
+
+  s.counters["d"] = delta;
+}
+} // namespace generated
+
+using generated::encoderEventBasedGen;
 using handcrafted::encoderEventBasedHC;
 using tuplebased::encoderEventBasedTB;
 using vectorbased::encoderEventBasedVB;
@@ -268,6 +309,10 @@ BENCHMARK(encoderEventBasedHC)
     ->RangeMultiplier(2)
     ->Range(numTriggersLowerBound, numTriggersUpperBound)
     ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderEventBasedGen)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
 BENCHMARK(encoderEventBasedTB)
     ->RangeMultiplier(2)
     ->Range(numTriggersLowerBound, numTriggersUpperBound)
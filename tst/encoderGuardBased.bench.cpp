@@ -14,8 +14,13 @@
 #include <benchmark/benchmark.h>
 #include <random>
 #include <functional>
+#include <vector>
 
 #include "factory.hpp"
+#include "frozen.hpp"
+#include "guards.hpp"
+#include "reactive.hpp"
+#include "threaded.hpp"
 #include "tuplebased.hpp"
 #include "vectorbased.hpp"
 
@@ -36,126 +41,30 @@ struct Update {
   bool newB = false;
 };
 
-namespace handcrafted {
-void trigger(State &currentState, int &delta, bool &a, bool &b) {
-  switch (currentState) {
-  case State::idle: { // false false
-    if (a && !b) {
-      currentState = State::counterclockwise1;
-    } else if (!a && b) {
-      currentState = State::clockwise1;
-    }
-    break;
-  }
-  case State::clockwise1: { // false true
-    if (a && b) {
-      currentState = State::clockwise2;
-    } else if (!a && !b) {
-      currentState = State::idle;
-    }
-    break;
-  }
-  case State::clockwise2: { // true true
-    if (a && !b) {
-      currentState = State::clockwise1;
-    } else if (!a && b) {
-      currentState = State::clockwise3;
-    }
-    break;
-  }
-  case State::clockwise3: { // true false
-    if (!a && !b) {
-      delta++;
-      currentState = State::idle;
-    } else if (a && b) {
-      currentState = State::clockwise2;
-    }
-    break;
-  }
-  case State::counterclockwise1: { // true false
-    if (a && b) {
-      currentState = State::idle;
-    } else if (!a && !b) {
-      currentState = State::counterclockwise2;
-    }
-    break;
-  }
-  case State::counterclockwise2: { // true true
-    if (!a && b) {
-      currentState = State::counterclockwise3;
-    } else if (!b && a) {
-      currentState = State::counterclockwise1;
-    }
-    break;
-  }
-  case State::counterclockwise3: { // false true
-    if (a && b) {
-      currentState = State::counterclockwise2;
-    } else if (!a && !b) {
-      delta--;
-      currentState = State::idle;
-    }
-    break;
-  }
-  }
-}
-
-static void encoderGuardBasedHC(benchmark::State &s) {
-  int   delta        = 0;
-  bool  a            = false;
-  bool  b            = false;
-  State currentState = State::idle;
-
+// Updates in which either A or B (chosen at random) flips, starting from both low.
+std::vector<Update> makeUpdates(std::size_t numUpdates) {
   static std::mt19937                  mt{std::random_device{}()};
   std::uniform_int_distribution<short> dist(0, 1);
 
-  auto getUpdates = [&] {
-    std::vector<Update> updates(s.range(0));
-
-    updates[0].newA = false;
-    updates[0].newA = false;
-
-    for (std::size_t i = 1; i < updates.size(); i++) {
-      updates[i] = updates[i - 1];
-
-      const auto r = dist(mt);
-      if (r == 0) {
-        updates[i].newA = !updates[i - 1].newA;
-      } else {
-        updates[i].newB = !updates[i - 1].newB;
-      }
-    }
-
-    return updates;
-  };
-
-  for (auto _ : s) {
-    s.PauseTiming();
-    auto updates = getUpdates();
-    s.ResumeTiming();
-
-    for (const auto u : updates) {
-      a = u.newA;
-      b = u.newB;
-
-      trigger(currentState, delta, a, b);
+  std::vector<Update> updates(numUpdates);
+  for (std::size_t i = 1; i < updates.size(); i++) {
+    updates[i] = updates[i - 1];
+    if (dist(mt) == 0) {
+      updates[i].newA = !updates[i - 1].newA;
+    } else {
+      updates[i].newB = !updates[i - 1].newB;
     }
   }
-
-  s.counters["d"] = delta;
+  return updates;
 }
-} // namespace handcrafted
-
-namespace vectorbased {
 
-auto makeStateMachine(int &delta, const bool &a, const bool &b) {
+// The transitions of the encoder, shared by the runtime machines. Their guards differ per
+// machine, and are made by And(desiredA, desiredB).
+template <typename MakeGuard>
+auto makeEncoderTransitions(int &delta, MakeGuard &&And) {
   using namespace susml::factory;
-  using susml::vectorbased::StateMachine;
 
-  auto Fn  = [](auto e) { return std::function(e); };
-  auto And = [&](bool desiredA, bool desiredB) {
-    return Fn([&] { return (a == desiredA && b == desiredB); });
-  };
+  auto Fn       = [](auto e) { return std::function(e); };
   auto NoAction = Fn([] {});
 
   std::vector transitions = {From(State::idle) // false false
@@ -243,6 +152,104 @@ auto makeStateMachine(int &delta, const bool &a, const bool &b) {
                                  .Do(Fn([&] { delta--; }))
                                  .make()};
 
+  return transitions;
+}
+
+namespace handcrafted {
+void trigger(State &currentState, int &delta, bool &a, bool &b) {
+  switch (currentState) {
+  case State::idle: { // false false
+    if (a && !b) {
+      currentState = State::counterclockwise1;
+    } else if (!a && b) {
+      currentState = State::clockwise1;
+    }
+    break;
+  }
+  case State::clockwise1: { // false true
+    if (a && b) {
+      currentState = State::clockwise2;
+    } else if (!a && !b) {
+      currentState = State::idle;
+    }
+    break;
+  }
+  case State::clockwise2: { // true true
+    if (a && !b) {
+      currentState = State::clockwise1;
+    } else if (!a && b) {
+      currentState = State::clockwise3;
+    }
+    break;
+  }
+  case State::clockwise3: { // true false
+    if (!a && !b) {
+      delta++;
+      currentState = State::idle;
+    } else if (a && b) {
+      currentState = State::clockwise2;
+    }
+    break;
+  }
+  case State::counterclockwise1: { // true false
+    if (a && b) {
+      currentState = State::idle;
+    } else if (!a && !b) {
+      currentState = State::counterclockwise2;
+    }
+    break;
+  }
+  case State::counterclockwise2: { // true true
+    if (!a && b) {
+      currentState = State::counterclockwise3;
+    } else if (!b && a) {
+      currentState = State::counterclockwise1;
+    }
+    break;
+  }
+  case State::counterclockwise3: { // false true
+    if (a && b) {
+      currentState = State::counterclockwise2;
+    } else if (!a && !b) {
+      delta--;
+      currentState = State::idle;
+    }
+    break;
+  }
+  }
+}
+
+static void encoderGuardBasedHC(benchmark::State &s) {
+  int   delta        = 0;
+  bool  a            = false;
+  bool  b            = false;
+  State currentState = State::idle;
+
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
+
+    for (const auto u : updates) {
+      a = u.newA;
+      b = u.newB;
+
+      trigger(currentState, delta, a, b);
+    }
+  }
+
+  s.counters["d"] = delta;
+}
+} // namespace handcrafted
+
+namespace vectorbased {
+
+auto makeStateMachine(int &delta, const bool &a, const bool &b) {
+  using susml::vectorbased::StateMachine;
+
+  const auto transitions = makeEncoderTransitions(delta, [&](bool desiredA, bool desiredB) {
+    return std::function([&a, &b, desiredA, desiredB] { return (a == desiredA && b == desiredB); });
+  });
   return StateMachine<decltype(transitions)::value_type>{State::idle, transitions};
 }
 
@@ -252,32 +259,52 @@ static void encoderGuardBasedVB(benchmark::State &s) {
   bool b     = false;
   auto m     = makeStateMachine(delta, a, b);
 
-  static std::mt19937                  mt{std::random_device{}()};
-  std::uniform_int_distribution<short> dist(0, 1);
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
 
-  auto getUpdates = [&] {
-    std::vector<Update> updates(s.range(0));
+    for (const Update &u : updates) {
+      a = u.newA;
+      b = u.newB;
 
-    updates[0].newA = false;
-    updates[0].newA = false;
+      m.trigger(Event::update);
+    }
+  }
 
-    for (std::size_t i = 1; i < updates.size(); i++) {
-      updates[i] = updates[i - 1];
+  s.counters["d"] = delta;
+}
 
-      const auto r = dist(mt);
-      if (r == 0) {
-        updates[i].newA = !updates[i - 1].newA;
-      } else {
-        updates[i].newB = !updates[i - 1].newB;
-      }
-    }
+} // namespace vectorbased
 
-    return updates;
-  };
+namespace guards {
+
+// a and b are either plain bools or reactive inputs
+template <typename Input>
+auto makeTransitions(int &delta, const Input &a, const Input &b) {
+  using susml::guards::Guard;
+  using susml::guards::var;
+  using susml::reactive::var;
+
+  return makeEncoderTransitions(delta, [&](bool desiredA, bool desiredB) {
+    return Guard(var(a) == desiredA && var(b) == desiredB);
+  });
+}
+
+auto makeStateMachine(int &delta, const bool &a, const bool &b) {
+  const auto transitions = makeTransitions(delta, a, b);
+  return susml::guards::StateMachine<decltype(transitions)::value_type>{State::idle, transitions};
+}
+
+static void encoderGuardBasedGE(benchmark::State &s) {
+  int  delta = 0;
+  bool a     = false;
+  bool b     = false;
+  auto m     = makeStateMachine(delta, a, b);
 
   for (auto _ : s) {
     s.PauseTiming();
-    auto updates = getUpdates();
+    auto updates = makeUpdates(s.range(0));
     s.ResumeTiming();
 
     for (const Update &u : updates) {
@@ -291,7 +318,42 @@ static void encoderGuardBasedVB(benchmark::State &s) {
   s.counters["d"] = delta;
 }
 
-} // namespace vectorbased
+} // namespace guards
+
+namespace reactive {
+using susml::reactive::Changes;
+using susml::reactive::Input;
+
+auto makeStateMachine(int &delta, const Input<bool> &a, const Input<bool> &b, Changes &changes) {
+  const auto transitions = guards::makeTransitions(delta, a, b);
+  return susml::reactive::StateMachine<decltype(transitions)::value_type>{
+      State::idle, transitions, changes, Event::update};
+}
+
+static void encoderGuardBasedRE(benchmark::State &s) {
+  int         delta = 0;
+  Changes     changes;
+  Input<bool> a(changes, false);
+  Input<bool> b(changes, false);
+  auto        m = makeStateMachine(delta, a, b, changes);
+
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
+
+    for (const Update &u : updates) {
+      a = u.newA;
+      b = u.newB;
+
+      m.update();
+    }
+  }
+
+  s.counters["d"] = delta;
+}
+
+} // namespace reactive
 
 namespace tuplebased {
 using susml::Transition;
@@ -369,32 +431,97 @@ static void encoderGuardBasedTB(benchmark::State &s) {
   bool b     = false;
   auto m     = makeStateMachine(delta, a, b);
 
-  static std::mt19937                  mt{std::random_device{}()};
-  std::uniform_int_distribution<short> dist(0, 1);
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
+
+    for (const Update &u : updates) {
+      a = u.newA;
+      b = u.newB;
+
+      m.trigger(Event::update);
+    }
+  }
 
-  auto getUpdates = [&] {
-    std::vector<Update> updates(s.range(0));
+  s.counters["d"] = delta;
+}
+
+// as above, but with the update passed to the guards as payload rather than through captured
+// variables
+auto makePayloadStateMachine(int &delta) {
+  auto Is = [](bool desiredA, bool desiredB) {
+    return [desiredA, desiredB](const Update &u) {
+      return u.newA == desiredA && u.newB == desiredB;
+    };
+  };
+  auto Nothing = [](const Update &) {};
+  auto Count   = [&](int step) { return [&delta, step](const Update &) { delta += step; }; };
+
+  using Guard   = decltype(Is(false, false));
+  using Idle    = Transition<State, Event, Guard, decltype(Nothing), Update>;
+  using Counted = Transition<State, Event, Guard, decltype(Count(1)), Update>;
+
+  const auto idle = State::idle;
+  const auto cw1  = State::clockwise1;
+  const auto cw2  = State::clockwise2;
+  const auto cw3  = State::clockwise3;
+  const auto ccw1 = State::counterclockwise1;
+  const auto ccw2 = State::counterclockwise2;
+  const auto ccw3 = State::counterclockwise3;
+  const auto on   = Event::update;
+
+  auto transitions = std::make_tuple(Idle(idle, cw1, on, Is(false, true), Nothing),
+                                     Idle(cw1, idle, on, Is(false, false), Nothing),
+                                     Idle(cw1, cw2, on, Is(true, true), Nothing),
+                                     Idle(cw2, cw1, on, Is(false, true), Nothing),
+                                     Idle(cw2, cw3, on, Is(true, false), Nothing),
+                                     Idle(cw3, cw2, on, Is(true, true), Nothing),
+                                     Counted(cw3, idle, on, Is(false, false), Count(1)),
+                                     Idle(idle, ccw1, on, Is(true, false), Nothing),
+                                     Idle(ccw1, idle, on, Is(false, false), Nothing),
+                                     Idle(ccw1, ccw2, on, Is(true, true), Nothing),
+                                     Idle(ccw2, ccw1, on, Is(true, false), Nothing),
+                                     Idle(ccw2, ccw3, on, Is(false, true), Nothing),
+                                     Idle(ccw3, ccw2, on, Is(true, true), Nothing),
+                                     Counted(ccw3, idle, on, Is(false, false), Count(-1)));
 
-    updates[0].newA = false;
-    updates[0].newA = false;
+  return susml::tuplebased::StateMachine<State, Event, decltype(transitions)>(State::idle,
+                                                                              transitions);
+}
 
-    for (std::size_t i = 1; i < updates.size(); i++) {
-      updates[i] = updates[i - 1];
+static void encoderGuardBasedTP(benchmark::State &s) {
+  int  delta = 0;
+  auto m     = makePayloadStateMachine(delta);
 
-      const auto r = dist(mt);
-      if (r == 0) {
-        updates[i].newA = !updates[i - 1].newA;
-      } else {
-        updates[i].newB = !updates[i - 1].newB;
-      }
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
+
+    for (const Update &u : updates) {
+      m.trigger(Event::update, u);
     }
+  }
 
-    return updates;
-  };
+  s.counters["d"] = delta;
+}
+
+} // namespace tuplebased
+
+namespace frozen {
+
+// the vector-based machine, frozen into a table per state and event
+static void encoderGuardBasedFR(benchmark::State &s) {
+  int  delta  = 0;
+  bool a      = false;
+  bool b      = false;
+  auto frozen = susml::frozen::freeze(vectorbased::makeStateMachine(delta, a, b));
+  auto &m     = frozen.machine;
 
   for (auto _ : s) {
     s.PauseTiming();
-    auto updates = getUpdates();
+    auto updates = makeUpdates(s.range(0));
     s.ResumeTiming();
 
     for (const Update &u : updates) {
@@ -408,10 +535,44 @@ static void encoderGuardBasedTB(benchmark::State &s) {
   s.counters["d"] = delta;
 }
 
-} // namespace tuplebased
+} // namespace frozen
+
+namespace threaded {
+
+// the vector-based machine, run as threaded code
+static void encoderGuardBasedTC(benchmark::State &s) {
+  int  delta    = 0;
+  bool a        = false;
+  bool b        = false;
+  auto original = vectorbased::makeStateMachine(delta, a, b);
+  auto m        = susml::threaded::StateMachine<decltype(original)::Transition>{
+      original.currentState, std::move(original.transitions)};
+
+  for (auto _ : s) {
+    s.PauseTiming();
+    auto updates = makeUpdates(s.range(0));
+    s.ResumeTiming();
 
+    for (const Update &u : updates) {
+      a = u.newA;
+      b = u.newB;
+
+      m.trigger(Event::update);
+    }
+  }
+
+  s.counters["d"] = delta;
+}
+
+} // namespace threaded
+
+using frozen::encoderGuardBasedFR;
+using guards::encoderGuardBasedGE;
 using handcrafted::encoderGuardBasedHC;
+using reactive::encoderGuardBasedRE;
+using threaded::encoderGuardBasedTC;
 using tuplebased::encoderGuardBasedTB;
+using tuplebased::encoderGuardBasedTP;
 using vectorbased::encoderGuardBasedVB;
 
 constexpr auto numTriggersLowerBound = (1 << 15);
@@ -425,9 +586,29 @@ BENCHMARK(encoderGuardBasedTB)
     ->RangeMultiplier(2)
     ->Range(numTriggersLowerBound, numTriggersUpperBound)
     ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderGuardBasedTP)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
 BENCHMARK(encoderGuardBasedVB)
     ->RangeMultiplier(2)
     ->Range(numTriggersLowerBound, numTriggersUpperBound)
     ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderGuardBasedGE)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderGuardBasedRE)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderGuardBasedFR)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(encoderGuardBasedTC)
+    ->RangeMultiplier(2)
+    ->Range(numTriggersLowerBound, numTriggersUpperBound)
+    ->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,118 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Building a vector-based machine of 10k transitions whose guards and actions are std::functions
+// with captures too large for their small buffer, so every copy of one allocates. The factory
+// chain on temporaries moves them through every step, the chain on named steps copies them.
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "vectorbased.hpp"
+
+using Guard        = std::function<bool()>;
+using Action       = std::function<void()>;
+using Transition   = susml::Transition<int, int, Guard, Action>;
+using StateMachine = susml::vectorbased::StateMachine<Transition>;
+
+constexpr int numTransitions = 10000;
+constexpr int numStates      = 100;
+
+struct Captures {
+  std::array<int, 16> values;
+  int *               counter;
+};
+
+Guard makeGuard(int i, int *counter) {
+  Captures c{{}, counter};
+  c.values.fill(i);
+  return [c] { return c.values[0] >= *c.counter; };
+}
+
+Action makeAction(int i, int *counter) {
+  Captures c{{}, counter};
+  c.values.fill(i);
+  return [c] { *c.counter += c.values[15]; };
+}
+
+static void constructDirectly(benchmark::State &s) {
+  int counter = 0;
+  for (auto _ : s) {
+    std::vector<Transition> transitions;
+    transitions.reserve(numTransitions);
+    for (int i = 0; i < numTransitions; i++) {
+      transitions.emplace_back(i % numStates,
+                               (i + 1) % numStates,
+                               i / numStates,
+                               makeGuard(i, &counter),
+                               makeAction(i, &counter));
+    }
+    StateMachine m{0, std::move(transitions)};
+    benchmark::DoNotOptimize(m.transitions.data());
+  }
+  s.SetItemsProcessed(s.iterations() * numTransitions);
+}
+
+static void constructFactoryChain(benchmark::State &s) {
+  using namespace susml::factory;
+
+  int counter = 0;
+  for (auto _ : s) {
+    std::vector<Transition> transitions;
+    transitions.reserve(numTransitions);
+    for (int i = 0; i < numTransitions; i++) {
+      transitions.push_back(From(i % numStates)
+                                .To((i + 1) % numStates)
+                                .On(i / numStates)
+                                .If(makeGuard(i, &counter))
+                                .Do(makeAction(i, &counter))
+                                .make());
+    }
+    StateMachine m{0, std::move(transitions)};
+    benchmark::DoNotOptimize(m.transitions.data());
+  }
+  s.SetItemsProcessed(s.iterations() * numTransitions);
+}
+
+static void constructFactorySteps(benchmark::State &s) {
+  using namespace susml::factory;
+
+  int counter = 0;
+  for (auto _ : s) {
+    std::vector<Transition> transitions;
+    transitions.reserve(numTransitions);
+    for (int i = 0; i < numTransitions; i++) {
+      // every step is kept, so the guard and action are copied into the next one
+      const auto withGuard  = If(makeGuard(i, &counter));
+      const auto withAction = withGuard.Do(makeAction(i, &counter));
+      const auto withSource = withAction.From(i % numStates);
+      const auto withTarget = withSource.To((i + 1) % numStates);
+      const auto withEvent  = withTarget.On(i / numStates);
+      transitions.push_back(withEvent.make());
+    }
+    StateMachine m{0, transitions};
+    benchmark::DoNotOptimize(m.transitions.data());
+  }
+  s.SetItemsProcessed(s.iterations() * numTransitions);
+}
+
+BENCHMARK(constructDirectly)->Unit(benchmark::kMillisecond);
+BENCHMARK(constructFactoryChain)->Unit(benchmark::kMillisecond);
+BENCHMARK(constructFactorySteps)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
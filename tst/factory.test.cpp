@@ -297,6 +297,58 @@ TEST(PartialTransitionTests, makeWithoutActions) {
   EXPECT_EQ(guardFalse, t.guard);
 }
 
+TEST(PartialTransitionTests, After) {
+  const auto t = From(State::on).To(State::off).After(30).make();
+  EXPECT_EQ(State::on, t.source);
+  EXPECT_EQ(State::off, t.target);
+  EXPECT_EQ(30, t.event.delay);
+  EXPECT_TRUE((std::is_same<susml::Timeout<int>, decltype(t)::Event>::value));
+
+  const auto p = After(30).From(State::on);
+  EXPECT_EQ(t.event, p.event);
+}
+
+TEST(PartialTransitionTests, makeWithPayload) {
+  auto isPositive = [](const int &payload) { return payload > 0; };
+
+  const auto t = From(State::off).To(State::on).On(Event::turnOn).If(isPositive).make<int>();
+  EXPECT_TRUE((std::is_same<int, decltype(t)::Payload>::value));
+  EXPECT_TRUE(t.HasPayload());
+  EXPECT_TRUE(t.guard(1));
+  EXPECT_FALSE(t.guard(-1));
+
+  EXPECT_FALSE(From(State::off).On(Event::turnOn).make().HasPayload());
+}
+
+TEST(PartialTransitionTests, chainMovesGuardsAndActions) {
+  // callable that counts how often it is copied
+  struct Counted {
+    int *numCopies;
+
+    explicit Counted(int *numCopies) : numCopies(numCopies) {}
+    Counted(const Counted &other) : numCopies(other.numCopies) { (*numCopies)++; }
+    Counted(Counted &&) noexcept = default;
+    Counted &operator=(const Counted &) = delete;
+    Counted &operator=(Counted &&) = delete;
+    ~Counted()                     = default;
+
+    bool operator()() const { return true; }
+  };
+
+  int numCopies = 0;
+
+  const auto t = From(State::off).To(State::on).On(Event::turnOn).If(Counted{&numCopies}).make();
+  EXPECT_EQ(0, numCopies);
+  EXPECT_TRUE(t.guard());
+
+  // steps on lvalues still copy, and leave the original intact
+  const auto p = From(State::off).To(State::on).On(Event::turnOn).If(Counted{&numCopies});
+  const auto u = p.make();
+  EXPECT_EQ(1, numCopies);
+  EXPECT_EQ(&numCopies, p.guard.numCopies);
+  EXPECT_TRUE(u.guard());
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
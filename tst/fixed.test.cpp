@@ -0,0 +1,185 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "fixed.hpp"
+#include "vectorbased.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+// count every allocation in the program, to check that the fixed machine does none
+namespace {
+std::size_t numAllocations = 0;
+} // namespace
+
+void *operator new(std::size_t size) {
+  numAllocations++;
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) { std::abort(); }
+  return p;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void  operator delete(void *p) noexcept { std::free(p); }
+void  operator delete[](void *p) noexcept { std::free(p); }
+void  operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void  operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+using susml::fixed::InlineFunction;
+using susml::fixed::StateMachine;
+
+namespace Encoder {
+enum class State { idle, cw1, cw2, cw3, ccw1, ccw2, ccw3 };
+enum class Event { update };
+
+using Transition = susml::fixed::Transition<State, Event, 3 * sizeof(void *)>; // &a, &b, x and y
+using Machine    = StateMachine<Transition, 16>;
+} // namespace Encoder
+
+TEST(FixedTests, ownsNoHeapMemory) {
+  static_assert(std::is_trivially_copyable<InlineFunction<bool()>>::value);
+  static_assert(std::is_trivially_copyable<Encoder::Transition>::value);
+  static_assert(std::is_trivially_destructible<Encoder::Machine>::value);
+  EXPECT_GE(sizeof(Encoder::Machine), 16 * sizeof(Encoder::Transition));
+}
+
+TEST(FixedTests, encoderDoesNotAllocate) {
+  using namespace Encoder;
+
+  bool a     = false;
+  bool b     = false;
+  int  delta = 0;
+
+  const std::size_t before = numAllocations;
+
+  auto is   = [&](bool x, bool y) { return [&a, &b, x, y] { return a == x && b == y; }; };
+  auto up   = [&delta] { delta++; };
+  auto down = [&delta] { delta--; };
+
+  Machine m{State::idle,
+            {{State::idle, State::cw1, Event::update, is(false, true)},
+             {State::cw1, State::idle, Event::update, is(false, false)},
+             {State::cw1, State::cw2, Event::update, is(true, true)},
+             {State::cw2, State::cw1, Event::update, is(false, true)},
+             {State::cw2, State::cw3, Event::update, is(true, false)},
+             {State::cw3, State::cw2, Event::update, is(true, true)},
+             {State::cw3, State::idle, Event::update, is(false, false), up},
+             {State::idle, State::ccw1, Event::update, is(true, false)},
+             {State::ccw1, State::idle, Event::update, is(false, false)},
+             {State::ccw1, State::ccw2, Event::update, is(true, true)},
+             {State::ccw2, State::ccw1, Event::update, is(true, false)},
+             {State::ccw2, State::ccw3, Event::update, is(false, true)},
+             {State::ccw3, State::ccw2, Event::update, is(true, true)},
+             {State::ccw3, State::idle, Event::update, is(false, false), down}}};
+
+  auto update = [&](bool newA, bool newB) {
+    a = newA;
+    b = newB;
+    m.trigger(Event::update);
+  };
+  for (int i = 0; i < 100; i++) {
+    update(false, true);
+    update(true, true);
+    update(true, false);
+    update(false, false);
+  }
+  for (int i = 0; i < 30; i++) {
+    update(true, false);
+    update(true, true);
+    update(false, true);
+    update(false, false);
+  }
+
+  const std::size_t after = numAllocations;
+  EXPECT_EQ(before, after);
+  EXPECT_EQ(70, delta);
+  EXPECT_EQ(State::idle, m.currentState);
+}
+
+TEST(FixedTests, allocationsAreCounted) {
+  // a vector-based machine allocates its transitions, so the counter is in effect
+  using Transition = susml::Transition<int, int>;
+
+  const std::size_t before = numAllocations;
+  {
+    susml::vectorbased::StateMachine<Transition> m{0, {{0, 1, 0}, {1, 0, 0}}};
+    m.trigger(0);
+  }
+  EXPECT_LT(before, numAllocations);
+}
+
+TEST(FixedTests, emptyGuardsPassAndEmptyActionsDoNothing) {
+  using Transition = susml::fixed::Transition<int, int>;
+
+  int                         n = 0;
+  StateMachine<Transition, 3> m{0,
+                                {{0, 1, 0},
+                                 {1, 2, 0, nullptr, [&n] { n++; }},
+                                 {2, 0, 0, [&n] { return n > 1; }}}};
+  m.trigger(0);
+  m.trigger(0);
+  EXPECT_EQ(2, m.currentState);
+  EXPECT_EQ(1, n);
+  m.trigger(0);
+  EXPECT_EQ(2, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+TEST(FixedTests, addUpToCapacity) {
+  using Transition = susml::Transition<int, int>;
+
+  StateMachine<Transition, 2> m{0};
+  EXPECT_TRUE(m.add({0, 1, 0}));
+  EXPECT_TRUE(m.add({1, 0, 0}));
+  EXPECT_FALSE(m.add({1, 2, 1}));
+  EXPECT_EQ(2U, m.transitions.size());
+
+  m.trigger(0);
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(1);
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+TEST(FixedTests, payload) {
+  using namespace susml::factory;
+  using Guard  = InlineFunction<bool(const int &)>;
+  using Action = InlineFunction<void(const int &)>;
+
+  int sum = 0;
+
+  const Guard  fits = [&sum](const int &n) { return sum + n <= 10; };
+  const Action add  = [&sum](const int &n) { sum += n; };
+
+  using Transition = susml::Transition<int, int, Guard, Action, int>;
+  StateMachine<Transition, 1> m{0, {From(0).To(0).On(0).If(fits).Do(add).make<int>()}};
+
+  const std::size_t before = numAllocations;
+  for (int n : {4, 5, 3, 1}) {
+    m.trigger(0, n);
+  }
+  const std::size_t after = numAllocations;
+
+  EXPECT_EQ(before, after);
+  EXPECT_EQ(10, sum);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,75 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Random guardless machines of 16 to 16384 transitions (4 per state, on 4 events) run on the
+// vector-based machine and on the machine freeze() makes of it, with dense states (which get a
+// table, narrowed from 16384 transitions on) and with states spaced far apart (which get a hash
+// index). The report of the frozen machine is printed as a label.
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+#include "common.hpp"
+#include "frozen.hpp"
+#include "vectorbased.hpp"
+
+using Transition = susml::Transition<long, int>;
+
+// cheap pseudo-random numbers, so generating the transitions does not dominate
+struct Lcg {
+  std::uint64_t x = 42;
+
+  std::uint64_t operator()() {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x >> 33U;
+  }
+};
+
+susml::vectorbased::StateMachine<Transition> makeMachine(long n, long stride) {
+  Lcg                     random;
+  const auto              numStates = static_cast<std::uint64_t>(n / 4);
+  std::vector<Transition> transitions;
+  for (long i = 0; i < n; i++) {
+    const auto source = i / 4;
+    const auto target = static_cast<long>(random() % numStates);
+    transitions.push_back({source * stride, target * stride, static_cast<int>(i % 4)});
+  }
+  return {0, std::move(transitions)};
+}
+
+static void runVectorBased(benchmark::State &s) {
+  auto m = makeMachine(s.range(0), s.range(1));
+  Lcg  random;
+  for (auto _ : s) {
+    m.trigger(static_cast<int>(random() % 4));
+    benchmark::DoNotOptimize(m.currentState);
+  }
+}
+
+static void runFrozen(benchmark::State &s) {
+  auto frozen = susml::frozen::freeze(makeMachine(s.range(0), s.range(1)));
+  auto &m     = frozen.machine;
+  Lcg   random;
+  for (auto _ : s) {
+    m.trigger(static_cast<int>(random() % 4));
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetLabel(susml::frozen::toString(frozen.report.representation));
+}
+
+// second argument: the distance between states
+BENCHMARK(runVectorBased)->ArgsProduct({{16, 256, 4096, 16384}, {1, 1000003}});
+BENCHMARK(runFrozen)->ArgsProduct({{16, 256, 4096, 16384}, {1, 1000003}});
+
+BENCHMARK_MAIN();
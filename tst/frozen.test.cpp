@@ -0,0 +1,154 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "frozen.hpp"
+#include "vectorbased.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+using susml::frozen::freeze;
+using susml::frozen::Representation;
+
+using Transition = susml::Transition<long, long, std::function<bool()>, std::function<void()>>;
+
+// Random machine over numStates states and 4 events spaced stateStride and eventStride apart,
+// with duplicate (source, event) pairs whose guards fail every so often, and actions that record
+// the transition taken.
+std::vector<Transition> makeRandomTransitions(std::size_t       numTransitions,
+                                              long              numStates,
+                                              long              stateStride,
+                                              long              eventStride,
+                                              const long &      tick,
+                                              std::vector<int> &log) {
+  std::mt19937                        mt{42};
+  std::uniform_int_distribution<long> state(0, numStates - 1);
+  std::uniform_int_distribution<long> event(0, 3);
+
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < numTransitions; i++) {
+    const auto id = static_cast<int>(i);
+    transitions.push_back({state(mt) * stateStride,
+                           state(mt) * stateStride,
+                           event(mt) * eventStride,
+                           [&tick, id] { return (tick + id) % 5 != 0; },
+                           [&log, id] { log.push_back(id); }});
+  }
+  return transitions;
+}
+
+void expectSameRun(std::size_t    numTransitions,
+                   long           numStates,
+                   long           stateStride,
+                   long           eventStride,
+                   Representation expectedRepresentation) {
+  long             tick = 0;
+  std::vector<int> expected;
+  std::vector<int> actual;
+
+  auto make = [&](std::vector<int> &log) {
+    return susml::vectorbased::StateMachine<Transition>{
+        0, makeRandomTransitions(numTransitions, numStates, stateStride, eventStride, tick, log)};
+  };
+  auto reference = make(expected);
+  auto frozen    = freeze(make(actual));
+  EXPECT_EQ(expectedRepresentation, frozen.report.representation)
+      << susml::frozen::toString(frozen.report.representation);
+  EXPECT_TRUE(frozen.report.hasGuards);
+  EXPECT_FALSE(frozen.report.isDeterministic);
+
+  std::mt19937                        mt{43};
+  std::uniform_int_distribution<long> event(0, 4); // 4 has no transitions
+  for (; tick < 2000; tick++) {
+    const auto e = event(mt) * eventStride;
+    reference.trigger(e);
+    frozen.machine.trigger(e);
+    ASSERT_EQ(reference.currentState, frozen.machine.currentState);
+  }
+  EXPECT_EQ(expected, actual);
+  EXPECT_EQ(reference.numUnhandledEvents, frozen.machine.numUnhandledEvents);
+}
+
+TEST(FrozenTests, choosesRepresentationByDensity) {
+  expectSameRun(400, 40, 1, 1, Representation::denseTable);
+  expectSameRun(40000, 5000, 1, 1, Representation::narrowTable);
+  expectSameRun(400, 40, 1, 1000003, Representation::sourceOffsets);
+  expectSameRun(400, 40, 1000003, 1, Representation::hashIndex);
+}
+
+TEST(FrozenTests, negativeTargetStatesHaveNoTransitions) {
+  using Plain = susml::Transition<long, long>;
+
+  // -1 as a target makes the largest state huge, which rules out the table
+  auto frozen = freeze(susml::vectorbased::StateMachine<Plain>{0, {{0, -1, 0}, {1, 0, 0}}});
+  EXPECT_EQ(Representation::sourceOffsets, frozen.report.representation);
+  frozen.machine.trigger(0);
+  EXPECT_EQ(-1, frozen.machine.currentState);
+  frozen.machine.trigger(0);
+  EXPECT_EQ(-1, frozen.machine.currentState);
+  EXPECT_EQ(1U, frozen.machine.numUnhandledEvents);
+}
+
+TEST(FrozenTests, fallsBackToLinearSearch) {
+  struct Point {
+    int  x;
+    int  y;
+    bool operator==(const Point &other) const { return x == other.x && y == other.y; }
+  };
+  using PointTransition = susml::Transition<Point, char>;
+
+  auto original = susml::vectorbased::StateMachine<PointTransition>{
+      {0, 0}, {{{0, 0}, {0, 1}, 'n'}, {{0, 1}, {1, 1}, 'e'}, {{1, 1}, {0, 0}, 'd'}}};
+  original.removeTransition(2);
+  auto frozen = freeze(original);
+  EXPECT_EQ(Representation::linear, frozen.report.representation);
+  EXPECT_EQ(2U, frozen.report.numTransitions);
+
+  for (const char event : {'n', 'e', 'd', 'n'}) {
+    frozen.machine.trigger(event);
+  }
+  EXPECT_EQ(1, frozen.machine.currentState.x);
+  EXPECT_EQ(1, frozen.machine.currentState.y);
+  EXPECT_EQ(2U, frozen.machine.numUnhandledEvents);
+}
+
+TEST(FrozenTests, reportsWhatItFound) {
+  enum class State { idle, running, done };
+  using StateTransition = susml::Transition<State, int>;
+
+  auto original = susml::vectorbased::StateMachine<StateTransition>{
+      State::idle,
+      {{State::idle, State::running, 0},
+       {State::running, State::done, 7},
+       {State::done, State::idle, 0}}};
+  auto frozen = freeze(original);
+  EXPECT_EQ(Representation::denseTable, frozen.report.representation);
+  EXPECT_EQ(3U, frozen.report.numTransitions);
+  EXPECT_EQ(3U, frozen.report.numStates);
+  EXPECT_EQ(2U, frozen.report.numEvents);
+  EXPECT_EQ(2U, frozen.report.maxState);
+  EXPECT_EQ(7U, frozen.report.maxEvent);
+  EXPECT_FALSE(frozen.report.hasGuards);
+  EXPECT_TRUE(frozen.report.isDeterministic);
+  EXPECT_EQ(3 * 8 * sizeof(std::uint32_t), frozen.report.indexBytes); // no next links
+
+  frozen.machine.trigger(0);
+  frozen.machine.trigger(0);
+  frozen.machine.trigger(7);
+  EXPECT_EQ(State::done, frozen.machine.currentState);
+  EXPECT_EQ(1U, frozen.machine.numUnhandledEvents);
+}
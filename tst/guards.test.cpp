@@ -0,0 +1,199 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "guards.hpp"
+#include "tuplebased.hpp"
+#include "vectorbased.hpp"
+
+#include <array>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+using susml::guards::Guard;
+using susml::guards::var;
+
+TEST(GuardExpressionTests, compiledGuardsMatchExpressions) {
+  bool a = false;
+  bool b = false;
+  bool c = false;
+  int  n = 0;
+
+  const auto e1 = var(a) && !var(b);
+  const auto e2 = !(var(a) || var(b)) || (var(c) && var(n) >= 2);
+  const auto e3 = !(var(a) && (var(b) || !var(c))) && var(n) != 1;
+  const auto e4 = var(a) && !var(a); // never holds
+  const auto e5 = var(n) < 1 || var(n) > 2 || var(n) == 2;
+  const auto e6 = var(a) == false && !(var(b) == true);
+
+  const Guard g1 = e1;
+  const Guard g2 = e2;
+  const Guard g3 = e3;
+  const Guard g4 = e4;
+  const Guard g5 = e5;
+  const Guard g6 = e6;
+
+  EXPECT_TRUE(g4.dnf.terms.empty());
+  EXPECT_EQ(3, g5.dnf.atoms.size()); // n < 1, n > 2 and n == 2
+  EXPECT_EQ(2, g6.dnf.atoms.size()); // a and b
+
+  for (int i = 0; i < 32; i++) {
+    a = (i & 1) != 0;
+    b = (i & 2) != 0;
+    c = (i & 4) != 0;
+    n = i / 8;
+    EXPECT_EQ(e1(), g1());
+    EXPECT_EQ(e2(), g2());
+    EXPECT_EQ(e3(), g3());
+    EXPECT_FALSE(g4());
+    EXPECT_EQ(e5(), g5());
+    EXPECT_EQ(!a && !b, g6());
+  }
+
+  EXPECT_TRUE(Guard{}());
+}
+
+template <std::size_t... I>
+constexpr auto anyIsOne(const std::array<int, sizeof...(I)> &inputs, std::index_sequence<I...>) {
+  return (... || (var(inputs[I]) == 1));
+}
+
+TEST(GuardExpressionTests, guardsTakeUpTo64Atoms) {
+  std::array<int, 64> inputs{};
+  const auto          any = anyIsOne(inputs, std::make_index_sequence<64>{});
+  static_assert(susml::guards::expression::numAtoms<decltype(any)>() == 64);
+  // one more would not compile as a Guard, even if it is an atom that is already used
+  static_assert(susml::guards::expression::numAtoms<decltype(any || var(inputs[0]) == 1)>() == 65);
+
+  const Guard g = any;
+  EXPECT_EQ(64U, g.dnf.atoms.size());
+  EXPECT_FALSE(g());
+  inputs[63] = 1;
+  EXPECT_TRUE(g());
+  inputs[63] = 0;
+  inputs[0]  = 1;
+  EXPECT_TRUE(g());
+}
+
+TEST(GuardExpressionTests, expressionsAreTupleBasedGuards) {
+  enum class State { off, on };
+
+  bool power = false;
+
+  auto transitions = std::make_tuple(susml::Transition(State::off, State::on, true, var(power)),
+                                     susml::Transition(State::on, State::off, true, !var(power)));
+  auto m = susml::tuplebased::StateMachine<State, bool, decltype(transitions)>{State::off,
+                                                                               transitions};
+
+  m.trigger(true);
+  EXPECT_EQ(State::off, m.currentState);
+  power = true;
+  m.trigger(true);
+  EXPECT_EQ(State::on, m.currentState);
+  power = false;
+  m.trigger(true);
+  EXPECT_EQ(State::off, m.currentState);
+}
+
+namespace Encoder {
+enum class State { idle, cw1, cw2, cw3, ccw1, ccw2, ccw3 };
+enum class Event { update };
+
+using Action     = std::function<void()>;
+using Transition = susml::Transition<State, Event, Guard, Action>;
+
+std::vector<Transition> makeTransitions(const bool &a, const bool &b, int &delta) {
+  using namespace susml::factory;
+
+  const Guard is00    = !var(a) && !var(b);
+  const Guard is01    = !var(a) && var(b);
+  const Guard is10    = var(a) && !var(b);
+  const Guard is11    = var(a) && var(b);
+  const auto  Nothing = Action([] {});
+  const auto  Up      = Action([&] { delta++; });
+  const auto  Down    = Action([&] { delta--; });
+
+  return {From(State::idle).To(State::cw1).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::cw1).To(State::idle).On(Event::update).If(is00).Do(Nothing).make(),
+          From(State::cw1).To(State::cw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::cw2).To(State::cw1).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::cw2).To(State::cw3).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::cw3).To(State::cw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::cw3).To(State::idle).On(Event::update).If(is00).Do(Up).make(),
+          From(State::idle).To(State::ccw1).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::ccw1).To(State::idle).On(Event::update).If(is00).Do(Nothing).make(),
+          From(State::ccw1).To(State::ccw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::ccw2).To(State::ccw1).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::ccw2).To(State::ccw3).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::ccw3).To(State::ccw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::ccw3).To(State::idle).On(Event::update).If(is00).Do(Down).make()};
+}
+} // namespace Encoder
+
+TEST(GuardStateMachineTests, behavesLikeVectorBased) {
+  bool a          = false;
+  bool b          = false;
+  int  deltaTable = 0;
+  int  deltaPlain = 0;
+
+  auto m = susml::guards::StateMachine<Encoder::Transition>{
+      Encoder::State::idle, Encoder::makeTransitions(a, b, deltaTable)};
+  auto reference = susml::vectorbased::StateMachine<Encoder::Transition>{
+      Encoder::State::idle, Encoder::makeTransitions(a, b, deltaPlain)};
+
+  ASSERT_TRUE(m.isCompiled);
+  EXPECT_EQ(2, m.atoms.size());
+
+  std::mt19937 mt{42};
+  for (int i = 0; i < 10000; i++) {
+    if (mt() % 2 == 0) {
+      a = !a;
+    } else {
+      b = !b;
+    }
+    m.trigger(Encoder::Event::update);
+    reference.trigger(Encoder::Event::update);
+    ASSERT_EQ(reference.currentState, m.currentState);
+  }
+  EXPECT_EQ(deltaPlain, deltaTable);
+  EXPECT_NE(0, deltaTable);
+}
+
+TEST(GuardStateMachineTests, manyAtomsFallBackToCallingGuards) {
+  using Transition = susml::Transition<int, int, Guard>;
+
+  std::vector<int>        inputs(65, 0);
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < inputs.size(); i++) {
+    transitions.push_back({0, static_cast<int>(i) + 1, 0, var(inputs[i]) == 1});
+  }
+
+  auto m = susml::guards::StateMachine<Transition>{0, transitions};
+  EXPECT_FALSE(m.isCompiled);
+
+  m.trigger(0);
+  EXPECT_EQ(0, m.currentState);
+  inputs[64] = 1;
+  m.trigger(0);
+  EXPECT_EQ(65, m.currentState);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
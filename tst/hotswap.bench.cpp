@@ -0,0 +1,84 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Overhead of pinning the current version on every trigger: a guardless circle (of 4 and of 64
+// states, the argument) in a plain vector-based machine and in a hot-swappable one, the latter
+// also while another thread publishes a new version every 100us.
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "hotswap.hpp"
+#include "vectorbased.hpp"
+
+using Transition = susml::Transition<int, int>;
+
+std::vector<Transition> makeCircle(int numStates) {
+  std::vector<Transition> transitions;
+  for (int s = 0; s < numStates; s++) {
+    transitions.push_back({s, (s + 1) % numStates, 0});
+  }
+  return transitions;
+}
+
+static void circleVectorBased(benchmark::State &s) {
+  auto m = susml::vectorbased::StateMachine<Transition>{0, makeCircle(s.range(0))};
+  for (auto _ : s) {
+    m.trigger(0);
+    benchmark::DoNotOptimize(m.currentState);
+  }
+}
+
+static void circleHotSwap(benchmark::State &s) {
+  susml::hotswap::Holder<Transition> holder{
+      susml::hotswap::Version<Transition>{makeCircle(s.range(0))}};
+  auto m = susml::hotswap::StateMachine<Transition>{holder, 0};
+  for (auto _ : s) {
+    m.trigger(0);
+    benchmark::DoNotOptimize(m.currentState);
+  }
+}
+
+static void circleHotSwapWhilePublishing(benchmark::State &s) {
+  const int numStates = s.range(0);
+
+  susml::hotswap::Holder<Transition> holder{
+      susml::hotswap::Version<Transition>{makeCircle(numStates)}};
+
+  std::atomic<bool> isDone{false};
+  std::thread       publisher([&] {
+    while (!isDone.load()) {
+      holder.publish(susml::hotswap::Version<Transition>{makeCircle(numStates)});
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+
+  auto m = susml::hotswap::StateMachine<Transition>{holder, 0};
+  for (auto _ : s) {
+    m.trigger(0);
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  isDone.store(true);
+  publisher.join();
+  s.counters["versions"] = static_cast<double>(m.versionNumber);
+}
+
+BENCHMARK(circleVectorBased)->Arg(4)->Arg(64);
+BENCHMARK(circleHotSwap)->Arg(4)->Arg(64);
+BENCHMARK(circleHotSwapWhilePublishing)->Arg(4)->Arg(64);
+
+BENCHMARK_MAIN();
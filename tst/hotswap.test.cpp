@@ -0,0 +1,148 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "context.hpp"
+#include "hotswap.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using susml::hotswap::Holder;
+using susml::hotswap::StateMachine;
+using susml::hotswap::Version;
+
+TEST(HotSwapTests, instancesSwitchOnTheirNextTrigger) {
+  using Transition = susml::Transition<int, int>;
+
+  Holder<Transition> holder{Version<Transition>{{{0, 1, 0}, {1, 0, 0}}}};
+  auto               m1 = StateMachine<Transition>{holder, 0};
+  auto               m2 = StateMachine<Transition>{holder, 0};
+
+  m1.trigger(0);
+  EXPECT_EQ(1, m1.currentState);
+
+  // the new version has states 10 and 11, and a way out of 11 on event 1
+  const auto number = holder.publish(Version<Transition>{{{10, 11, 0}, {11, 10, 0}, {11, 12, 1}},
+                                                         [](const int &s) { return s + 10; }});
+  EXPECT_EQ(1U, number);
+
+  m1.trigger(1);
+  EXPECT_EQ(12, m1.currentState);
+  EXPECT_EQ(1U, m1.versionNumber);
+  m2.trigger(0);
+  EXPECT_EQ(11, m2.currentState);
+  EXPECT_EQ(0U, holder.retired.size());
+}
+
+TEST(HotSwapTests, lastVersionsAreReclaimedWithoutPublishing) {
+  using Transition = susml::Transition<int, int>;
+
+  Holder<Transition> holder{Version<Transition>{{{0, 1, 0}}}};
+  auto               m = StateMachine<Transition>{holder, 0};
+
+  // publish while m is triggering, so the old version must outlive the publish
+  const auto *pinned = holder.pin(*m.slot);
+  holder.publish(Version<Transition>{{{0, 2, 0}}});
+  EXPECT_EQ(1U, holder.retired.size());
+  EXPECT_EQ(1, pinned->transitions.front().target); // still alive
+  holder.unpin(*m.slot);
+  EXPECT_EQ(0U, holder.retired.size());
+
+  m.trigger(0);
+  EXPECT_EQ(2, m.currentState);
+}
+
+TEST(HotSwapTests, versionsAreReclaimedOnceUnpinned) {
+  using Transition = susml::Transition<int, int>;
+
+  Holder<Transition> holder{Version<Transition>{{{0, 1, 0}}}};
+  auto *             reader = holder.registerReader();
+
+  const auto *pinned = holder.pin(*reader);
+  holder.publish(Version<Transition>{{{0, 2, 0}}});
+  holder.publish(Version<Transition>{{{0, 3, 0}}});
+  EXPECT_EQ(2U, holder.retired.size());
+  EXPECT_EQ(1, pinned->transitions.front().target); // still alive
+
+  holder.unpin(*reader);
+  EXPECT_EQ(0U, holder.retired.size()); // reclaimed by the unpin, without waiting for a publish
+
+  // a reader that pinned after the last publish does not hold back older versions
+  holder.pin(*reader);
+  holder.publish(Version<Transition>{{{0, 4, 0}}});
+  EXPECT_EQ(1U, holder.retired.size());
+  holder.unpin(*reader);
+  holder.unregisterReader(reader);
+  EXPECT_EQ(0U, holder.retired.size());
+}
+
+TEST(HotSwapTests, publishWhileTriggering) {
+  // every instance counts in its own context
+  using Transition = susml::context::Transition<int, int, long>;
+
+  // versions alternate between a circle of 8 and of 4 states, with an action on event 1 in state 0
+  auto makeVersion = [](int numStates) {
+    std::vector<Transition> transitions;
+    for (int s = 0; s < numStates; s++) {
+      transitions.push_back({s, (s + 1) % numStates, 0, nullptr, nullptr});
+    }
+    transitions.push_back({0, 0, 1, nullptr, [](long &n) { n++; }});
+    return Version<Transition>{transitions, [numStates](const int &s) { return s % numStates; }};
+  };
+
+  Holder<Transition> holder{makeVersion(8)};
+  std::atomic<bool>  isDone{false};
+  std::atomic<int>   numStarted{0};
+
+  constexpr int     numThreads = 4;
+  std::vector<long> counts(numThreads, 0);
+  {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++) {
+      threads.emplace_back([&, i] {
+        auto m = StateMachine<Transition>{holder, counts[i], 0};
+        while (!isDone.load()) {
+          for (int n = 0; n < 8; n++) {
+            m.trigger(0);
+          }
+          m.trigger(1);
+          if (counts[i] == 1) { numStarted++; }
+        }
+      });
+    }
+    // keep publishing until every thread has triggered on some version
+    for (int v = 0; v < 200 || numStarted.load() < numThreads; v++) {
+      holder.publish(makeVersion((v % 2 == 0) ? 4 : 8));
+      std::this_thread::yield();
+    }
+    isDone.store(true);
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  for (const auto count : counts) {
+    EXPECT_LT(0, count);
+  }
+  EXPECT_EQ(0U, holder.reclaim());
+  EXPECT_LE(200U, holder.current.load()->number);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,153 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "image.hpp"
+#include "vectorbased.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using susml::image::Image;
+using susml::image::NoAction;
+using susml::image::StateMachine;
+
+enum class Light { red, green, yellow };
+enum class Signal { go, slow, stop, ignored };
+
+using Transition = susml::Transition<Light, Signal>;
+
+const std::vector<Transition> lightTransitions = {{Light::red, Light::green, Signal::go},
+                                                  {Light::green, Light::yellow, Signal::slow},
+                                                  {Light::green, Light::red, Signal::slow},
+                                                  {Light::yellow, Light::red, Signal::stop},
+                                                  {Light::green, Light::red, Signal::stop}};
+
+TEST(ImageTests, runsLikeVectorBased) {
+  const auto bytes = susml::image::write(Light::red, lightTransitions);
+  const auto image = Image::load(bytes.data(), bytes.size());
+  ASSERT_TRUE(image.isValid());
+  EXPECT_TRUE(image.isConsistent());
+  EXPECT_EQ(3U, image.header->numStates);
+  EXPECT_EQ(4U, image.header->numRecords); // the second transition on green & slow is dropped
+
+  auto m = StateMachine<Light, Signal>{image};
+  auto v = susml::vectorbased::StateMachine<Transition>{Light::red, lightTransitions};
+
+  const std::vector<Signal> signals = {Signal::stop, Signal::go,      Signal::slow,
+                                       Signal::go,   Signal::stop,    Signal::go,
+                                       Signal::stop, Signal::ignored, Signal::slow};
+  for (const auto s : signals) {
+    m.trigger(s);
+    v.trigger(s);
+    EXPECT_EQ(v.currentState, m.currentState());
+  }
+  EXPECT_EQ(v.numUnhandledEvents, m.numUnhandledEvents);
+
+  EXPECT_TRUE(m.setState(Light::yellow));
+  m.trigger(Signal::stop);
+  EXPECT_EQ(Light::red, m.currentState());
+}
+
+TEST(ImageTests, actionsAreBoundOnLoad) {
+  using Transition = susml::Transition<int, long, susml::NoneType, std::function<void()>>;
+
+  // sparse events, so they are found by binary search rather than in a table
+  const std::vector<Transition> transitions = {
+      {0, 1, 1000000L, {}, [] {}}, {1, 0, -5L, {}, [] {}}, {1, 2, 7L, {}, {}}};
+  const auto bytes = susml::image::write(0, transitions, [&](const Transition &t) {
+    return (t.event == 7L) ? NoAction : static_cast<std::uint32_t>(t.source);
+  });
+  const auto image = Image::load(bytes.data(), bytes.size());
+  ASSERT_TRUE(image.isValid());
+  EXPECT_EQ(0U, image.header->numDense);
+  EXPECT_EQ(2U, image.header->numActions);
+
+  int  count = 0;
+  auto m     = StateMachine<int, long>{image};
+  EXPECT_TRUE(m.bind(0, [&] { count += 1; }));
+  EXPECT_TRUE(m.bind(1, [&] { count += 10; }));
+  EXPECT_FALSE(m.bind(2, [&] { count += 100; })); // no such action id
+
+  m.trigger(1000000L);
+  m.trigger(-5L);
+  m.trigger(1000000L);
+  m.trigger(7L);
+  EXPECT_EQ(2, m.currentState());
+  EXPECT_EQ(12, count);
+}
+
+TEST(ImageTests, corruptImagesAreRejected) {
+  const auto bytes = susml::image::write(Light::red, lightTransitions);
+
+  EXPECT_FALSE(Image::load(bytes.data(), bytes.size() - 8).isValid());
+  EXPECT_FALSE(Image::load(bytes.data(), sizeof(susml::image::Header) - 1).isValid());
+
+  auto badMagic = bytes;
+  badMagic[0]   = 'X';
+  EXPECT_FALSE(Image::load(badMagic.data(), badMagic.size()).isValid());
+
+  // a machine on an invalid image has no states
+  auto m = StateMachine<Light, Signal>{Image::load(badMagic.data(), badMagic.size())};
+  EXPECT_FALSE(m.isValid());
+  EXPECT_FALSE(m.setState(Light::green));
+  EXPECT_FALSE(m.bind(0, [] {}));
+  m.trigger(Signal::go);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+
+  auto badVersion = bytes;
+  reinterpret_cast<susml::image::Header *>(badVersion.data())->version++;
+  EXPECT_FALSE(Image::load(badVersion.data(), badVersion.size()).isValid());
+
+  auto badOffset = bytes;
+  reinterpret_cast<susml::image::Header *>(badOffset.data())->records = bytes.size();
+  EXPECT_FALSE(Image::load(badOffset.data(), badOffset.size()).isValid());
+
+  // a bad target is only found by the full check
+  auto        badTarget = bytes;
+  const auto  badImage  = Image::load(badTarget.data(), badTarget.size());
+  const auto &header    = *badImage.header;
+  auto *      records = reinterpret_cast<susml::image::Record *>(badTarget.data() + header.records);
+  records[0].target   = header.numStates;
+  EXPECT_TRUE(badImage.isValid());
+  EXPECT_FALSE(badImage.isConsistent());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST(ImageTests, runsFromMappedFile) {
+  const char *path = "susml_image_test.img";
+  ASSERT_TRUE(susml::image::writeFile(path, susml::image::write(Light::red, lightTransitions)));
+
+  {
+    const susml::image::MappedFile file{path};
+    ASSERT_TRUE(file.isOpen());
+    const auto image = file.load();
+    ASSERT_TRUE(image.isValid());
+
+    auto m1 = StateMachine<Light, Signal>{image};
+    auto m2 = StateMachine<Light, Signal>{image};
+    m1.trigger(Signal::go);
+    m1.trigger(Signal::slow);
+    m2.trigger(Signal::go);
+    EXPECT_EQ(Light::yellow, m1.currentState());
+    EXPECT_EQ(Light::green, m2.currentState());
+  }
+  std::remove(path);
+
+  EXPECT_FALSE(susml::image::MappedFile{"does/not/exist.img"}.isOpen());
+}
+#endif
@@ -0,0 +1,101 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Construction throughput of large machines: streaming 10^4 to 10^7 transitions (8 per state)
+// into a builder and building the indexed machine, on one thread and on all of them, with dense
+// and with sparse states. The vector-based machine, which only moves the vector in and builds no
+// index, is the baseline. Peak RSS is that of the whole process so far, so it only grows over the
+// runs of a benchmark.
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "indexed.hpp"
+#include "vectorbased.hpp"
+
+using Transition = susml::Transition<long, int>;
+
+// cheap pseudo-random numbers, so generating the transitions does not dominate
+struct Lcg {
+  std::uint64_t x = 42;
+
+  std::uint64_t operator()() {
+    x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return x >> 33U;
+  }
+};
+
+Transition makeTransition(Lcg &random, long numStates, long stride) {
+  const auto source = static_cast<long>(random() % static_cast<std::uint64_t>(numStates));
+  const auto target = static_cast<long>(random() % static_cast<std::uint64_t>(numStates));
+  return {source * stride, target * stride, static_cast<int>(random() % 8)};
+}
+
+void setCounters(benchmark::State &s) {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  s.counters["peakRssMB"] = static_cast<double>(usage.ru_maxrss) / 1024;
+  s.SetItemsProcessed(s.iterations() * s.range(0));
+}
+
+template <long Stride>
+static void buildIndexed(benchmark::State &s) {
+  const auto        n          = s.range(0);
+  const std::size_t numThreads = (s.range(1) == 0) ? std::thread::hardware_concurrency() : 1;
+  for (auto _ : s) {
+    Lcg                                 random;
+    susml::indexed::Builder<Transition> builder;
+    builder.reserve(static_cast<std::size_t>(n));
+    for (long i = 0; i < n; i++) {
+      builder.add(makeTransition(random, n / 8, Stride));
+    }
+    auto m = builder.build(0, numThreads);
+    benchmark::DoNotOptimize(m.transitions.data());
+  }
+  setCounters(s);
+}
+
+static void buildVectorBased(benchmark::State &s) {
+  const auto n = s.range(0);
+  for (auto _ : s) {
+    Lcg                     random;
+    std::vector<Transition> transitions;
+    transitions.reserve(static_cast<std::size_t>(n));
+    for (long i = 0; i < n; i++) {
+      transitions.push_back(makeTransition(random, n / 8, 1));
+    }
+    auto m = susml::vectorbased::StateMachine<Transition>{0, std::move(transitions)};
+    benchmark::DoNotOptimize(m.transitions.data());
+  }
+  setCounters(s);
+}
+
+// second argument: 1 for a single thread, 0 for all of them
+BENCHMARK(buildVectorBased)
+    ->RangeMultiplier(10)
+    ->Range(10000, 10000000)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(buildIndexed, 1)
+    ->ArgsProduct({{10000, 100000, 1000000, 10000000}, {1, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(buildIndexed, 1000003)
+    ->ArgsProduct({{10000, 100000, 1000000, 10000000}, {1, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
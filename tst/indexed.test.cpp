@@ -0,0 +1,150 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "indexed.hpp"
+#include "vectorbased.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+using susml::indexed::Builder;
+using susml::indexed::StateMachine;
+
+using Transition = susml::Transition<long, int, std::function<bool()>, std::function<void()>>;
+
+// Random machine over numStates states spaced stride apart, with duplicate (source, event) pairs
+// whose guards fail every so often, and actions that record the transition taken.
+std::vector<Transition> makeRandomTransitions(std::size_t      numTransitions,
+                                              long             numStates,
+                                              long             stride,
+                                              const long &     tick,
+                                              std::vector<int> &log) {
+  std::mt19937                        mt{42};
+  std::uniform_int_distribution<long> state(0, numStates - 1);
+  std::uniform_int_distribution<int>  event(0, 3);
+
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < numTransitions; i++) {
+    const auto id = static_cast<int>(i);
+    transitions.push_back({state(mt) * stride,
+                           state(mt) * stride,
+                           event(mt),
+                           [&tick, id] { return (tick + id) % 5 != 0; },
+                           [&log, id] { log.push_back(id); }});
+  }
+  return transitions;
+}
+
+void expectSameRun(std::size_t numTransitions, long numStates, long stride) {
+  for (const std::size_t numThreads : {1, 3, 8}) {
+    long             tick = 0;
+    std::vector<int> expected;
+    std::vector<int> actual;
+
+    auto reference = susml::vectorbased::StateMachine<Transition>{
+        0, makeRandomTransitions(numTransitions, numStates, stride, tick, expected)};
+    auto m = StateMachine<Transition>{
+        0, makeRandomTransitions(numTransitions, numStates, stride, tick, actual), numThreads};
+
+    std::mt19937                       mt{43};
+    std::uniform_int_distribution<int> event(0, 4); // 4 has no transitions
+    for (; tick < 1000; tick++) {
+      const auto e = event(mt);
+      reference.trigger(e);
+      m.trigger(e);
+      ASSERT_EQ(reference.currentState, m.currentState);
+    }
+    EXPECT_EQ(expected, actual);
+    EXPECT_EQ(reference.numUnhandledEvents, m.numUnhandledEvents);
+  }
+}
+
+TEST(IndexedTests, denseStatesBehaveLikeVectorBased) {
+  expectSameRun(200000, 5000, 1);
+  // more states than transitions per chunk, so the counting sort uses fewer chunks
+  expectSameRun(200000, 100000, 1);
+}
+
+TEST(IndexedTests, sparseStatesBehaveLikeVectorBased) {
+  expectSameRun(200000, 5000, 1000003);
+  expectSameRun(100, 20, 1000003);
+}
+
+TEST(IndexedTests, groupsTransitionsBySourceInOrder) {
+  using Plain = susml::Transition<int, int>;
+
+  auto m = StateMachine<Plain>{0, {{2, 0, 0}, {0, 1, 0}, {2, 1, 0}, {0, 2, 1}, {1, 2, 0}}};
+  ASSERT_EQ(5U, m.transitions.size());
+  EXPECT_EQ(1, m.transitions[0].target);
+  EXPECT_EQ(2, m.transitions[1].target);
+  EXPECT_EQ(2, m.transitions[2].target);
+  EXPECT_EQ(0, m.transitions[3].target);
+  EXPECT_EQ(1, m.transitions[4].target);
+  EXPECT_TRUE(m.sources.empty());
+  EXPECT_EQ((std::vector<std::size_t>{0, 2, 3, 5}), m.offsets);
+
+  m.trigger(1);
+  EXPECT_EQ(2, m.currentState);
+  m.trigger(0);
+  EXPECT_EQ(0, m.currentState);
+  m.trigger(3);
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+}
+
+TEST(IndexedTests, negativeTargetStatesHaveNoTransitions) {
+  using Plain = susml::Transition<int, int>;
+
+  auto m = StateMachine<Plain>{0, {{0, -1, 0}, {1, 0, 0}}};
+  m.trigger(0);
+  EXPECT_EQ(-1, m.currentState);
+  m.trigger(0);
+  EXPECT_EQ(-1, m.currentState);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+}
+
+TEST(IndexedTests, builder) {
+  using Plain = susml::Transition<int, int>;
+
+  Builder<Plain> builder;
+  builder.reserve(3);
+  builder.add({0, 1, 0});
+  const Plain back{1, 0, 0};
+  builder.add(back);
+  builder.add({5, 0, 0});
+  EXPECT_EQ(3U, builder.size());
+
+  auto m = builder.build(0, 2);
+  EXPECT_EQ(0U, builder.size());
+  EXPECT_EQ(3U, m.transitions.size());
+
+  m.trigger(0);
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(0);
+  EXPECT_EQ(0, m.currentState);
+
+  // states without transitions, beyond the largest source
+  m.currentState = 7;
+  m.trigger(0);
+  EXPECT_EQ(7, m.currentState);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
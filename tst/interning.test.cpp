@@ -0,0 +1,118 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "interning.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+using susml::interning::Interner;
+using susml::interning::NoId;
+
+TEST(InternerTests, perfectHashFindsAllValues) {
+  Interner<std::string> interner;
+  for (int i = 0; i < 5000; i++) {
+    EXPECT_EQ(i, interner.intern("message" + std::to_string(i)));
+  }
+  EXPECT_EQ(42, interner.intern("message42"));
+
+  ASSERT_TRUE(interner.freeze());
+  EXPECT_TRUE(interner.isPerfect());
+  for (int i = 0; i < 5000; i++) {
+    ASSERT_EQ(i, interner.find("message" + std::to_string(i)));
+    ASSERT_EQ("message" + std::to_string(i), interner.value(i));
+  }
+  EXPECT_EQ(NoId, interner.find("unknown"));
+  EXPECT_EQ(NoId, interner.find("message5000"));
+}
+
+TEST(InternerTests, fallsBackToMapOnHashCollisions) {
+  struct BadHash {
+    std::size_t operator()(const std::string &) const { return 0; }
+  };
+
+  Interner<std::string, BadHash> interner;
+  interner.intern("a");
+  interner.intern("b");
+
+  EXPECT_FALSE(interner.freeze());
+  EXPECT_FALSE(interner.isPerfect());
+  EXPECT_EQ(0, interner.find("a"));
+  EXPECT_EQ(1, interner.find("b"));
+  EXPECT_EQ(NoId, interner.find("c"));
+}
+
+namespace Protocol {
+struct Session {
+  std::string user;
+  int         level = 0;
+
+  bool operator==(const Session &other) const { return user == other.user && level == other.level; }
+};
+} // namespace Protocol
+
+template <>
+struct std::hash<Protocol::Session> {
+  std::size_t operator()(const Protocol::Session &s) const {
+    return std::hash<std::string>{}(s.user) ^ static_cast<std::size_t>(s.level);
+  }
+};
+
+TEST(InternedStateMachineTests, stringEventsAndStructStates) {
+  using namespace susml::factory;
+  using Protocol::Session;
+  using Action = std::function<void()>;
+
+  int  logins = 0;
+  auto Login  = Action([&] { logins++; });
+
+  const Session anonymous{"", 0};
+  const Session user{"alice", 1};
+  const Session admin{"alice", 2};
+
+  std::vector transitions = {
+      From(anonymous).To(user).On(std::string("LOGIN")).Do(Login).make(),
+      From(user).To(admin).On(std::string("SUDO")).Do(Action([] {})).make(),
+      From(admin).To(user).On(std::string("EXIT")).Do(Action([] {})).make(),
+      From(user).To(anonymous).On(std::string("LOGOUT")).Do(Action([] {})).make(),
+      From(admin).To(anonymous).On(std::string("LOGOUT")).Do(Action([] {})).make()};
+
+  auto m = susml::interning::StateMachine<decltype(transitions)::value_type>{anonymous, transitions};
+  EXPECT_EQ(3, m.states.size());
+  EXPECT_EQ(4, m.events.size());
+  EXPECT_TRUE(m.events.isPerfect());
+
+  m.trigger("SUDO");
+  EXPECT_EQ(anonymous, m.currentState());
+  m.trigger("LOGIN");
+  EXPECT_EQ(user, m.currentState());
+  m.trigger("NOOP");
+  EXPECT_EQ(user, m.currentState());
+
+  const auto sudo = m.eventId("SUDO");
+  m.triggerById(sudo);
+  EXPECT_EQ(admin, m.currentState());
+  m.trigger("LOGOUT");
+  EXPECT_EQ(anonymous, m.currentState());
+  EXPECT_EQ(1, logins);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef LEXER_UTIL_HPP
+#define LEXER_UTIL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "common.hpp"
+
+namespace util {
+
+// Action that counts how often it is taken. Actions that count into the same counter compare
+// equal, so event classification sees them as the same action.
+struct Count {
+  std::size_t *counter = nullptr;
+
+  void operator()() const {
+    if (counter != nullptr) { (*counter)++; }
+  }
+  bool operator==(const Count &other) const { return counter == other.counter; }
+};
+
+namespace lexer {
+enum class State { start, identifier, number };
+
+using Transition = susml::Transition<State, unsigned char, susml::NoneType, Count>;
+
+// counts identifiers and numbers in a byte stream, separated by spaces
+inline std::vector<Transition> makeTransitions(std::size_t &tokens) {
+  std::vector<Transition> transitions;
+  for (int c = 'a'; c <= 'z'; c++) {
+    transitions.push_back({State::start, State::identifier, (unsigned char)c, {}, {&tokens}});
+    transitions.push_back({State::identifier, State::identifier, (unsigned char)c});
+  }
+  for (int c = '0'; c <= '9'; c++) {
+    transitions.push_back({State::start, State::number, (unsigned char)c, {}, {&tokens}});
+    transitions.push_back({State::identifier, State::identifier, (unsigned char)c});
+    transitions.push_back({State::number, State::number, (unsigned char)c});
+  }
+  transitions.push_back({State::identifier, State::start, ' '});
+  transitions.push_back({State::number, State::start, ' '});
+  return transitions;
+}
+} // namespace lexer
+
+} // namespace util
+
+#endif
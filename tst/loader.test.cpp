@@ -0,0 +1,181 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "loader.hpp"
+
+#include <sstream>
+#include <string>
+
+using Loader = susml::loader::Loader<>;
+using susml::loader::Format;
+
+TEST(LoaderTests, loadsTable) {
+  std::istringstream in{"# lock\n"
+                        "initial locked\n"
+                        "unlocked locked  push\n"
+                        "locked   unlocked coin isPaid countCoin\n"
+                        "locked   locked   coin -      countCoin\n"
+                        "\n"};
+
+  bool isPaid   = false;
+  int  numCoins = 0;
+  auto loader   = Loader{};
+  loader.guards["isPaid"]     = [&] { return isPaid; };
+  loader.actions["countCoin"] = [&] { numCoins++; };
+  ASSERT_TRUE(loader.load(in, Format::table)) << loader.error;
+  EXPECT_EQ(2U, loader.states.size());
+  EXPECT_EQ(2U, loader.events.size());
+
+  const auto locked   = loader.stateId("locked");
+  const auto unlocked = loader.stateId("unlocked");
+  const auto coin     = loader.eventId("coin");
+  const auto push     = loader.eventId("push");
+
+  auto m = loader.build();
+  EXPECT_EQ(locked, m.currentState);
+  m.trigger(coin);
+  EXPECT_EQ(locked, m.currentState);
+  isPaid = true;
+  m.trigger(coin);
+  EXPECT_EQ(unlocked, m.currentState);
+  m.trigger(push);
+  EXPECT_EQ(locked, m.currentState);
+  EXPECT_EQ(2, numCoins);
+  EXPECT_EQ("locked", loader.states.value(m.currentState));
+}
+
+TEST(LoaderTests, loadsDot) {
+  std::istringstream in{"digraph door {\n"
+                        "  // the start node only marks the initial state\n"
+                        "  start [shape=point];\n"
+                        "  start -> closed;\n"
+                        "  closed -> open [label=\"open [isUnlocked] / ring\"];\n"
+                        "  open -> closed [label=close, color=red];\n"
+                        "  \"closed\" -> \"locked\" [label=\"lock / ring\"];\n"
+                        "  locked -> closed [label=\"unlock\"];\n"
+                        "}\n"};
+
+  int  numRings = 0;
+  auto loader   = Loader{};
+  loader.guards["isUnlocked"] = [] { return true; };
+  loader.actions["ring"]      = [&] { numRings++; };
+  ASSERT_TRUE(loader.load(in, Format::dot)) << loader.error;
+  EXPECT_EQ(3U, loader.states.size()); // start is not a state
+
+  auto m = loader.buildIndexed(1);
+  EXPECT_EQ(loader.stateId("closed"), m.currentState);
+  for (const auto *event : {"open", "close", "lock", "open", "unlock"}) {
+    m.trigger(loader.eventId(event));
+  }
+  EXPECT_EQ(loader.stateId("closed"), m.currentState);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+  EXPECT_EQ(2, numRings);
+}
+
+TEST(LoaderTests, parsesDotAttributesByName) {
+  std::istringstream in{"digraph {\n"
+                        "  start -> door-closed [xlabel=\"start\"];\n"
+                        "  door-closed->door-open [xlabel=\"not an event\" label=open];\n"
+                        "  door-open -> door-closed [color=red][label=\"close [isQuiet]\"];\n"
+                        "  start -> door-closed;\n"
+                        "}\n"};
+
+  auto loader              = Loader{};
+  loader.guards["isQuiet"] = [] { return true; };
+  ASSERT_TRUE(loader.load(in, Format::dot)) << loader.error;
+  EXPECT_EQ(2U, loader.states.size());
+  EXPECT_EQ(2U, loader.events.size());
+  EXPECT_EQ(susml::loader::NoId, loader.eventId("not an event"));
+  EXPECT_FALSE(loader.transitions[0].guard); // none named: left empty, and skipped
+  EXPECT_FALSE(loader.transitions[0].action);
+
+  auto m = loader.build();
+  EXPECT_EQ(loader.stateId("door-closed"), m.currentState);
+  EXPECT_EQ(2U, m.bySource.size()); // filled in while reading
+  m.trigger(loader.eventId("open"));
+  EXPECT_EQ(loader.stateId("door-open"), m.currentState);
+}
+
+TEST(LoaderTests, reportsErrorsWithTheirLine) {
+  {
+    std::istringstream in{"a b go\n"
+                          "b a stop missingGuard\n"};
+    auto               loader = Loader{};
+    EXPECT_FALSE(loader.load(in, Format::table));
+    EXPECT_EQ(2U, loader.errorLine);
+    EXPECT_EQ("unknown guard \"missingGuard\"", loader.error);
+  }
+  {
+    std::istringstream in{"a b\n"};
+    auto               loader = Loader{};
+    EXPECT_FALSE(loader.load(in, Format::table));
+    EXPECT_EQ(1U, loader.errorLine);
+  }
+  {
+    std::istringstream in{"digraph {\n"
+                          "  a -> b -> c [label=go];\n"
+                          "}\n"};
+    auto               loader = Loader{};
+    EXPECT_FALSE(loader.load(in, Format::dot));
+    EXPECT_EQ(2U, loader.errorLine);
+  }
+  {
+    std::istringstream in{"digraph {\n"
+                          "  a -> b [label=\"\"];\n"
+                          "}\n"};
+    auto               loader = Loader{};
+    EXPECT_FALSE(loader.load(in, Format::dot));
+    EXPECT_EQ(2U, loader.errorLine);
+  }
+  {
+    std::istringstream in{"digraph {\n"
+                          "  start -> a;\n"
+                          "  a -> b [label=go];\n"
+                          "  start -> b;\n"
+                          "}\n"};
+    auto               loader = Loader{};
+    EXPECT_FALSE(loader.load(in, Format::dot));
+    EXPECT_EQ(4U, loader.errorLine);
+    EXPECT_EQ("initial state \"a\" is already set", loader.error);
+  }
+  {
+    std::istringstream in{"a b go - ring\n"};
+    auto loader = susml::loader::Loader<susml::NoneType, susml::NoneType>{};
+    EXPECT_FALSE(loader.load(in, Format::table));
+    EXPECT_EQ("actions are not supported by this loader", loader.error);
+  }
+}
+
+TEST(LoaderTests, copiesLoadIndependently) {
+  std::istringstream first{"a b go\n"};
+  auto               original = Loader{};
+  ASSERT_TRUE(original.load(first, Format::table)) << original.error;
+
+  std::istringstream second{"b c go\n"
+                            "c a stop\n"};
+  auto               copy = original;
+  ASSERT_TRUE(copy.load(second, Format::table)) << copy.error;
+  EXPECT_EQ(3U, copy.states.size());
+  EXPECT_EQ(2U, copy.events.size());
+  EXPECT_EQ(3U, copy.transitions.size());
+  EXPECT_EQ(1U, copy.transitions[1].source); // ids in order of first mention
+  EXPECT_EQ(2U, copy.transitions[1].target);
+
+  EXPECT_EQ(2U, original.states.size());
+  EXPECT_EQ(1U, original.events.size());
+  EXPECT_EQ(1U, original.transitions.size());
+  EXPECT_EQ(susml::loader::NoId, original.stateId("c"));
+}
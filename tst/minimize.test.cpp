@@ -0,0 +1,189 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "minimize.hpp"
+#include "vectorbased.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+using susml::vectorbased::minimize;
+using susml::vectorbased::StateMachine;
+
+struct Add {
+  int *counter = nullptr;
+  int  amount  = 0;
+
+  void operator()() const { *counter += amount; }
+  bool operator==(const Add &other) const {
+    return counter == other.counter && amount == other.amount;
+  }
+};
+
+TEST(MinimizeTests, removesUnreachableStatesAndDeadTransitions) {
+  using Transition = susml::Transition<int, char>;
+
+  auto m = StateMachine<Transition>{0,
+                                    {{0, 1, 'a'},
+                                     {1, 0, 'a'},
+                                     {0, 2, 'a'}, // shadowed by the first transition
+                                     {2, 3, 'b'},
+                                     {3, 2, 'b'}}};
+
+  const auto minimized = minimize(m);
+
+  // without actions and labels, no state can be told apart from any other
+  EXPECT_EQ(0, minimized.machine.transitions.size());
+  EXPECT_EQ(2, minimized.stateMap.size());
+  EXPECT_EQ(0, minimized.stateMap.at(1));
+  EXPECT_EQ(0, minimized.stateMap.count(2));
+}
+
+TEST(MinimizeTests, labelsKeepStatesApart) {
+  using Transition = susml::Transition<int, char>;
+
+  // a ring of 6 states, of which every third is accepting: equivalent to a ring of 3
+  std::vector<Transition> transitions;
+  for (int i = 0; i < 6; i++) {
+    transitions.push_back({i, (i + 1) % 6, 'a'});
+  }
+  auto m = StateMachine<Transition>{0, transitions};
+
+  const auto minimized = minimize(m, [](int s) { return std::size_t(s % 3 == 0); });
+
+  EXPECT_EQ(3, minimized.machine.transitions.size());
+  EXPECT_EQ(0, minimized.stateMap.at(3));
+  EXPECT_EQ(1, minimized.stateMap.at(4));
+  EXPECT_EQ(2, minimized.stateMap.at(5));
+}
+
+TEST(MinimizeTests, comparableActionsAreMerged) {
+  using Transition = susml::Transition<int, char, susml::NoneType, Add>;
+
+  int counter = 0;
+
+  // 0 -a/+1-> 1 -a/+2-> 2 -a/+1-> 3 -a/+2-> 0, with 'b' resetting to 0 from any state
+  std::vector<Transition> transitions;
+  for (int i = 0; i < 4; i++) {
+    transitions.push_back({i, (i + 1) % 4, 'a', {}, Add{&counter, 1 + i % 2}});
+    transitions.push_back({i, 0, 'b', {}, Add{&counter, 0}});
+  }
+  auto m = StateMachine<Transition>{0, transitions};
+
+  auto minimized = minimize(m);
+  EXPECT_EQ(4, minimized.machine.transitions.size());
+  EXPECT_EQ(0, minimized.stateMap.at(2));
+  EXPECT_EQ(1, minimized.stateMap.at(3));
+
+  int  counterMinimized = 0;
+  auto original         = m;
+  for (auto &t : minimized.machine.transitions) {
+    t.action.counter = &counterMinimized;
+  }
+
+  std::mt19937 mt{42};
+  for (int i = 0; i < 1000; i++) {
+    const char e = (mt() % 4 == 0) ? 'b' : 'a';
+    original.trigger(e);
+    minimized.machine.trigger(e);
+    ASSERT_EQ(minimized.stateMap.at(original.currentState), minimized.machine.currentState);
+  }
+  EXPECT_EQ(counter, counterMinimized);
+}
+
+TEST(MinimizeTests, incomparableActionsAreKeptApart) {
+  using namespace susml::factory;
+
+  int  counter = 0;
+  auto Inc     = [&] { return std::function<void()>([&] { counter++; }); };
+
+  std::vector transitions = {From(0).To(1).On('a').Do(Inc()).make(),
+                             From(1).To(0).On('a').Do(Inc()).make()};
+  auto        m           = StateMachine<decltype(transitions)::value_type>{0, transitions};
+
+  const auto minimized = minimize(m);
+  EXPECT_EQ(2, minimized.machine.transitions.size());
+  EXPECT_EQ(1, minimized.stateMap.at(1));
+}
+
+TEST(MinimizeTests, blocksSplitOffAsNonSplittersCanBeSplitAgain) {
+  using Transition = susml::Transition<int, int>;
+
+  // the first split keeps the smaller half as splitter, and the block split off is split again
+  auto m = StateMachine<Transition>{0,
+                                    {{0, 1, 0},
+                                     {0, 3, 1},
+                                     {1, 3, 0},
+                                     {1, 1, 1},
+                                     {2, 0, 0},
+                                     {2, 2, 1},
+                                     {3, 4, 0},
+                                     {3, 4, 1},
+                                     {4, 4, 0},
+                                     {4, 2, 1}}};
+  auto label     = [](int s) { return std::size_t(s == 0); };
+  auto minimized = minimize(m, label);
+
+  std::mt19937 mt{5};
+  for (int i = 0; i < 200; i++) {
+    const int e = static_cast<int>(mt() % 2);
+    m.trigger(e);
+    minimized.machine.trigger(e);
+    ASSERT_EQ(minimized.stateMap.at(m.currentState), minimized.machine.currentState);
+    ASSERT_EQ(label(m.currentState), label(minimized.machine.currentState));
+  }
+}
+
+TEST(MinimizeTests, randomMachinesBehaveTheSame) {
+  using Transition = susml::Transition<int, int, susml::NoneType, Add>;
+
+  std::mt19937 mt{1234};
+  for (int round = 0; round < 20; round++) {
+    constexpr int numStates = 40;
+    constexpr int numEvents = 3;
+
+    int                     counter = 0;
+    std::vector<Transition> transitions;
+    for (int i = 0; i < 3 * numStates; i++) {
+      const int source = mt() % numStates;
+      const int target = mt() % numStates;
+      const int event  = mt() % numEvents;
+      transitions.push_back({source, target, event, {}, Add{&counter, int(mt() % 2)}});
+    }
+    auto m         = StateMachine<Transition>{0, transitions};
+    auto minimized = minimize(m);
+    EXPECT_LE(minimized.machine.transitions.size(), transitions.size());
+
+    int counterMinimized = 0;
+    for (auto &t : minimized.machine.transitions) {
+      t.action.counter = &counterMinimized;
+    }
+    for (int i = 0; i < 2000; i++) {
+      const int e = mt() % numEvents;
+      m.trigger(e);
+      minimized.machine.trigger(e);
+      ASSERT_EQ(minimized.stateMap.at(m.currentState), minimized.machine.currentState);
+    }
+    EXPECT_EQ(counter, counterMinimized);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
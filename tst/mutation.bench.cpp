@@ -0,0 +1,98 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// A 64-state circle with 16 features, each a shortcut transition that is toggled on and off at
+// runtime, with a number of triggers (the argument) between toggles. Toggling with
+// addTransition/removeTransition is compared with rebuilding the machine from a vector that is
+// kept next to it.
+
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <vector>
+
+#include "common.hpp"
+#include "vectorbased.hpp"
+
+using Transition   = susml::Transition<int, int, susml::NoneType, std::function<void()>>;
+using StateMachine = susml::vectorbased::StateMachine<Transition>;
+
+constexpr int numStates   = 64;
+constexpr int numFeatures = 16;
+
+std::vector<Transition> makeCircle(int &counter) {
+  std::vector<Transition> transitions;
+  for (int s = 0; s < numStates; s++) {
+    transitions.push_back({s, (s + 1) % numStates, 0, {}, [&counter] { counter++; }});
+  }
+  return transitions;
+}
+
+Transition makeFeature(int f, int &counter) {
+  const int source = f * (numStates / numFeatures);
+  return {source, (source + 7) % numStates, 1, {}, [&counter] { counter += 7; }};
+}
+
+static void toggleInPlace(benchmark::State &s) {
+  int  counter = 0;
+  auto m       = StateMachine{0, makeCircle(counter)};
+
+  std::vector<StateMachine::TransitionId> ids(numFeatures);
+  std::vector<bool>                       isOn(numFeatures, false);
+
+  int f = 0;
+  for (auto _ : s) {
+    if (isOn[f]) {
+      m.removeTransition(ids[f]);
+    } else {
+      ids[f] = m.addTransition(makeFeature(f, counter));
+    }
+    isOn[f] = !isOn[f];
+    f       = (f + 1) % numFeatures;
+
+    for (int i = 0; i < s.range(0); i++) {
+      m.trigger(i % 2);
+    }
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetItemsProcessed(s.iterations() * s.range(0));
+}
+
+static void toggleByRebuilding(benchmark::State &s) {
+  int  counter = 0;
+  auto m       = StateMachine{0, makeCircle(counter)};
+
+  std::vector<bool> isOn(numFeatures, false);
+
+  int f = 0;
+  for (auto _ : s) {
+    isOn[f] = !isOn[f];
+    f       = (f + 1) % numFeatures;
+
+    auto next = makeCircle(counter);
+    for (int g = 0; g < numFeatures; g++) {
+      if (isOn[g]) { next.push_back(makeFeature(g, counter)); }
+    }
+    m = StateMachine{m.currentState, std::move(next)};
+
+    for (int i = 0; i < s.range(0); i++) {
+      m.trigger(i % 2);
+    }
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetItemsProcessed(s.iterations() * s.range(0));
+}
+
+BENCHMARK(toggleInPlace)->RangeMultiplier(16)->Range(1, 4096);
+BENCHMARK(toggleByRebuilding)->RangeMultiplier(16)->Range(1, 4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,161 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "nfa.hpp"
+
+#include <functional>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using susml::nfa::Unmatched;
+
+TEST(NfaTests, detectsOverlappingPatterns) {
+  using Transition = susml::Transition<int, char>;
+
+  // 0 loops on anything and starts a match of "aab" on 'a', 3 is the accepting state
+  const std::vector<Transition> transitions = {
+      {0, 0, 'a'}, {0, 0, 'b'}, {0, 1, 'a'}, {1, 2, 'a'}, {2, 3, 'b'}};
+
+  auto m = susml::nfa::StateMachine<Transition>{0, transitions};
+
+  std::vector<int> matches;
+  const std::string input = "aaabaabab";
+  for (std::size_t i = 0; i < input.size(); i++) {
+    m.trigger(input[i]);
+    if (m.isActive(3)) { matches.push_back(static_cast<int>(i)); }
+  }
+  EXPECT_EQ((std::vector<int>{3, 6}), matches);
+
+  m.trigger('a');
+  EXPECT_EQ((std::vector<int>{0, 1}), m.currentStates());
+  m.trigger('x'); // no transition from any state
+  EXPECT_TRUE(m.currentStates().empty());
+}
+
+TEST(NfaTests, behavesLikeSetSimulation) {
+  using Transition = susml::Transition<int, int>;
+
+  constexpr int numStates = 150;
+  constexpr int numEvents = 5;
+
+  std::mt19937                       mt{42};
+  std::uniform_int_distribution<int> state(0, numStates - 1);
+  std::uniform_int_distribution<int> event(0, numEvents - 1);
+
+  std::vector<Transition> transitions;
+  for (int i = 0; i < 600; i++) {
+    transitions.push_back({state(mt), state(mt), event(mt)});
+  }
+
+  for (const auto unmatched : {Unmatched::drop, Unmatched::stay}) {
+    auto          m = susml::nfa::StateMachine<Transition>{{0, 1, 2}, transitions, unmatched};
+    std::set<int> expected{0, 1, 2};
+
+    for (int i = 0; i < 200; i++) {
+      const int     e = event(mt);
+      std::set<int> next;
+      for (const auto s : expected) {
+        bool isHandled = false;
+        for (const auto &t : transitions) {
+          if (t.source == s && t.event == e) {
+            next.insert(t.target);
+            isHandled = true;
+          }
+        }
+        if (!isHandled && unmatched == Unmatched::stay) { next.insert(s); }
+      }
+      expected = next;
+
+      m.trigger(e);
+      const auto actual = m.currentStates();
+      ASSERT_EQ(expected, std::set<int>(actual.begin(), actual.end()));
+      ASSERT_EQ(expected.size(), m.active.count());
+    }
+  }
+}
+
+TEST(NfaTests, guardsAndActionsArePerTransition) {
+  using namespace susml::factory;
+  using Guard  = std::function<bool()>;
+  using Action = std::function<void()>;
+
+  bool isAllowed = false;
+  int  numA      = 0;
+  int  numB      = 0;
+
+  auto Allowed = Guard([&] { return isAllowed; });
+  auto Always  = Guard([] { return true; });
+  auto CountA  = Action([&] { numA++; });
+  auto CountB  = Action([&] { numB++; });
+
+  std::vector transitions = {From(0).To(1).On('x').If(Always).Do(CountA).make(),
+                             From(0).To(2).On('x').If(Allowed).Do(CountB).make(),
+                             From(1).To(0).On('y').If(Always).Do(CountA).make()};
+
+  auto m = susml::nfa::StateMachine<decltype(transitions)::value_type>{0, transitions,
+                                                                       Unmatched::stay};
+
+  m.trigger('x');
+  EXPECT_EQ((std::vector<int>{1}), m.currentStates());
+  EXPECT_EQ((std::vector<std::uint32_t>{0}), m.fired);
+  EXPECT_EQ(1, numA);
+  EXPECT_EQ(0, numB);
+
+  m.trigger('y');
+  isAllowed = true;
+  m.trigger('x');
+  EXPECT_EQ((std::vector<int>{1, 2}), m.currentStates());
+  EXPECT_EQ((std::vector<std::uint32_t>{0, 1}), m.fired);
+  EXPECT_EQ(3, numA);
+  EXPECT_EQ(1, numB);
+
+  m.trigger('y'); // 1 goes to 0, 2 has no transition and stays
+  EXPECT_EQ((std::vector<int>{0, 2}), m.currentStates());
+  EXPECT_EQ((std::vector<std::uint32_t>{2}), m.fired);
+}
+
+TEST(NfaTests, nullGuardsAndActionsKeepTransitionsPlain) {
+  using Transition = susml::Transition<int, char, bool (*)(), std::function<void()>>;
+
+  int  numEntered = 0;
+  auto Count      = std::function<void()>([&] { numEntered++; });
+  auto Never      = +[] { return false; };
+
+  // a pattern of "ab" from 0, where only entering 2 and a guard that never holds need evaluation
+  auto m = susml::nfa::StateMachine<Transition>{0,
+                                                {{0, 0, 'a'},
+                                                 {0, 0, 'b'},
+                                                 {0, 1, 'a'},
+                                                 {1, 2, 'b', nullptr, Count},
+                                                 {1, 3, 'b', Never}}};
+  EXPECT_TRUE(m.special[m.eventIds.at('a')].empty());
+  EXPECT_EQ(2U, m.special[m.eventIds.at('b')].size());
+
+  for (const char c : std::string("abaab")) {
+    m.trigger(c);
+  }
+  EXPECT_EQ((std::vector<int>{0, 2}), m.currentStates());
+  EXPECT_EQ((std::vector<std::uint32_t>{3}), m.fired);
+  EXPECT_EQ(2, numEntered);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "packed.hpp"
+#include "vectorbased.hpp"
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using susml::packed::PackedArray;
+
+TEST(PackedArrayTests, roundTrip) {
+  for (unsigned width = 1; width <= 32; width++) {
+    PackedArray a(200, width);
+    const auto  mask = static_cast<std::uint32_t>((std::uint64_t{1} << width) - 1);
+    for (std::size_t i = 0; i < a.size; i++) {
+      a.set(i, static_cast<std::uint32_t>(i * 2654435761U) & mask);
+    }
+    for (std::size_t i = 0; i < a.size; i++) {
+      ASSERT_EQ(static_cast<std::uint32_t>(i * 2654435761U) & mask, a.get(i)) << width;
+    }
+  }
+}
+
+TEST(PackedArrayTests, bitsFor) {
+  EXPECT_EQ(1, PackedArray::bitsFor(0));
+  EXPECT_EQ(1, PackedArray::bitsFor(2));
+  EXPECT_EQ(2, PackedArray::bitsFor(3));
+  EXPECT_EQ(8, PackedArray::bitsFor(256));
+  EXPECT_EQ(9, PackedArray::bitsFor(257));
+}
+
+TEST(PackedStateMachineTests, narrowKeysForWideStates) {
+  using Transition = susml::Transition<std::size_t, bool>;
+
+  // the circle benchmark topology, with 16 byte keys in the vector-based machine
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < 100; i++) {
+    transitions.push_back({i * 1000, ((i + 1) % 100) * 1000, true});
+  }
+  auto m = susml::packed::StateMachine<Transition>{0, transitions};
+
+  EXPECT_EQ(1, m.events.width);
+  EXPECT_EQ(7, m.targets.width);
+  EXPECT_TRUE(m.eventIds.isDense());
+
+  for (std::size_t i = 0; i < 250; i++) {
+    m.trigger(true);
+  }
+  EXPECT_EQ(50000, m.currentState);
+  m.trigger(false);
+  EXPECT_EQ(50000, m.currentState);
+}
+
+TEST(PackedStateMachineTests, behavesLikeVectorBased) {
+  using Guard      = std::function<bool()>;
+  using Action     = std::function<void()>;
+  using Transition = susml::Transition<std::string, std::string, Guard, Action>;
+
+  std::mt19937 mt{7};
+  int          counter = 0;
+
+  const std::vector<std::string> names = {"a", "b", "c", "d", "e"};
+  std::vector<Transition>        transitions;
+  for (int i = 0; i < 40; i++) {
+    const int amount = i;
+    transitions.push_back({names[mt() % names.size()],
+                           names[mt() % names.size()],
+                           names[mt() % 3],
+                           [&counter] { return (counter & 1) == 0; },
+                           [&counter, amount] { counter += amount; }});
+  }
+
+  auto packed = susml::packed::StateMachine<Transition>{"a", transitions};
+  auto vector = susml::vectorbased::StateMachine<Transition>{"a", transitions};
+  EXPECT_FALSE(packed.eventIds.isDense());
+
+  for (int i = 0; i < 1000; i++) {
+    const auto e      = names[mt() % 4];
+    const int  before = counter;
+    vector.trigger(e);
+    const int expected = counter;
+    counter            = before;
+    packed.trigger(e);
+    ASSERT_EQ(expected, counter);
+    ASSERT_EQ(vector.currentState, packed.currentState);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,84 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// One long stream of events through a small guardless machine, sequentially and split over
+// threads. The parallel variant only scales when there are cores to spare.
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "alphabet.hpp"
+#include "common.hpp"
+#include "parallel.hpp"
+
+using Transition   = susml::Transition<int, int>;
+using StateMachine = susml::alphabet::StateMachine<Transition>;
+
+constexpr int numStates = 32;
+constexpr int numEvents = 8;
+
+std::vector<Transition> makeTransitions() {
+  std::mt19937 mt{42};
+
+  std::vector<Transition> transitions;
+  for (int s = 0; s < numStates; s++) {
+    for (int e = 0; e < numEvents; e++) {
+      transitions.push_back({s, static_cast<int>(mt() % numStates), e});
+    }
+  }
+  return transitions;
+}
+
+const std::vector<int> &getEvents() {
+  static const std::vector<int> events = [] {
+    std::mt19937     mt{43};
+    std::vector<int> e(1 << 24);
+    for (auto &event : e) {
+      event = static_cast<int>(mt() % numEvents);
+    }
+    return e;
+  }();
+  return events;
+}
+
+static void streamSequential(benchmark::State &s) {
+  auto        m      = StateMachine{0, makeTransitions()};
+  const auto &events = getEvents();
+  for (auto _ : s) {
+    for (const auto e : events) {
+      m.trigger(e);
+    }
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetItemsProcessed(s.iterations() * events.size());
+}
+
+static void streamParallel(benchmark::State &s) {
+  auto        m      = StateMachine{0, makeTransitions()};
+  const auto &events = getEvents();
+  for (auto _ : s) {
+    susml::parallel::run(m, events.begin(), events.end(), s.range(0));
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetItemsProcessed(s.iterations() * events.size());
+}
+
+BENCHMARK(streamSequential)->Unit(benchmark::kMillisecond);
+BENCHMARK(streamParallel)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,106 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "parallel.hpp"
+#include "vectorbased.hpp"
+
+#include <atomic>
+#include <random>
+#include <vector>
+
+struct AtomicCount {
+  std::atomic<int> *counter = nullptr;
+
+  void operator()() const {
+    if (counter != nullptr) { (*counter)++; }
+  }
+};
+
+using Transition = susml::Transition<int, int, susml::NoneType, AtomicCount>;
+
+std::vector<Transition> makeRandomTransitions(std::atomic<int> &counter, int numStates) {
+  std::mt19937                       mt{42};
+  std::uniform_int_distribution<int> state(0, numStates - 1);
+  std::uniform_int_distribution<int> event(0, 3);
+
+  std::vector<Transition> transitions;
+  for (int i = 0; i < 4 * numStates; i++) {
+    auto *counted = (i % 3 == 0) ? &counter : nullptr;
+    transitions.push_back({state(mt), state(mt), event(mt), {}, {counted}});
+  }
+  return transitions;
+}
+
+std::vector<int> makeEvents(std::size_t size) {
+  std::mt19937                       mt{43};
+  std::uniform_int_distribution<int> event(0, 4); // 4 has no transitions
+
+  std::vector<int> events(size);
+  for (auto &e : events) {
+    e = event(mt);
+  }
+  return events;
+}
+
+TEST(TableTests, mapMatchesRunFromEveryState) {
+  std::atomic<int> counter{0};
+  const auto       transitions = makeRandomTransitions(counter, 50);
+  const auto       table       = susml::parallel::Table<Transition>{0, transitions};
+  const auto       events      = makeEvents(1000);
+
+  const auto mapping = table.map(events.begin(), events.end());
+  ASSERT_EQ(table.states.size(), mapping.size());
+  for (std::uint32_t s = 0; s < mapping.size(); s++) {
+    EXPECT_EQ(table.run(s, events.begin(), events.end(), [](std::uint32_t) {}), mapping[s]);
+  }
+}
+
+TEST(ParallelTests, behavesLikeSequentialRun) {
+  for (const std::size_t numThreads : {1, 2, 3, 8}) {
+    std::atomic<int> counterSequential{0};
+    std::atomic<int> counterParallel{0};
+
+    auto reference = susml::vectorbased::StateMachine<Transition>{
+        0, makeRandomTransitions(counterSequential, 40)};
+    auto m = susml::vectorbased::StateMachine<Transition>{
+        0, makeRandomTransitions(counterParallel, 40)};
+
+    const auto events = makeEvents(50000);
+    for (const auto e : events) {
+      reference.trigger(e);
+    }
+    susml::parallel::run(m, events.begin(), events.end(), numThreads);
+
+    EXPECT_EQ(reference.currentState, m.currentState);
+    EXPECT_EQ(counterSequential.load(), counterParallel.load());
+    EXPECT_NE(0, counterParallel.load());
+  }
+}
+
+TEST(ParallelTests, shortStreamsRunSequentially) {
+  std::atomic<int> counter{0};
+  auto m = susml::vectorbased::StateMachine<Transition>{0, {{0, 1, 0, {}, {&counter}}, {1, 0, 1}}};
+
+  const std::vector<int> events = {0, 1, 0};
+  susml::parallel::run(m, events.begin(), events.end(), 4);
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(2, counter.load());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "guards.hpp"
+#include "reactive.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+using susml::guards::Guard;
+using susml::guards::var;
+using susml::reactive::Changes;
+using susml::reactive::Input;
+using susml::reactive::var;
+
+namespace Encoder {
+enum class State { idle, cw1, cw2, cw3, ccw1, ccw2, ccw3 };
+enum class Event { update };
+
+using Action     = std::function<void()>;
+using Transition = susml::Transition<State, Event, Guard, Action>;
+
+template <typename A, typename B>
+std::vector<Transition> makeTransitions(const A &a, const B &b, int &delta) {
+  using namespace susml::factory;
+
+  const Guard is00    = !var(a) && !var(b);
+  const Guard is01    = !var(a) && var(b);
+  const Guard is10    = var(a) && !var(b);
+  const Guard is11    = var(a) && var(b);
+  const auto  Nothing = Action([] {});
+  const auto  Up      = Action([&] { delta++; });
+  const auto  Down    = Action([&] { delta--; });
+
+  return {From(State::idle).To(State::cw1).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::cw1).To(State::idle).On(Event::update).If(is00).Do(Nothing).make(),
+          From(State::cw1).To(State::cw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::cw2).To(State::cw1).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::cw2).To(State::cw3).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::cw3).To(State::cw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::cw3).To(State::idle).On(Event::update).If(is00).Do(Up).make(),
+          From(State::idle).To(State::ccw1).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::ccw1).To(State::idle).On(Event::update).If(is00).Do(Nothing).make(),
+          From(State::ccw1).To(State::ccw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::ccw2).To(State::ccw1).On(Event::update).If(is10).Do(Nothing).make(),
+          From(State::ccw2).To(State::ccw3).On(Event::update).If(is01).Do(Nothing).make(),
+          From(State::ccw3).To(State::ccw2).On(Event::update).If(is11).Do(Nothing).make(),
+          From(State::ccw3).To(State::idle).On(Event::update).If(is00).Do(Down).make()};
+}
+} // namespace Encoder
+
+TEST(InputTests, onlyChangedValuesSetTheirBit) {
+  Changes     changes;
+  Input<bool> a(changes, false);
+  Input<int>  n(changes, 3);
+
+  changes.bits = Changes::Untracked;
+  a            = false;
+  n            = 3;
+  EXPECT_EQ(Changes::Untracked, changes.bits);
+
+  n = 4;
+  EXPECT_EQ(Changes::Untracked | 2U, changes.bits);
+  a.set(true);
+  EXPECT_EQ(Changes::Untracked | 3U, changes.bits);
+  EXPECT_TRUE(a.get());
+  EXPECT_EQ(4, n.get());
+
+  EXPECT_EQ(1U, changes.bitOf(&a.value));
+  EXPECT_EQ(Changes::Untracked, changes.bitOf(&changes));
+}
+
+TEST(ReactiveStateMachineTests, behavesLikePolling) {
+  Changes     changes;
+  Input<bool> a(changes, false);
+  Input<bool> b(changes, false);
+  Input<bool> unrelated(changes, false);
+  bool        plainA         = false;
+  bool        plainB         = false;
+  int         deltaReactive  = 0;
+  int         deltaReference = 0;
+
+  auto m = susml::reactive::StateMachine<Encoder::Transition>{
+      Encoder::State::idle,
+      Encoder::makeTransitions(a, b, deltaReactive),
+      changes,
+      Encoder::Event::update};
+  auto reference = susml::guards::StateMachine<Encoder::Transition>{
+      Encoder::State::idle, Encoder::makeTransitions(plainA, plainB, deltaReference)};
+
+  std::mt19937 mt{42};
+  for (int i = 0; i < 10000; i++) {
+    switch (mt() % 4) { // sometimes toggle a or b, sometimes only something else
+    case 0: plainA = !plainA; break;
+    case 1: plainB = !plainB; break;
+    case 2: unrelated = !unrelated.get(); break;
+    default: break;
+    }
+    a = plainA;
+    b = plainB;
+
+    m.update();
+    reference.trigger(Encoder::Event::update);
+    ASSERT_EQ(reference.currentState, m.currentState());
+  }
+  EXPECT_EQ(deltaReference, deltaReactive);
+  EXPECT_NE(0, deltaReactive);
+  EXPECT_GT(m.numSkippedUpdates, 2000U); // about half the updates change neither a nor b
+}
+
+TEST(ReactiveStateMachineTests, reevaluatesAfterTransitions) {
+  using Transition = susml::Transition<int, int, Guard>;
+
+  Changes    changes;
+  Input<int> n(changes, 0);
+
+  // both transitions hold for n == 0, and the second must be taken right after the first
+  const std::vector<Transition> transitions = {{0, 1, 0, var(n) < 1}, {1, 2, 0, var(n) < 1}};
+  auto m = susml::reactive::StateMachine<Transition>{0, transitions, changes, 0};
+
+  m.update();
+  EXPECT_EQ(1, m.currentState());
+  m.update();
+  EXPECT_EQ(2, m.currentState());
+  m.update(); // no transitions from 2, so nothing to evaluate
+  n = 5;
+  m.update();
+  EXPECT_EQ(2, m.currentState());
+  EXPECT_EQ(2U, m.numSkippedUpdates);
+}
+
+TEST(ReactiveStateMachineTests, untrackedVariablesAreAlwaysEvaluated) {
+  using Transition = susml::Transition<int, int, Guard>;
+
+  Changes    changes;
+  Input<int> n(changes, 0);
+  int        plain = 0;
+
+  const std::vector<Transition> transitions = {
+      {0, 1, 0, var(n) == 1 || var(plain) == 1}};
+  auto m = susml::reactive::StateMachine<Transition>{0, transitions, changes, 0};
+
+  m.update();
+  m.update();
+  EXPECT_EQ(0, m.currentState());
+  plain = 1; // not observable, so the machine must not skip
+  m.update();
+  EXPECT_EQ(1, m.currentState());
+  EXPECT_EQ(0U, m.numSkippedUpdates);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
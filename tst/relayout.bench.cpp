@@ -0,0 +1,95 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+// Large random graph with scattered state ids, before and after renumbering. To see the cache
+// misses rather than just the time, run with --benchmark_perf_counters=CACHE-MISSES (requires
+// google benchmark to be built with libpfm).
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "alphabet.hpp"
+#include "common.hpp"
+#include "relayout.hpp"
+
+using Transition   = susml::Transition<std::size_t, int>;
+using StateMachine = susml::alphabet::StateMachine<Transition>;
+
+constexpr std::size_t numStates = 1 << 18;
+
+// A ring through all states in random order (event 0), plus a random jump from each state (event
+// 1). Transitions are listed by source id, as they would be when generated from a state table.
+std::vector<Transition> makeTransitions() {
+  std::mt19937 mt{42};
+
+  std::vector<std::size_t> ids(numStates);
+  for (std::size_t i = 0; i < numStates; i++) {
+    ids[i] = i;
+  }
+  std::shuffle(ids.begin(), ids.end(), mt);
+
+  std::vector<Transition> transitions(2 * numStates, {0, 0, 0});
+  for (std::size_t i = 0; i < numStates; i++) {
+    transitions[2 * ids[i]]     = {ids[i], ids[(i + 1) % numStates], 0};
+    transitions[2 * ids[i] + 1] = {ids[i], ids[mt() % numStates], 1};
+  }
+  return transitions;
+}
+
+// mostly follows the ring, occasionally jumps
+const std::vector<int> &getEvents() {
+  static const std::vector<int> events = [] {
+    std::mt19937    mt{43};
+    std::vector<int> e(1 << 20);
+    for (auto &event : e) {
+      event = (mt() % 64 == 0) ? 1 : 0;
+    }
+    return e;
+  }();
+  return events;
+}
+
+static void runEvents(benchmark::State &s, StateMachine &m) {
+  const auto &events = getEvents();
+  for (auto _ : s) {
+    for (const auto e : events) {
+      m.trigger(e);
+    }
+    benchmark::DoNotOptimize(m.currentState);
+  }
+  s.SetItemsProcessed(s.iterations() * events.size());
+}
+
+static void randomGraphOriginal(benchmark::State &s) {
+  auto m = StateMachine{0, makeTransitions()};
+  runEvents(s, m);
+}
+
+template <susml::relayout::Order Order>
+static void randomGraphRenumbered(benchmark::State &s) {
+  const auto transitions = makeTransitions();
+  const auto counts      = susml::relayout::countTransitions(transitions, 0, getEvents());
+  auto       r = susml::relayout::renumber(StateMachine{0, transitions}, Order, counts);
+  runEvents(s, r.machine);
+}
+
+using susml::relayout::Order;
+
+BENCHMARK(randomGraphOriginal)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(randomGraphRenumbered, Order::breadthFirst)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(randomGraphRenumbered, Order::reverseCuthillMcKee)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(randomGraphRenumbered, Order::profile)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,113 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "alphabet.hpp"
+#include "common.hpp"
+#include "relayout.hpp"
+#include "vectorbased.hpp"
+
+#include <random>
+#include <vector>
+
+using susml::relayout::Order;
+using susml::relayout::renumber;
+using Transition = susml::Transition<std::size_t, int>;
+
+// a ring of scattered state ids, with a random shortcut from every state
+std::vector<Transition> makeScatteredRing(std::size_t numStates, std::mt19937 &mt) {
+  std::vector<std::size_t> ids(numStates);
+  for (std::size_t i = 0; i < numStates; i++) {
+    ids[i] = i;
+  }
+  std::shuffle(ids.begin(), ids.end(), mt);
+
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < numStates; i++) {
+    transitions.push_back({ids[i], ids[(i + 1) % numStates], 0});
+    transitions.push_back({ids[i], ids[mt() % numStates], 1});
+  }
+  return transitions;
+}
+
+template <typename StateMachine>
+void expectSameBehavior(StateMachine                                   original,
+                        const susml::relayout::Relayout<StateMachine> &relayout,
+                        std::mt19937 &                                 mt) {
+  auto m = relayout.machine;
+  for (int i = 0; i < 1000; i++) {
+    const int e = (mt() % 8 == 0) ? 1 : 0;
+    original.trigger(e);
+    m.trigger(e);
+    ASSERT_EQ(original.currentState, relayout.toOriginal[m.currentState]);
+    ASSERT_EQ(m.currentState, relayout.fromOriginal.at(original.currentState));
+  }
+}
+
+TEST(RenumberTests, breadthFirst) {
+  std::mt19937 mt{1};
+
+  auto m = susml::vectorbased::StateMachine<Transition>{7, makeScatteredRing(16, mt)};
+  auto r = renumber(m, Order::breadthFirst);
+
+  EXPECT_EQ(0, r.machine.currentState);
+  EXPECT_EQ(7, r.toOriginal[0]);
+  EXPECT_EQ(16, r.toOriginal.size());
+  for (std::size_t i = 1; i < r.machine.transitions.size(); i++) {
+    EXPECT_LE(r.machine.transitions[i - 1].source, r.machine.transitions[i].source);
+  }
+  expectSameBehavior(m, r, mt);
+}
+
+TEST(RenumberTests, reverseCuthillMcKee) {
+  std::mt19937 mt{2};
+
+  // a plain ring has bandwidth 1 (or 2 for the closing transitions) when laid out well
+  std::vector<Transition> ring;
+  for (std::size_t i = 0; i < 32; i++) {
+    ring.push_back({(i * 7) % 32, ((i + 1) * 7) % 32, 0});
+  }
+  auto m = susml::alphabet::StateMachine<Transition>{0, ring};
+  auto r = renumber(m, Order::reverseCuthillMcKee);
+
+  std::size_t farJumps = 0;
+  for (const auto &t : r.machine.transitions) {
+    const auto distance = (t.source > t.target) ? t.source - t.target : t.target - t.source;
+    farJumps += (distance > 2) ? 1 : 0;
+  }
+  EXPECT_LE(farJumps, 1);
+  expectSameBehavior(m, r, mt);
+}
+
+TEST(RenumberTests, profileFollowsHotPath) {
+  std::mt19937 mt{3};
+
+  const auto transitions = makeScatteredRing(64, mt);
+  auto       m = susml::alphabet::StateMachine<Transition>{transitions[0].source, transitions};
+
+  // only ever follow the ring
+  const std::vector<int> events(1000, 0);
+  const auto counts = susml::relayout::countTransitions(transitions, m.currentState, events);
+  auto       r      = renumber(m, Order::profile, counts);
+
+  for (const auto &t : r.machine.transitions) {
+    if (t.event == 0 && t.target != 0) { EXPECT_EQ(t.source + 1, t.target); }
+  }
+  expectSameBehavior(m, r, mt);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
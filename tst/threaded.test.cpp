@@ -0,0 +1,153 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "threaded.hpp"
+#include "vectorbased.hpp"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+using susml::threaded::StateMachine;
+
+using Transition = susml::Transition<long, int, std::function<bool()>, std::function<void()>>;
+
+// Random machine over numStates states spaced stride apart, with duplicate (source, event) pairs
+// whose guards fail every so often, and actions that record the transition taken.
+std::vector<Transition> makeRandomTransitions(std::size_t       numTransitions,
+                                              long              numStates,
+                                              long              stride,
+                                              const long &      tick,
+                                              std::vector<int> &log) {
+  std::mt19937                        mt{42};
+  std::uniform_int_distribution<long> state(0, numStates - 1);
+  std::uniform_int_distribution<int>  event(0, 3);
+
+  std::vector<Transition> transitions;
+  for (std::size_t i = 0; i < numTransitions; i++) {
+    const auto id = static_cast<int>(i);
+    transitions.push_back({state(mt) * stride,
+                           state(mt) * stride,
+                           event(mt),
+                           [&tick, id] { return (tick + id) % 5 != 0; },
+                           [&log, id] { log.push_back(id); }});
+  }
+  return transitions;
+}
+
+void expectSameRun(std::size_t numTransitions, long numStates, long stride) {
+  long             tick = 0;
+  std::vector<int> expected;
+  std::vector<int> actual;
+
+  auto reference = susml::vectorbased::StateMachine<Transition>{
+      0, makeRandomTransitions(numTransitions, numStates, stride, tick, expected)};
+  auto m = StateMachine<Transition>{
+      0, makeRandomTransitions(numTransitions, numStates, stride, tick, actual)};
+
+  std::mt19937                       mt{43};
+  std::uniform_int_distribution<int> event(0, 4); // 4 has no transitions
+  for (; tick < 2000; tick++) {
+    const auto e = event(mt);
+    reference.trigger(e);
+    m.trigger(e);
+    ASSERT_EQ(reference.currentState, m.currentState);
+  }
+  EXPECT_EQ(expected, actual);
+  EXPECT_EQ(reference.numUnhandledEvents, m.numUnhandledEvents);
+}
+
+TEST(ThreadedTests, behavesLikeVectorBased) {
+  expectSameRun(2000, 200, 1);
+  expectSameRun(2000, 200, 1000003); // sparse states
+}
+
+TEST(ThreadedTests, leavesOutShadowedCandidates) {
+  using Plain = susml::Transition<int, char>;
+
+  auto m = StateMachine<Plain>{0, {{0, 1, 'a'}, {0, 2, 'a'}, {0, 3, 'b'}, {1, 0, 'a'}}};
+  // the empty block, then a block of two candidates and one of one
+  ASSERT_EQ(3U, m.blocks.size());
+  EXPECT_EQ(2U, m.blocks[1].last - m.blocks[1].first);
+  EXPECT_EQ(1U, m.blocks[2].last - m.blocks[2].first);
+  EXPECT_NE(m.blocks[1].handler, m.blocks[2].handler); // each state has its own handler
+
+  m.trigger('a');
+  EXPECT_EQ(1, m.currentState);
+  m.trigger('b');
+  EXPECT_EQ(1, m.currentState);
+  m.trigger('a');
+  m.trigger('b');
+  EXPECT_EQ(3, m.currentState);
+  m.trigger('a'); // state 3 has no transitions
+  EXPECT_EQ(2U, m.numUnhandledEvents);
+}
+
+TEST(ThreadedTests, passesPayload) {
+  using Guard      = bool (*)(const int &);
+  using Action     = std::function<void(const int &)>;
+  using Transition = susml::Transition<int, int, Guard, Action, int>;
+
+  int  sum = 0;
+  auto add = [&](const int &value) { sum += value; };
+  auto m   = StateMachine<Transition>{
+      0,
+      {{0, 1, 0, [](const int &value) { return value > 10; }, add},
+       {0, 0, 0, [](const int &value) { return value > 0; }, add},
+       {1, 0, 0, [](const int &) { return true; }, add}}};
+
+  m.trigger(0, 5);
+  EXPECT_EQ(0, m.currentState);
+  m.trigger(0, -1);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+  m.trigger(0, 20);
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(0, 3);
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(28, sum);
+}
+
+TEST(ThreadedTests, sharesHandlersBeyondNumSites) {
+  using Plain = susml::Transition<int, int>;
+
+  std::vector<Plain> transitions;
+  for (int s = 0; s < 5; s++) {
+    transitions.push_back({s, (s + 1) % 5, 0});
+  }
+  auto m = StateMachine<Plain, 2>{0, transitions};
+  ASSERT_EQ(6U, m.blocks.size());
+  EXPECT_NE(m.blocks[1].handler, m.blocks[2].handler);
+  EXPECT_EQ(m.blocks[1].handler, m.blocks[3].handler);
+  EXPECT_EQ(m.blocks[2].handler, m.blocks[4].handler);
+
+  for (int i = 0; i < 7; i++) {
+    m.trigger(0);
+  }
+  EXPECT_EQ(2, m.currentState);
+}
+
+TEST(ThreadedTests, manyCandidatesDoNotGrowTheStack) {
+  using Plain = susml::Transition<int, int>;
+
+  // without optimizations, a chain of calls per candidate would take a frame per candidate
+  std::vector<Plain> transitions;
+  for (int e = 0; e < 10000; e++) {
+    transitions.push_back({0, 1, e});
+  }
+  auto m = StateMachine<Plain>{0, transitions};
+  m.trigger(9999);
+  EXPECT_EQ(1, m.currentState);
+}
@@ -0,0 +1,85 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "factory.hpp"
+#include "timed.hpp"
+
+using namespace std::chrono_literals;
+
+enum class State { idle, connecting, connected };
+enum class Event { connect, ack, close };
+
+using Clock = susml::timed::ManualClock;
+using Wheel = susml::timed::TimerWheel<Clock>;
+
+auto makeStateMachine(Wheel &wheel, std::size_t &numTimeouts) {
+  using namespace susml::factory;
+
+  std::vector transitions = {From(State::idle).To(State::connecting).On(Event::connect).make(),
+                             From(State::connecting).To(State::connected).On(Event::ack).make(),
+                             From(State::connected).To(State::idle).On(Event::close).make()};
+
+  std::vector timeouts = {From(State::connecting)
+                              .To(State::idle)
+                              .After(30s)
+                              .Do(std::function([&] { numTimeouts++; }))
+                              .make(),
+                          From(State::connected).To(State::idle).After(300s).Do(std::function([] {
+                          })).make()};
+
+  return susml::timed::StateMachine<decltype(transitions)::value_type,
+                                    decltype(timeouts)::value_type,
+                                    Clock>{wheel, State::idle, transitions, timeouts};
+}
+
+// Every machine connects, most of them get acknowledged (cancelling and re-arming their timer),
+// the rest times out. Time moves in 1s steps, so the wheel also has to cascade.
+static void timedConnections(benchmark::State &s) {
+  Wheel       wheel{{}, 1ms};
+  std::size_t numTimeouts = 0;
+
+  std::vector<decltype(makeStateMachine(wheel, numTimeouts))> machines;
+  machines.reserve(s.range(0));
+  for (int i = 0; i < s.range(0); i++) {
+    machines.push_back(makeStateMachine(wheel, numTimeouts));
+  }
+
+  for (auto _ : s) {
+    for (std::size_t i = 0; i < machines.size(); i++) {
+      machines[i].trigger(Event::connect);
+      if (i % 8 != 0) { machines[i].trigger(Event::ack); }
+    }
+    for (int second = 0; second < 31; second++) {
+      wheel.clock.advance(1s);
+      wheel.poll();
+    }
+    for (auto &m : machines) {
+      m.trigger(Event::close);
+    }
+  }
+
+  s.counters["timeouts"] = numTimeouts;
+  s.SetItemsProcessed(s.iterations() * s.range(0));
+}
+
+BENCHMARK(timedConnections)
+    ->RangeMultiplier(8)
+    ->Range(1 << 10, 1 << 19)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,282 @@
+// This file is part of Still Untitled State Machine Library (SUSML).
+//    Copyright (C) 2021 A.P. van Zanten
+// SUSML is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// SUSML is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public License
+// along with SUSML. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gtest/gtest.h"
+
+#include "common.hpp"
+#include "factory.hpp"
+#include "timed.hpp"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+using namespace std::chrono_literals;
+using susml::timed::ManualClock;
+using susml::timed::TimerNode;
+using Wheel = susml::timed::TimerWheel<ManualClock>;
+
+TEST(TimerWheelTests, firesExactlyOnExpiry) {
+  Wheel wheel{{}, 1ms};
+
+  const std::vector<std::uint64_t> delays = {1, 2, 63, 64, 65, 4095, 4096, 4097, 300000};
+
+  std::vector<std::uint64_t> firedAt(delays.size(), 0);
+  struct Context {
+    Wheel *                     wheel;
+    std::vector<std::uint64_t> *firedAt;
+    std::size_t                 index;
+  };
+  std::vector<Context>   contexts;
+  std::vector<TimerNode> nodes;
+  contexts.reserve(delays.size());
+  nodes.reserve(delays.size());
+  for (std::size_t i = 0; i < delays.size(); i++) {
+    contexts.push_back({&wheel, &firedAt, i});
+    nodes.emplace_back(
+        [](void *owner) {
+          auto &c                = *static_cast<Context *>(owner);
+          (*c.firedAt)[c.index] = c.wheel->currentTick;
+        },
+        &contexts[i]);
+  }
+
+  wheel.advanceTo(10); // start at an offset, so slots are not aligned with the delays
+  for (std::size_t i = 0; i < delays.size(); i++) {
+    wheel.arm(nodes[i], delays[i]);
+  }
+  EXPECT_EQ(delays.size(), wheel.numArmed);
+
+  wheel.advanceTo(400000);
+  for (std::size_t i = 0; i < delays.size(); i++) {
+    EXPECT_EQ(10 + delays[i], firedAt[i]) << "delay " << delays[i];
+  }
+  EXPECT_EQ(0, wheel.numArmed);
+}
+
+TEST(TimerWheelTests, cancelledTimersDoNotFire) {
+  Wheel wheel{{}, 1ms};
+
+  int       fired = 0;
+  TimerNode a{[](void *owner) { (*static_cast<int *>(owner))++; }, &fired};
+  TimerNode b{[](void *owner) { (*static_cast<int *>(owner))++; }, &fired};
+
+  wheel.arm(a, 100);
+  wheel.arm(b, 5000);
+  wheel.cancel(b);
+  EXPECT_FALSE(b.isArmed());
+  EXPECT_EQ(1, wheel.numArmed);
+
+  wheel.advanceTo(10000);
+  EXPECT_EQ(1, fired);
+}
+
+TEST(TimerWheelTests, pollFollowsInjectedClock) {
+  Wheel wheel{{}, 10ms};
+
+  int       fired = 0;
+  TimerNode node{[](void *owner) { (*static_cast<int *>(owner))++; }, &fired};
+  wheel.arm(node, wheel.toTicks(95ms)); // rounds up to 10 ticks
+
+  wheel.clock.advance(99ms);
+  wheel.poll();
+  EXPECT_EQ(0, fired);
+
+  wheel.clock.advance(1ms);
+  wheel.poll();
+  EXPECT_EQ(1, fired);
+}
+
+namespace Connection {
+enum class State { idle, connecting, connected };
+enum class Event { connect, ack, close };
+
+struct Fixture : public ::testing::Test {
+  Wheel wheel{{}, 1ms};
+  int   numTimeouts   = 0;
+  int   numKeepAlives = 0;
+
+  auto makeStateMachine() {
+    using namespace susml::factory;
+    using Action = std::function<void()>;
+
+    std::vector transitions = {
+        From(State::idle).To(State::connecting).On(Event::connect).Do(Action([] {})).make(),
+        From(State::connecting).To(State::connected).On(Event::ack).Do(Action([] {})).make(),
+        From(State::connected).To(State::idle).On(Event::close).Do(Action([] {})).make()};
+
+    std::vector timeouts = {From(State::connecting)
+                                .To(State::idle)
+                                .After(30s)
+                                .Do(Action([this] { numTimeouts++; }))
+                                .make(),
+                            From(State::connected)
+                                .To(State::connected)
+                                .After(10s)
+                                .Do(Action([this] { numKeepAlives++; }))
+                                .make()};
+
+    return susml::timed::StateMachine<decltype(transitions)::value_type,
+                                      decltype(timeouts)::value_type,
+                                      ManualClock>{wheel, State::idle, transitions, timeouts};
+  }
+
+  void advance(std::chrono::milliseconds delta) {
+    wheel.clock.advance(delta);
+    wheel.poll();
+  }
+};
+} // namespace Connection
+
+using ConnectionFixture = Connection::Fixture;
+
+TEST_F(ConnectionFixture, timeoutFiresAfterDelay) {
+  using Connection::Event;
+  using Connection::State;
+
+  auto m = makeStateMachine();
+  EXPECT_FALSE(m.timer.isArmed());
+
+  m.trigger(Event::connect);
+  EXPECT_TRUE(m.timer.isArmed());
+
+  advance(29999ms);
+  EXPECT_EQ(State::connecting, m.currentState);
+
+  advance(1ms);
+  EXPECT_EQ(State::idle, m.currentState);
+  EXPECT_EQ(1, numTimeouts);
+  EXPECT_FALSE(m.timer.isArmed());
+}
+
+TEST_F(ConnectionFixture, timeoutIsCancelledWhenStateIsLeft) {
+  using Connection::Event;
+  using Connection::State;
+
+  auto m = makeStateMachine();
+
+  m.trigger(Event::connect);
+  advance(20s);
+  m.trigger(Event::ack);
+  EXPECT_EQ(State::connected, m.currentState);
+
+  advance(15s);
+  EXPECT_EQ(0, numTimeouts);
+  EXPECT_EQ(1, numKeepAlives);
+
+  // self-loop timeouts re-arm
+  advance(24s);
+  EXPECT_EQ(3, numKeepAlives);
+
+  m.trigger(Event::close);
+  EXPECT_FALSE(m.timer.isArmed());
+  advance(100s);
+  EXPECT_EQ(3, numKeepAlives);
+  EXPECT_EQ(0, numTimeouts);
+}
+
+TEST_F(ConnectionFixture, timeInStateCountsFromTheClockNotTheLastPoll) {
+  using Connection::Event;
+  using Connection::State;
+
+  auto m = makeStateMachine();
+
+  wheel.clock.advance(60s); // without polling, so the wheel lags behind the clock
+  m.trigger(Event::connect);
+  advance(1ms);
+  EXPECT_EQ(State::connecting, m.currentState);
+  advance(29998ms);
+  EXPECT_EQ(State::connecting, m.currentState);
+  advance(1ms);
+  EXPECT_EQ(State::idle, m.currentState);
+  EXPECT_EQ(1, numTimeouts);
+}
+
+TEST_F(ConnectionFixture, selfTransitionsRestartTimeouts) {
+  using namespace susml::factory;
+  using Action = std::function<void()>;
+  enum class State { waiting, expired };
+  enum class Event { poke };
+
+  std::vector transitions = {
+      From(State::waiting).To(State::waiting).On(Event::poke).Do(Action([] {})).make()};
+  std::vector timeouts = {
+      From(State::waiting).To(State::expired).After(10s).Do(Action([] {})).make()};
+  susml::timed::StateMachine<decltype(transitions)::value_type,
+                             decltype(timeouts)::value_type,
+                             ManualClock>
+      m{wheel, State::waiting, transitions, timeouts};
+
+  advance(8s);
+  m.trigger(Event::poke);
+  advance(8s);
+  EXPECT_EQ(State::waiting, m.currentState);
+  advance(2s);
+  EXPECT_EQ(State::expired, m.currentState);
+}
+
+TEST_F(ConnectionFixture, manyInstancesShareWheel) {
+  using Connection::Event;
+  using Connection::State;
+
+  std::vector<decltype(makeStateMachine())> machines;
+  for (int i = 0; i < 100; i++) {
+    machines.push_back(makeStateMachine()); // reallocations move armed timers along
+    machines.back().trigger(Event::connect);
+    advance(100ms);
+  }
+  EXPECT_EQ(100, wheel.numArmed);
+
+  for (std::size_t i = 0; i < machines.size(); i += 2) {
+    machines[i].trigger(Event::ack);
+  }
+
+  advance(30s);
+  EXPECT_EQ(50, numTimeouts);
+  for (std::size_t i = 0; i < machines.size(); i++) {
+    EXPECT_EQ((i % 2 == 0) ? State::connected : State::idle, machines[i].currentState);
+  }
+}
+
+TEST(TimedStateMachineTests, guardedTimeoutsFallThroughToLongerDelays) {
+  using namespace susml::factory;
+  using Guard = std::function<bool()>;
+
+  enum class State { waiting, early, late };
+
+  Wheel wheel{{}, 1ms};
+  bool  ready = false;
+
+  using Transition = susml::Transition<State, int>;
+  std::vector timeouts = {
+      From(State::waiting).To(State::early).After(1s).If(Guard([&] { return ready; })).make(),
+      From(State::waiting).To(State::late).After(5s).If(Guard([] { return true; })).make()};
+
+  susml::timed::StateMachine<Transition, decltype(timeouts)::value_type, ManualClock> m{
+      wheel, State::waiting, {}, timeouts};
+
+  wheel.advanceTo(1000);
+  EXPECT_EQ(State::waiting, m.currentState);
+  EXPECT_TRUE(m.timer.isArmed());
+
+  ready = true; // too late, the 1s timeout has already been evaluated
+  wheel.advanceTo(4999);
+  EXPECT_EQ(State::waiting, m.currentState);
+  wheel.advanceTo(5000);
+  EXPECT_EQ(State::late, m.currentState);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -491,6 +491,46 @@ TEST_F(EncoderGuardBasedFixture, halfwayCounterClockwise) {
   EXPECT_EQ(0, delta);
 }
 
+TEST(PayloadTests, guardsAndActionsTakeThePayload) {
+  using EncoderGuardBased::Event;
+  using EncoderGuardBased::State;
+  using EncoderGuardBased::Update;
+
+  int  delta = 0;
+  auto Is    = [](bool desiredA, bool desiredB) {
+    return [desiredA, desiredB](const Update &u) {
+      return u.newA == desiredA && u.newB == desiredB;
+    };
+  };
+  auto Count = [&](int step) { return [&delta, step](const Update &) { delta += step; }; };
+
+  using Guard       = decltype(Is(false, false));
+  using Action      = decltype(Count(1));
+  using Transition  = susml::Transition<State, Event, Guard, Action, Update>;
+  using Passthrough = susml::Transition<State, Event>; // takes no payload
+
+  auto transitions = std::make_tuple(
+      Transition(State::idle, State::clockwise1, Event::update, Is(false, true), Count(0)),
+      Transition(State::clockwise1, State::clockwise2, Event::update, Is(true, true), Count(0)),
+      Transition(State::clockwise2, State::clockwise3, Event::update, Is(true, false), Count(0)),
+      Transition(State::clockwise3, State::idle, Event::update, Is(false, false), Count(1)),
+      Passthrough(State::counterclockwise1, State::idle, Event::update));
+  auto m = StateMachine<State, Event, decltype(transitions)>(State::idle, transitions);
+
+  m.trigger(Event::update, Update{false, true});
+  m.trigger(Event::update, Update{false, true}); // no change, no transition
+  EXPECT_EQ(State::clockwise1, m.currentState);
+  m.trigger(Event::update, Update{true, true});
+  m.trigger(Event::update, Update{true, false});
+  m.trigger(Event::update, Update{false, false});
+  EXPECT_EQ(State::idle, m.currentState);
+  EXPECT_EQ(1, delta);
+
+  m.currentState = State::counterclockwise1;
+  m.trigger(Event::update, Update{});
+  EXPECT_EQ(State::idle, m.currentState);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -20,6 +20,7 @@
 #include <array>
 #include <functional>
 #include <iostream>
+#include <random>
 #include <vector>
 
 using susml::vectorbased::StateMachine;
@@ -320,7 +321,7 @@ auto makeStateMachine(int &delta, const bool &a, const bool &b) {
 
   auto Fn  = [](auto e) { return std::function(e); };
   auto And = [&](bool desiredA, bool desiredB) {
-    return Fn([&] { return (a == desiredA && b == desiredB); });
+    return Fn([&a, &b, desiredA, desiredB] { return (a == desiredA && b == desiredB); });
   };
   auto NoAction = Fn([] {});
 
@@ -509,6 +510,315 @@ TEST_F(EncoderGuardBasedFixture, halfwayCounterClockwise) {
   EXPECT_EQ(0, delta);
 }
 
+TEST(EventMaskTests, rejectsUnhandledEvents) {
+  enum class State { off, on, broken };
+  enum class Event { turnOn, turnOff, kick };
+
+  using Transition = susml::Transition<State, Event>;
+
+  auto m = StateMachine<Transition>{State::off,
+                                    {{State::off, State::on, Event::turnOn},
+                                     {State::on, State::off, Event::turnOff},
+                                     {State::on, State::broken, Event::kick}}};
+
+  ASSERT_TRUE(m.acceptedEvents.isBuilt());
+  EXPECT_TRUE(m.acceptedEvents.accepts(State::off, Event::turnOn));
+  EXPECT_FALSE(m.acceptedEvents.accepts(State::off, Event::turnOff));
+  EXPECT_FALSE(m.acceptedEvents.accepts(State::off, Event::kick));
+  EXPECT_TRUE(m.acceptedEvents.accepts(State::on, Event::turnOff));
+  EXPECT_TRUE(m.acceptedEvents.accepts(State::on, Event::kick));
+  EXPECT_FALSE(m.acceptedEvents.accepts(State::broken, Event::turnOn));
+
+  m.trigger(Event::turnOff);
+  m.trigger(Event::kick);
+  EXPECT_EQ(State::off, m.currentState);
+  EXPECT_EQ(2, m.numUnhandledEvents);
+
+  m.trigger(Event::turnOn);
+  m.trigger(Event::kick);
+  EXPECT_EQ(State::broken, m.currentState);
+  EXPECT_EQ(2, m.numUnhandledEvents);
+
+  m.trigger(Event::turnOn);
+  m.trigger(Event::turnOff);
+  EXPECT_EQ(State::broken, m.currentState);
+  EXPECT_EQ(4, m.numUnhandledEvents);
+}
+
+TEST(EventMaskTests, countsGuardRejectionsAsUnhandled) {
+  using Transition = susml::Transition<int, int, std::function<bool()>>;
+
+  bool allow = false;
+  auto m     = StateMachine<Transition>{0, {{0, 1, 7, [&] { return allow; }}}};
+
+  m.trigger(7);
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+
+  allow = true;
+  m.trigger(7);
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+TEST(EventMaskTests, sparseValuesFallBackToSearch) {
+  using Transition = susml::Transition<std::size_t, int>;
+
+  constexpr std::size_t far = std::size_t{1} << 40U;
+
+  auto m = StateMachine<Transition>{0, {{0, far, -1}, {far, 0, 1}}};
+
+  EXPECT_FALSE(m.acceptedEvents.isBuilt());
+
+  m.trigger(-1);
+  EXPECT_EQ(far, m.currentState);
+  m.trigger(-1);
+  EXPECT_EQ(far, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+  m.trigger(1);
+  EXPECT_EQ(0, m.currentState);
+}
+
+// adds to a counter once per call, or many times at once
+struct Add {
+  std::size_t *counter = nullptr;
+  std::size_t  amount  = 0;
+  std::size_t *calls   = nullptr;
+
+  void operator()() const { (*this)(1); }
+  void operator()(std::size_t times) const {
+    *counter += amount * times;
+    (*calls)++;
+  }
+};
+
+TEST(FastForwardTests, matchesRepeatedTriggers) {
+  using Transition = susml::Transition<int, char, susml::NoneType, Add>;
+
+  std::size_t counterOnce    = 0;
+  std::size_t counterBatched = 0;
+  std::size_t callsOnce      = 0;
+  std::size_t callsBatched   = 0;
+
+  // a path 0 -> 1 -> 2 leading into the cycle 2 -> 3 -> 4 -> 5 -> 2, and 6 without transitions
+  auto makeTransitions = [](std::size_t &counter, std::size_t &calls) {
+    std::vector<Transition> transitions;
+    for (int s = 0; s < 5; s++) {
+      transitions.push_back({s, s + 1, 'x', {}, {&counter, std::size_t(1) << s, &calls}});
+    }
+    transitions.push_back({5, 2, 'x', {}, {&counter, 100, &calls}});
+    transitions.push_back({6, 0, 'y', {}, {&counter, 1000, &calls}});
+    return transitions;
+  };
+
+  for (const int start : {0, 3, 6}) {
+    for (const std::size_t count : {0, 1, 2, 3, 7, 8, 1001}) {
+      auto once    = StateMachine<Transition>{start, makeTransitions(counterOnce, callsOnce)};
+      auto batched = StateMachine<Transition>{start, makeTransitions(counterBatched, callsBatched)};
+
+      for (std::size_t n = 0; n < count; n++) {
+        once.trigger('x');
+      }
+      batched.triggerRepeatedly('x', count);
+
+      ASSERT_EQ(once.currentState, batched.currentState);
+      ASSERT_EQ(counterOnce, counterBatched);
+      ASSERT_EQ(once.numUnhandledEvents, batched.numUnhandledEvents);
+    }
+  }
+  EXPECT_LT(callsBatched * 10, callsOnce);
+}
+
+TEST(FastForwardTests, reportsTimesTaken) {
+  using Transition = susml::Transition<int, int>;
+
+  auto m = StateMachine<Transition>{0, {{0, 1, 0}, {1, 2, 0}, {2, 0, 0}}};
+
+  std::vector<std::size_t> times(3, 0);
+  m.triggerRepeatedly(0, 1000000, [&](Transition &t, std::size_t n) { times[t.source] += n; });
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ((std::vector<std::size_t>{333334, 333333, 333333}), times);
+}
+
+TEST(FastForwardTests, guardsAreEvaluatedEveryTime) {
+  using Transition = susml::Transition<int, int, std::function<bool()>>;
+
+  int  numChecks = 0;
+  auto Even      = [&] { return (numChecks++ % 2) == 0; };
+
+  auto m = StateMachine<Transition>{0, {{0, 1, 0, Even}, {1, 0, 0, Even}}};
+  m.triggerRepeatedly(0, 10);
+  EXPECT_EQ(10, numChecks);
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(5, m.numUnhandledEvents);
+}
+
+TEST(PayloadTests, guardsAndActionsTakeThePayload) {
+  using namespace susml::factory;
+
+  struct Reading {
+    int value;
+  };
+  using Guard      = std::function<bool(const Reading &)>;
+  using Action     = std::function<void(const Reading &)>;
+  using Transition = susml::Transition<int, int, Guard, Action, Reading>;
+
+  int  last     = 0;
+  auto Above    = [](int min) { return Guard([=](const Reading &r) { return r.value > min; }); };
+  auto Negative = Guard([](const Reading &r) { return r.value < 0; });
+  auto Store    = Action([&](const Reading &r) { last = r.value; });
+
+  auto m = StateMachine<Transition>{0,
+                                    {From(0).To(1).On(0).If(Above(10)).Do(Store).make<Reading>(),
+                                     From(1).To(0).On(0).If(Negative).Do(Store).make<Reading>()}};
+
+  m.trigger(0, Reading{5});
+  EXPECT_EQ(0, m.currentState);
+  m.trigger(0, Reading{15});
+  EXPECT_EQ(1, m.currentState);
+  EXPECT_EQ(15, last);
+  m.trigger(0, Reading{-3});
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(-3, last);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+}
+
+TEST(PayloadTests, integralPayloadIsNotACount) {
+  using Guard      = std::function<bool(const std::size_t &)>;
+  using Action     = std::function<void(const std::size_t &)>;
+  using Transition = susml::Transition<int, int, Guard, Action, std::size_t>;
+
+  std::size_t sum     = 0;
+  auto        IsSmall = Guard([](const std::size_t &value) { return value < 10; });
+  auto        Add     = Action([&](const std::size_t &value) { sum += value; });
+
+  auto m = StateMachine<Transition>{0, {{0, 1, 0, IsSmall, Add}, {1, 0, 0, IsSmall, Add}}};
+  m.trigger(0, std::size_t{3});
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(0, 20); // an int payload, taken as payload too
+  EXPECT_EQ(1, m.currentState);
+  m.trigger(0, 4);
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(7U, sum);
+  EXPECT_EQ(1U, m.numUnhandledEvents);
+}
+
+TEST(MutationTests, addAndRemoveTransitions) {
+  using Transition = susml::Transition<int, int>;
+
+  auto m = StateMachine<Transition>{0, {{0, 1, 0}, {1, 0, 0}}};
+  ASSERT_TRUE(m.acceptedEvents.isBuilt());
+
+  // a feature that adds a shortcut, with a higher priority than a later transition
+  const auto shortcut = m.addTransition({0, 2, 1});
+  const auto fallback = m.addTransition({0, 1, 1});
+  EXPECT_EQ(2U, shortcut);
+  m.trigger(1);
+  EXPECT_EQ(2, m.currentState);
+
+  m.currentState = 0;
+  EXPECT_TRUE(m.removeTransition(shortcut));
+  EXPECT_FALSE(m.removeTransition(shortcut));
+  m.trigger(1);
+  EXPECT_EQ(1, m.currentState);
+
+  // once the last transition on an event is removed, the event is rejected by the mask again
+  m.currentState = 0;
+  EXPECT_TRUE(m.removeTransition(fallback));
+  EXPECT_FALSE(m.acceptedEvents.accepts(0, 1));
+  m.trigger(1);
+  EXPECT_EQ(0, m.currentState);
+  EXPECT_EQ(1, m.numUnhandledEvents);
+
+  // removed transitions are erased once they are a quarter of them, ids stay the same
+  EXPECT_TRUE(m.removeTransition(0));
+  EXPECT_EQ(1U, m.transitions.size());
+  EXPECT_EQ(0U, m.numRemoved);
+  EXPECT_EQ(std::vector<std::size_t>{1}, m.ids);
+  EXPECT_TRUE(m.removeTransition(1));
+  EXPECT_TRUE(m.transitions.empty());
+}
+
+TEST(MutationTests, addingBeyondTheMaskRebuildsIt) {
+  using Transition = susml::Transition<int, int>;
+
+  auto m = StateMachine<Transition>{0, {{0, 1, 0}, {1, 0, 0}}};
+  EXPECT_TRUE(m.removeTransition(1));
+  m.addTransition({5, 0, 100});
+  EXPECT_TRUE(m.acceptedEvents.isBuilt());
+  EXPECT_EQ(2U, m.transitions.size()); // rebuilding compacts first
+
+  m.trigger(0);
+  m.trigger(0);
+  EXPECT_EQ(1, m.currentState);
+  m.currentState = 5;
+  m.trigger(100);
+  EXPECT_EQ(0, m.currentState);
+}
+
+TEST(MutationTests, sourceIndexFollowsMutations) {
+  using Transition = susml::Transition<int, int, std::function<bool()>>;
+
+  int  tick    = 0;
+  auto OddTick = [&] { return tick % 2 == 1; };
+  auto Always  = [] { return true; };
+  auto m = StateMachine<Transition>{0, {{0, 1, 0, OddTick}, {0, 2, 0, Always}, {1, 0, 0, Always}}};
+  EXPECT_TRUE(m.bySource.empty()); // built on the first mutation
+
+  // transitions kept next to the machine by id, in order of priority, as the reference
+  std::vector<std::pair<std::size_t, Transition>> live = {
+      {0, m.transitions[0]}, {1, m.transitions[1]}, {2, m.transitions[2]}};
+  std::mt19937                       mt{42};
+  std::uniform_int_distribution<int> state(0, 9);
+  for (; tick < 2000; tick++) {
+    if (tick % 3 == 0 || live.empty()) {
+      Transition t{state(mt), state(mt), state(mt) % 2, OddTick};
+      if (tick % 4 == 0) { t.guard = Always; }
+      live.emplace_back(m.addTransition(t), t);
+    } else if (tick % 3 == 1) {
+      const auto victim = static_cast<std::size_t>(state(mt)) % live.size();
+      EXPECT_TRUE(m.removeTransition(live[victim].first));
+      live.erase(live.begin() + static_cast<std::ptrdiff_t>(victim));
+    }
+    ASSERT_FALSE(m.bySource.empty());
+
+    std::vector<Transition> transitions;
+    for (const auto &entry : live) {
+      transitions.push_back(entry.second);
+    }
+    auto      reference = StateMachine<Transition>{m.currentState, transitions};
+    const int event     = state(mt) % 2;
+    reference.trigger(event);
+    m.trigger(event);
+    ASSERT_EQ(reference.currentState, m.currentState);
+  }
+}
+
+TEST(MutationTests, removedTransitionsAreNeverTaken) {
+  using Transition = susml::Transition<int, int, std::function<bool()>, std::function<void()>>;
+
+  int  numGuardCalls  = 0;
+  int  numActionCalls = 0;
+  auto guard          = [&] {
+    numGuardCalls++;
+    return true;
+  };
+  auto action = [&] { numActionCalls++; };
+
+  auto m = StateMachine<Transition>{0,
+                                    {{0, 0, 0, guard, action},
+                                     {0, 0, 0, guard, action},
+                                     {0, 0, 0, guard, action},
+                                     {0, 0, 0, guard, action},
+                                     {0, 0, 0, guard, action}}};
+  EXPECT_TRUE(m.removeTransition(0));
+  m.trigger(0);
+  m.triggerRepeatedly(0, 5);
+  EXPECT_EQ(6, numGuardCalls);
+  EXPECT_EQ(6, numActionCalls);
+  EXPECT_EQ(1U, m.numRemoved);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
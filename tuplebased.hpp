@@ -28,8 +28,8 @@ namespace validate {
 template <typename>
 struct IsTransitionTypeImpl : std::false_type {};
 
-template <typename StateT, typename EventT, typename GuardT, typename Actions>
-struct IsTransitionTypeImpl<Transition<StateT, EventT, GuardT, Actions>> : std::true_type {};
+template <typename... Types>
+struct IsTransitionTypeImpl<Transition<Types...>> : std::true_type {};
 
 template <typename T>
 constexpr bool isTransitionType() {
@@ -83,37 +83,49 @@ struct StateMachine {
   constexpr StateMachine(const State &initialState, const TransitionTuple &transitions)
       : currentState(initialState), transitions(transitions) {}
 
-  constexpr void trigger(const Event &event) {
+  constexpr void trigger(const Event &event) { trigger(event, NoneType{}); }
+
+  // Triggers an event that carries a payload. It is passed to the guards and actions of
+  // transitions with a Payload type, which must accept it; other transitions ignore it. As the
+  // payload is passed by reference into fully inlined guards, it need not be copied into variables
+  // captured by the guards first.
+  template <typename Payload>
+  constexpr void trigger(const Event &event, const Payload &payload) {
     constexpr std::size_t numTransitions = std::tuple_size<TransitionTuple>::value;
-    triggerImpl(event, std::make_index_sequence<numTransitions>());
+    triggerImpl(event, payload, std::make_index_sequence<numTransitions>());
   }
 
   // helper functions
-  template <typename Transition>
-  constexpr bool isTakeableTransition(const Transition &transition, const Event &event) {
+  template <typename Transition, typename Payload>
+  constexpr bool
+  isTakeableTransition(Transition &transition, const Event &event, const Payload &payload) {
     if constexpr (Transition::HasGuard()) {
-      return currentState == transition.source && event == transition.event && transition.guard();
+      return currentState == transition.source && event == transition.event &&
+             transition.isAllowed(payload);
     }
     if constexpr (!Transition::HasGuard()) {
       return currentState == transition.source && event == transition.event;
     }
   }
 
-  template <typename Transition>
-  constexpr bool takeTransitionIfAble(Transition &transition, const Event &event) {
+  template <typename Transition, typename Payload>
+  constexpr bool
+  takeTransitionIfAble(Transition &transition, const Event &event, const Payload &payload) {
 
-    const bool isTakeable = isTakeableTransition(transition, event);
+    const bool isTakeable = isTakeableTransition(transition, event, payload);
     if (isTakeable) {
-      if constexpr (Transition::HasAction()) { transition.action(); }
+      if constexpr (Transition::HasAction()) { transition.fire(payload); }
       currentState = transition.target;
       return true;
     }
     return false;
   }
 
-  template <std::size_t... Indices>
-  constexpr bool triggerImpl(const Event &event, const std::index_sequence<Indices...> &) {
-    return (... || takeTransitionIfAble(std::get<Indices>(transitions), event));
+  template <typename Payload, std::size_t... Indices>
+  constexpr bool triggerImpl(const Event &   event,
+                             const Payload & payload,
+                             const std::index_sequence<Indices...> &) {
+    return (... || takeTransitionIfAble(std::get<Indices>(transitions), event, payload));
   }
 };
 
@@ -15,32 +15,449 @@
 #define VECTORBASED_HPP
 
 #include "common.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace susml::vectorbased {
+
+namespace detail {
+template <typename T, typename = void>
+struct IsEqualityComparable : std::false_type {};
+
+template <typename T>
+struct IsEqualityComparable<
+    T,
+    std::void_t<decltype(static_cast<bool>(std::declval<const T &>() == std::declval<const T &>()))>>
+    : std::true_type {};
+
+// Assigns each transition an action class, such that transitions in the same class are known to
+// have the same action. Class 0 is reserved for "no action". Actions that cannot be compared
+// (e.g. std::function) each get their own class.
+template <typename Transition>
+std::vector<std::size_t> classifyActions(const std::vector<Transition> &transitions) {
+  using Action = typename Transition::Action;
+
+  std::vector<std::size_t> classes(transitions.size(), 0);
+  if constexpr (Transition::HasAction() && IsEqualityComparable<Action>::value) {
+    std::vector<std::size_t> representatives;
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      std::size_t c = 0;
+      while (c < representatives.size() &&
+             !(transitions[representatives[c]].action == transitions[i].action)) {
+        c++;
+      }
+      if (c == representatives.size()) { representatives.push_back(i); }
+      classes[i] = c + 1;
+    }
+  } else if constexpr (Transition::HasAction()) {
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      classes[i] = i + 1;
+    }
+  }
+  return classes;
+}
+
+// Fires an action the given number of times: in a single call if it accepts a repeat count (i.e.
+// it has an overload operator()(std::size_t)), one call at a time otherwise.
+template <typename Action>
+constexpr void fireRepeatedly(Action &action, std::size_t times) {
+  if constexpr (std::is_invocable<Action &, std::size_t>::value) {
+    action(times);
+  } else {
+    for (std::size_t i = 0; i < times; i++) {
+      action();
+    }
+  }
+}
+} // namespace detail
+
+// Per-state bitset of the events that have at least one transition from that state, such that an
+// unhandled event can be rejected without searching the transitions. Only available when both
+// State and Event are indexable, and only built when the table stays small relative to the
+// transitions themselves (i.e. state and event values are reasonably dense).
+template <typename State, typename Event>
+struct EventMask {
+  static constexpr bool IsAvailable() { return isIndexable<State>() && isIndexable<Event>(); }
+
+  static constexpr std::size_t BitsPerWord = 64;
+
+  std::size_t                numStates     = 0;
+  std::size_t                wordsPerState = 0;
+  std::vector<std::uint64_t> words;
+  std::vector<std::uint32_t> counts; // transitions per state and event, once tracked (see track())
+
+  EventMask() = default;
+
+  template <typename Transition>
+  explicit EventMask(const std::vector<Transition> &transitions) {
+    if constexpr (IsAvailable()) {
+      if (transitions.empty()) { return; }
+
+      std::size_t maxState = 0;
+      std::size_t maxEvent = 0;
+      for (const auto &t : transitions) {
+        maxState = std::max(maxState, toIndex(t.source));
+        maxEvent = std::max(maxEvent, toIndex(t.event));
+      }
+
+      // guard against overflow when values are huge (e.g. negative values cast to size_t)
+      const std::size_t maxWords = 8 * transitions.size() + 64;
+      if (maxState >= maxWords || maxEvent / BitsPerWord >= maxWords) { return; }
+      if ((maxState + 1) * (maxEvent / BitsPerWord + 1) > maxWords) { return; }
+
+      numStates     = maxState + 1;
+      wordsPerState = maxEvent / BitsPerWord + 1;
+      words.assign(numStates * wordsPerState, 0);
+      for (const auto &t : transitions) {
+        const auto e = toIndex(t.event);
+        words[toIndex(t.source) * wordsPerState + e / BitsPerWord] |= std::uint64_t{1}
+                                                                      << (e % BitsPerWord);
+      }
+    }
+  }
+
+  constexpr bool isBuilt() const { return !words.empty(); }
+
+  // Starts counting the given transitions per state and event, such that transitions can be added
+  // and removed without rebuilding the mask.
+  template <typename Transition>
+  void track(const std::vector<Transition> &transitions) {
+    if constexpr (IsAvailable()) {
+      if (!isBuilt()) { return; }
+      counts.assign(numStates * wordsPerState * BitsPerWord, 0);
+      for (const auto &t : transitions) {
+        counts[toIndex(t.source) * wordsPerState * BitsPerWord + toIndex(t.event)]++;
+      }
+    }
+  }
+
+  // Counts a transition that was added. Returns false if its state or event lies outside the
+  // table, in which case the mask has to be rebuilt.
+  bool add(const State &state, const Event &event) {
+    if constexpr (IsAvailable()) {
+      if (!isBuilt()) { return true; }
+      const auto s = toIndex(state);
+      const auto e = toIndex(event);
+      if (s >= numStates || e / BitsPerWord >= wordsPerState) { return false; }
+      counts[s * wordsPerState * BitsPerWord + e]++;
+      words[s * wordsPerState + e / BitsPerWord] |= std::uint64_t{1} << (e % BitsPerWord);
+    }
+    return true;
+  }
+
+  // Uncounts a transition that was removed, clearing its bit if it was the last one.
+  void remove(const State &state, const Event &event) {
+    if constexpr (IsAvailable()) {
+      if (!isBuilt()) { return; }
+      const auto s = toIndex(state);
+      const auto e = toIndex(event);
+      if (--counts[s * wordsPerState * BitsPerWord + e] == 0) {
+        words[s * wordsPerState + e / BitsPerWord] &= ~(std::uint64_t{1} << (e % BitsPerWord));
+      }
+    }
+  }
+
+  // Returns false only if there is definitely no transition for this state and event.
+  constexpr bool accepts(const State &state, const Event &event) const {
+    if constexpr (IsAvailable()) {
+      if (!isBuilt()) { return true; }
+      const auto s = toIndex(state);
+      const auto e = toIndex(event);
+      if (s >= numStates || e / BitsPerWord >= wordsPerState) { return false; }
+      return ((words[s * wordsPerState + e / BitsPerWord] >> (e % BitsPerWord)) & 1U) != 0;
+    }
+    return true;
+  }
+};
+
 template <typename TransitionT>
 struct StateMachine {
   using Transition = TransitionT;
   using State      = typename Transition::State;
   using Event      = typename Transition::Event;
+  using Payload    = typename Transition::Payload;
+
+  // identifies a transition across additions and removals of other transitions
+  using TransitionId = std::size_t;
 
   State                   currentState;
   std::vector<Transition> transitions;
+  EventMask<State, Event> acceptedEvents;
 
-  constexpr bool isTransitionTakeable(Transition &t, const Event &event) {
-    if constexpr (Transition::HasGuard()) {
-      return t.source == currentState && t.event == event && t.guard();
+  // Bookkeeping of addTransition() and removeTransition(), empty until the first of those: the id
+  // of each transition (ascending), and whether it was removed (a tombstone, until compacted).
+  std::vector<TransitionId> ids;
+  std::vector<bool>         isRemoved;
+  std::size_t               numRemoved = 0;
+  TransitionId              nextId     = 0;
+
+  // The transitions of each source state in order of priority, without the removed ones, kept
+  // from the first addTransition() or removeTransition() on, if states are integral or enums and
+  // dense enough (see buildSourceIndex()). Triggers then only search the current state's list.
+  std::vector<std::vector<std::size_t>> bySource;
+
+  // number of triggers that did not result in a transition being taken
+  std::size_t numUnhandledEvents = 0;
+
+  // NOTE: acceptedEvents is built from the transitions on construction, so transitions should
+  // only be modified afterwards through addTransition() and removeTransition(). The transitions
+  // are taken by value, so a vector that is passed as an rvalue is moved into the machine rather
+  // than copied. The initial transitions get ids 0 up to their number.
+  StateMachine(const State &initialState, std::vector<Transition> transitions)
+      : currentState(initialState),
+        transitions(std::move(transitions)),
+        acceptedEvents(this->transitions),
+        nextId(this->transitions.size()) {}
+
+  // Appends a transition, which then has the lowest priority of all transitions from its source
+  // on its event, and returns its id. Keeps acceptedEvents and bySource up to date in constant
+  // time, unless the transition's state or event lies outside their tables, which are then
+  // rebuilt.
+  TransitionId addTransition(Transition transition) {
+    startTracking();
+    const bool fits = acceptedEvents.add(transition.source, transition.event) &&
+                      addToSourceIndex(transition.source, transitions.size());
+    transitions.push_back(std::move(transition));
+    ids.push_back(nextId);
+    isRemoved.push_back(false);
+    if (!fits) {
+      compact();
+      acceptedEvents = EventMask<State, Event>(transitions);
+      acceptedEvents.track(transitions);
+      buildSourceIndex();
+    }
+    return nextId++;
+  }
+
+  // Removes a transition, returns false if there is no such transition (anymore). The transition
+  // is only marked as removed (and taken out of bySource, in time linear in the out-degree of its
+  // source), and the removed transitions are erased in one go once they make up a quarter of all
+  // transitions (or on compact()), so a removal takes amortized O(out-degree) time.
+  bool removeTransition(TransitionId id) {
+    startTracking();
+    const auto found = std::lower_bound(ids.begin(), ids.end(), id);
+    if (found == ids.end() || *found != id) { return false; }
+    const auto i = static_cast<std::size_t>(found - ids.begin());
+    if (isRemoved[i]) { return false; }
+
+    isRemoved[i] = true;
+    numRemoved++;
+    acceptedEvents.remove(transitions[i].source, transitions[i].event);
+    removeFromSourceIndex(transitions[i].source, i);
+    if (4 * numRemoved > transitions.size()) { compact(); }
+    return true;
+  }
+
+  // Erases the removed transitions, keeping the others in order. Other code that reads the
+  // transitions directly (e.g. minimize or parallel::run) should only do so after compacting.
+  void compact() {
+    if (numRemoved == 0) { return; }
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      if (isRemoved[i]) { continue; }
+      if (kept != i) {
+        transitions[kept] = std::move(transitions[i]);
+        ids[kept]         = ids[i];
+      }
+      kept++;
     }
-    if constexpr (!Transition::HasGuard()) { return t.source == currentState && t.event == event; }
+    transitions.erase(transitions.begin() + static_cast<std::ptrdiff_t>(kept), transitions.end());
+    ids.resize(kept);
+    isRemoved.assign(kept, false);
+    numRemoved = 0;
+    if (!bySource.empty()) { buildSourceIndex(); } // the remaining transitions moved
   }
 
   constexpr void trigger(const Event &event) {
-    for (auto &t : transitions) {
-      if (isTransitionTakeable(t, event)) {
-        if constexpr (Transition::HasAction()) { t.action(); }
-        currentState = t.target;
-        break;
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered with trigger(event, payload).");
+    trigger(event, Payload{});
+  }
+
+  // Triggers an event that carries a payload, which is passed to the guard and action.
+  constexpr void trigger(const Event &event, const Payload &payload) {
+    const auto i = find(currentState, event, payload);
+    if (i == NoTransition) {
+      numUnhandledEvents++;
+      return;
+    }
+    auto &t = transitions[i];
+    if constexpr (Transition::HasAction()) { t.fire(payload); }
+    currentState = t.target;
+  }
+
+  // Triggers the same event count times. For guardless machines, the states visited form a path
+  // that ends in a cycle, so rather than taking every step the machine jumps over all full rounds
+  // of the cycle at once, taking O(length of path and cycle) steps instead of O(count). The
+  // actions are then fired in a batch per transition (in order of the transitions rather than
+  // interleaved), see fireRepeatedly(). Machines with guards simply trigger count times.
+  // NOTE: this is not an overload of trigger(), as a count would be taken for an integral payload.
+  // Transitions with a payload carry a payload per event, so they cannot be triggered repeatedly.
+  void triggerRepeatedly(const Event &event, std::size_t count) {
+    triggerRepeatedly(event, count, [](Transition &t, std::size_t times) {
+      if constexpr (Transition::HasAction()) {
+        if (!isNull(t.action)) { detail::fireRepeatedly(t.action, times); }
+      }
+    });
+  }
+
+  // As above, but calls onTaken(transition, times) for every transition that is taken, rather than
+  // firing its action.
+  template <typename OnTaken>
+  void triggerRepeatedly(const Event &event, std::size_t count, OnTaken &&onTaken) {
+    static_assert(!Transition::HasPayload(),
+                  "Transitions with a payload must be triggered one by one with trigger().");
+    if constexpr (Transition::HasGuard()) {
+      for (std::size_t n = 0; n < count; n++) {
+        const auto i = find(currentState, event);
+        if (i == NoTransition) {
+          numUnhandledEvents++;
+          continue;
+        }
+        onTaken(transitions[i], 1);
+        currentState = transitions[i].target;
+      }
+    } else {
+      // find the length of the cycle (lambda) with Brent's algorithm, unless count runs out first
+      auto next = [&](const State &s) {
+        const auto i = find(s, event);
+        return (i == NoTransition) ? s : transitions[i].target;
+      };
+      std::size_t power    = 1;
+      std::size_t lambda   = 1;
+      std::size_t numSteps = 1;
+      State       tortoise = currentState;
+      State       hare     = next(currentState);
+      while (!(tortoise == hare) && numSteps < count) {
+        if (power == lambda) {
+          tortoise = hare;
+          power *= 2;
+          lambda = 0;
+        }
+        hare = next(hare);
+        lambda++;
+        numSteps++;
       }
+
+      std::vector<std::size_t> times(transitions.size() + 1, 0); // last one counts "unhandled"
+      auto step = [&](State &s, std::size_t n) {
+        const auto i = find(s, event);
+        times[(i == NoTransition) ? transitions.size() : i] += n;
+        if (i != NoTransition) { s = transitions[i].target; }
+      };
+
+      State       state     = currentState;
+      std::size_t remaining = count;
+      if (tortoise == hare) {
+        // walk the path up to the start of the cycle
+        hare = currentState;
+        for (std::size_t n = 0; n < lambda; n++) {
+          hare = next(hare);
+        }
+        while (!(state == hare) && remaining > 0) {
+          step(state, 1);
+          hare = next(hare);
+          remaining--;
+        }
+        // then go round the cycle as many times as fit in one go
+        const std::size_t rounds = remaining / lambda;
+        for (std::size_t n = 0; n < lambda && rounds > 0; n++) {
+          step(state, rounds);
+        }
+        remaining %= lambda;
+      }
+      while (remaining > 0) {
+        step(state, 1);
+        remaining--;
+      }
+
+      numUnhandledEvents += times.back();
+      for (std::size_t i = 0; i < transitions.size(); i++) {
+        if (times[i] != 0) { onTaken(transitions[i], times[i]); }
+      }
+      currentState = state;
+    }
+  }
+
+  // helper functions
+  static constexpr std::size_t NoTransition = static_cast<std::size_t>(-1);
+
+  // index of the first transition that can be taken from state on event, or NoTransition
+  std::size_t find(const State &state, const Event &event, const Payload &payload = {}) {
+    if (!acceptedEvents.accepts(state, event)) { return NoTransition; }
+    auto isTakeable = [&](Transition &t) {
+      if constexpr (Transition::HasGuard()) { return t.event == event && t.isAllowed(payload); }
+      return t.event == event;
+    };
+    if constexpr (isIndexable<State>()) {
+      if (!bySource.empty()) {
+        const auto s = toIndex(state);
+        if (s >= bySource.size()) { return NoTransition; }
+        for (const auto i : bySource[s]) {
+          if (isTakeable(transitions[i])) { return i; }
+        }
+        return NoTransition;
+      }
+    }
+    for (std::size_t i = 0; i < transitions.size(); i++) {
+      auto &t = transitions[i];
+      if (!(t.source == state) || isTombstone(i)) { continue; }
+      if (isTakeable(t)) { return i; }
+    }
+    return NoTransition;
+  }
+
+  constexpr bool isTombstone(std::size_t i) const { return numRemoved != 0 && isRemoved[i]; }
+
+  void startTracking() {
+    if (isRemoved.size() == transitions.size()) { return; }
+    ids.resize(transitions.size());
+    for (std::size_t i = 0; i < ids.size(); i++) {
+      ids[i] = i;
+    }
+    isRemoved.assign(transitions.size(), false);
+    acceptedEvents.track(transitions);
+    buildSourceIndex();
+  }
+
+  // Builds bySource from the transitions that are not removed, unless states are not integral or
+  // enums, or are too sparse for a list per state (like the indexed machine, up to 2n + 256).
+  void buildSourceIndex() {
+    bySource.clear();
+    if constexpr (isIndexable<State>()) {
+      std::size_t maxSource = 0;
+      for (const auto &t : transitions) {
+        maxSource = std::max(maxSource, toIndex(t.source));
+      }
+      if (maxSource >= 2 * transitions.size() + 256) { return; }
+      bySource.resize(maxSource + 1);
+      for (std::size_t i = 0; i < transitions.size(); i++) {
+        if (!isTombstone(i)) { bySource[toIndex(transitions[i].source)].push_back(i); }
+      }
+    }
+  }
+
+  // Appends transition i (the last one) to the list of its source. Returns false if the source
+  // lies too far outside bySource, in which case it has to be rebuilt.
+  bool addToSourceIndex(const State &source, std::size_t i) {
+    if constexpr (isIndexable<State>()) {
+      if (bySource.empty()) { return true; }
+      const auto s = toIndex(source);
+      if (s >= 2 * (transitions.size() + 1) + 256) { return false; }
+      if (s >= bySource.size()) { bySource.resize(s + 1); }
+      bySource[s].push_back(i);
+    }
+    return true;
+  }
+
+  void removeFromSourceIndex(const State &source, std::size_t i) {
+    if constexpr (isIndexable<State>()) {
+      if (bySource.empty()) { return; }
+      auto &list = bySource[toIndex(source)];
+      list.erase(std::find(list.begin(), list.end(), i));
     }
   }
 };